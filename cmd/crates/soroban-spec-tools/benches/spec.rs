@@ -0,0 +1,98 @@
+//! Benchmarks of reading contract specs and converting values to and from them, over the
+//! fixture contracts. Build the fixtures first with `make build-test-wasms`.
+
+use criterion::{black_box, criterion_group, criterion_main, BenchmarkId, Criterion};
+use soroban_spec_tools::Spec;
+use stellar_xdr::curr::{ScSpecEntry, ScSpecTypeDef, ScVal};
+
+const FIXTURES: [&str; 4] = ["test_token", "test_custom_types", "test_udt", "test_swap"];
+
+fn fixture(name: &str) -> Vec<u8> {
+    let path = std::path::Path::new(env!("CARGO_MANIFEST_DIR"))
+        .join("../../../target/wasm32-unknown-unknown/test-wasms")
+        .join(name)
+        .with_extension("wasm");
+    std::fs::read(&path).unwrap_or_else(|e| {
+        panic!(
+            "cannot read {}, build the fixtures with `make build-test-wasms`: {e}",
+            path.display()
+        )
+    })
+}
+
+/// An example argument for each function input in `spec`, as a string and as a value.
+fn arguments(spec: &Spec) -> Vec<(ScSpecTypeDef, String, ScVal)> {
+    spec.entries()
+        .unwrap_or_default()
+        .iter()
+        .filter_map(|entry| match entry {
+            ScSpecEntry::FunctionV0(f) => Some(f.inputs.iter()),
+            _ => None,
+        })
+        .flatten()
+        .filter_map(|input| {
+            let s = spec.example(&input.type_)?;
+            let val = spec.from_string(&s, &input.type_).ok()?;
+            Some((input.type_.clone(), s, val))
+        })
+        .collect()
+}
+
+fn from_wasm(c: &mut Criterion) {
+    let mut group = c.benchmark_group("from_wasm");
+    for name in FIXTURES {
+        let wasm = fixture(name);
+        group.bench_with_input(BenchmarkId::from_parameter(name), &wasm, |b, wasm| {
+            b.iter(|| Spec::from_wasm(black_box(wasm)).unwrap());
+        });
+    }
+    group.finish();
+}
+
+fn conversions(c: &mut Criterion) {
+    for name in FIXTURES {
+        let spec = Spec::from_wasm(&fixture(name)).unwrap();
+        let args = arguments(&spec);
+        let json = args
+            .iter()
+            .map(|(t, _, val)| serde_json::to_vec(&spec.xdr_to_json(val, t).unwrap()).unwrap())
+            .collect::<Vec<_>>();
+
+        let mut group = c.benchmark_group(name);
+        group.bench_function("from_string", |b| {
+            b.iter(|| {
+                for (t, s, _) in &args {
+                    black_box(spec.from_string(s, t).unwrap());
+                }
+            });
+        });
+        group.bench_function("from_json_slice", |b| {
+            b.iter(|| {
+                for ((t, _, _), json) in args.iter().zip(&json) {
+                    black_box(spec.from_json_slice(json, t).unwrap());
+                }
+            });
+        });
+        group.bench_function("xdr_to_json", |b| {
+            b.iter(|| {
+                for (t, _, val) in &args {
+                    black_box(spec.xdr_to_json(val, t).unwrap());
+                }
+            });
+        });
+        group.bench_function("to_json_writer", |b| {
+            let mut out = Vec::new();
+            b.iter(|| {
+                for (t, _, val) in &args {
+                    out.clear();
+                    spec.to_json_writer(&mut out, val, t).unwrap();
+                    black_box(&out);
+                }
+            });
+        });
+        group.finish();
+    }
+}
+
+criterion_group!(benches, from_wasm, conversions);
+criterion_main!(benches);
@@ -36,25 +36,157 @@ pub enum Error {
 
     #[error(transparent)]
     Parser(#[from] wasmparser::BinaryReaderError),
+    #[error("invalid wasm: {0}")]
+    InvalidWasm(&'static str),
 }
 
-impl Spec {
-    pub fn new(bytes: &[u8]) -> Result<Self, Error> {
-        let mut env_meta: Option<&[u8]> = None;
-        let mut meta: Option<&[u8]> = None;
-        let mut spec: Option<&[u8]> = None;
-        for payload in wasmparser::Parser::new(0).parse_all(bytes) {
-            let payload = payload?;
-            if let wasmparser::Payload::CustomSection(section) = payload {
-                let out = match section.name() {
-                    "contractenvmetav0" => &mut env_meta,
-                    "contractmetav0" => &mut meta,
-                    "contractspecv0" => &mut spec,
-                    _ => continue,
-                };
-                *out = Some(section.data());
+/// The contract custom sections of a wasm file, located without decoding them.
+///
+/// Use this instead of [`Spec::new`] when only some of the sections, or only some of the spec
+/// entries, are needed.
+#[derive(Default, Clone, Copy)]
+pub struct Sections<'a> {
+    pub env_meta: Option<&'a [u8]>,
+    pub meta: Option<&'a [u8]>,
+    pub spec: Option<&'a [u8]>,
+}
+
+impl<'a> Sections<'a> {
+    pub fn new(bytes: &'a [u8]) -> Result<Self, Error> {
+        let mut sections = Sections::default();
+        for section in custom_sections(bytes)? {
+            let (name, data) = section?;
+            let out = match name {
+                "contractenvmetav0" => &mut sections.env_meta,
+                "contractmetav0" => &mut sections.meta,
+                "contractspecv0" => &mut sections.spec,
+                _ => continue,
             };
+            *out = Some(data);
+        }
+        Ok(sections)
+    }
+
+    /// Decodes the spec entries one at a time, as they are iterated. Iteration ends after the
+    /// first entry that cannot be decoded, as the entries after it cannot be located.
+    pub fn spec_entries(&self) -> impl Iterator<Item = Result<ScSpecEntry, xdr::Error>> + 'a {
+        let spec = self.spec.unwrap_or_default();
+        let mut read = Limited::new(Cursor::new(spec), Limits::none());
+        let mut failed = false;
+        std::iter::from_fn(move || {
+            if failed || read.inner.position() >= spec.len() as u64 {
+                return None;
+            }
+            let entry = ScSpecEntry::read_xdr(&mut read);
+            failed = entry.is_err();
+            Some(entry)
+        })
+    }
+
+    /// The base64 XDR of each spec entry as a JSON array, as [`Spec::spec_as_json_array`] but
+    /// without decoding the other sections.
+    pub fn spec_as_json_array(&self) -> Result<String, Error> {
+        let spec = self
+            .spec_entries()
+            .map(|e| Ok(format!("\"{}\"", e?.to_xdr_base64(Limits::none())?)))
+            .collect::<Result<Vec<_>, Error>>()?
+            .join(",\n");
+        Ok(format!("[{spec}]"))
+    }
+}
+
+/// Iterates over the custom sections of a wasm module, as `(name, data)` pairs.
+///
+/// Only the section headers are read, every other section is skipped over using its length,
+/// so the cost does not depend on the size of the code.
+pub fn custom_sections(bytes: &[u8]) -> Result<CustomSections<'_>, Error> {
+    if !bytes.starts_with(&WASM_HEADER) {
+        return Err(Error::InvalidWasm("missing wasm header"));
+    }
+    Ok(CustomSections {
+        bytes,
+        offset: WASM_HEADER.len(),
+    })
+}
+
+/// The magic number and version that every wasm module starts with.
+const WASM_HEADER: [u8; 8] = [0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00];
+
+pub struct CustomSections<'a> {
+    bytes: &'a [u8],
+    offset: usize,
+}
+
+impl<'a> Iterator for CustomSections<'a> {
+    type Item = Result<(&'a str, &'a [u8]), Error>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        while self.offset < self.bytes.len() {
+            match self.section() {
+                Ok(Some(section)) => return Some(Ok(section)),
+                Ok(None) => {}
+                Err(e) => {
+                    self.offset = self.bytes.len();
+                    return Some(Err(e));
+                }
+            }
+        }
+        None
+    }
+}
+
+impl<'a> CustomSections<'a> {
+    /// Reads the section at the current offset, returning it only if it is a custom section.
+    fn section(&mut self) -> Result<Option<(&'a str, &'a [u8])>, Error> {
+        let id = self.bytes[self.offset];
+        self.offset += 1;
+        let size = read_u32(self.bytes, &mut self.offset)?;
+        let data = read_slice(self.bytes, &mut self.offset, size)?;
+        if id != 0 {
+            return Ok(None);
+        }
+        let mut offset = 0;
+        let name_len = read_u32(data, &mut offset)?;
+        let name = read_slice(data, &mut offset, name_len)?;
+        let name = std::str::from_utf8(name)
+            .map_err(|_| Error::InvalidWasm("custom section name is not utf-8"))?;
+        Ok(Some((name, &data[offset..])))
+    }
+}
+
+/// Reads an unsigned LEB128 encoded u32.
+fn read_u32(bytes: &[u8], offset: &mut usize) -> Result<u32, Error> {
+    let mut value = 0u32;
+    for shift in (0..32).step_by(7) {
+        let byte = *bytes
+            .get(*offset)
+            .ok_or(Error::InvalidWasm("unexpected end of file"))?;
+        *offset += 1;
+        if shift == 28 && byte > 0x0f {
+            return Err(Error::InvalidWasm("integer too large"));
+        }
+        value |= u32::from(byte & 0x7f) << shift;
+        if byte & 0x80 == 0 {
+            return Ok(value);
         }
+    }
+    Err(Error::InvalidWasm("integer too large"))
+}
+
+fn read_slice<'a>(bytes: &'a [u8], offset: &mut usize, len: u32) -> Result<&'a [u8], Error> {
+    let end = offset
+        .checked_add(len as usize)
+        .filter(|end| *end <= bytes.len())
+        .ok_or(Error::InvalidWasm("section extends past the end of file"))?;
+    let slice = &bytes[*offset..end];
+    *offset = end;
+    Ok(slice)
+}
+
+impl Spec {
+    pub fn new(bytes: &[u8]) -> Result<Self, Error> {
+        let sections = Sections::new(bytes)?;
+        let Sections { env_meta, meta, .. } = sections;
 
         let mut env_meta_base64 = None;
         let env_meta = if let Some(env_meta) = env_meta {
@@ -77,15 +209,8 @@ impl Spec {
             vec![]
         };
 
-        let mut spec_base64 = None;
-        let spec = if let Some(spec) = spec {
-            spec_base64 = Some(base64.encode(spec));
-            let cursor = Cursor::new(spec);
-            let mut read = Limited::new(cursor, Limits::none());
-            ScSpecEntry::read_xdr_iter(&mut read).collect::<Result<Vec<_>, xdr::Error>>()?
-        } else {
-            vec![]
-        };
+        let spec_base64 = sections.spec.map(|spec| base64.encode(spec));
+        let spec = sections.spec_entries().collect::<Result<Vec<_>, _>>()?;
 
         Ok(Spec {
             env_meta_base64,
@@ -276,3 +401,73 @@ fn format_name(lib: &StringM<80>, name: &StringM<60>) -> String {
         name.to_utf8_string_lossy()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn section(id: u8, data: &[u8]) -> Vec<u8> {
+        let mut section = vec![id, u8::try_from(data.len()).unwrap()];
+        section.extend_from_slice(data);
+        section
+    }
+
+    fn custom(name: &str, data: &[u8]) -> Vec<u8> {
+        let mut contents = vec![u8::try_from(name.len()).unwrap()];
+        contents.extend_from_slice(name.as_bytes());
+        contents.extend_from_slice(data);
+        section(0, &contents)
+    }
+
+    #[test]
+    fn custom_sections_skip_other_sections() {
+        let mut wasm = WASM_HEADER.to_vec();
+        wasm.extend(section(1, &[0x01, 0x60, 0x00, 0x00]));
+        wasm.extend(custom("contractmetav0", &[1, 2, 3]));
+        wasm.extend(section(10, &[0xff; 20]));
+        wasm.extend(custom("name", &[]));
+        let sections = custom_sections(&wasm)
+            .unwrap()
+            .collect::<Result<Vec<_>, _>>()
+            .unwrap();
+        assert_eq!(
+            sections,
+            [("contractmetav0", &[1u8, 2, 3][..]), ("name", &[][..])]
+        );
+
+        let found = Sections::new(&wasm).unwrap();
+        assert_eq!(found.meta, Some(&[1u8, 2, 3][..]));
+        assert!(found.spec.is_none());
+        assert_eq!(found.spec_entries().count(), 0);
+    }
+
+    #[test]
+    fn spec_entries_stop_after_an_error() {
+        let entry = ScSpecEntry::UdtEnumV0(ScSpecUdtEnumV0 {
+            doc: StringM::default(),
+            lib: StringM::default(),
+            name: "Kind".try_into().unwrap(),
+            cases: vec![].try_into().unwrap(),
+        });
+        let mut spec = entry.to_xdr(Limits::none()).unwrap();
+        spec.extend([0xff; 8]);
+        spec.extend(entry.to_xdr(Limits::none()).unwrap());
+        let sections = Sections {
+            spec: Some(&spec),
+            ..Sections::default()
+        };
+        let entries = sections.spec_entries().collect::<Vec<_>>();
+        assert_eq!(entries.len(), 2);
+        assert_eq!(entries[0].as_ref().unwrap(), &entry);
+        assert!(entries[1].is_err());
+    }
+
+    #[test]
+    fn custom_sections_reject_truncated_wasm() {
+        let mut wasm = WASM_HEADER.to_vec();
+        wasm.extend(custom("contractspecv0", &[0; 8]));
+        wasm.truncate(wasm.len() - 1);
+        assert!(Sections::new(&wasm).is_err());
+        assert!(Sections::new(&[]).is_err());
+    }
+}
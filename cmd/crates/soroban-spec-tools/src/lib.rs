@@ -1,5 +1,5 @@
 #![allow(clippy::missing_errors_doc, clippy::must_use_candidate)]
-use std::str::FromStr;
+use std::{collections::HashMap, str::FromStr};
 
 use itertools::Itertools;
 use serde_json::{json, Value};
@@ -14,6 +14,7 @@ use stellar_xdr::curr::{
 };
 
 pub mod contract;
+pub mod stream;
 pub mod utils;
 
 #[derive(thiserror::Error, Debug)]
@@ -66,7 +67,12 @@ pub enum Error {
 }
 
 #[derive(Default, Clone)]
-pub struct Spec(pub Option<Vec<ScSpecEntry>>);
+pub struct Spec {
+    entries: Option<Vec<ScSpecEntry>>,
+    /// Position of each entry in `entries` by name, so that functions and types referenced by
+    /// arguments are found without scanning every entry.
+    index: HashMap<Vec<u8>, usize>,
+}
 
 impl TryInto<Spec> for &[u8] {
     type Error = soroban_spec::read::FromWasmError;
@@ -79,7 +85,19 @@ impl TryInto<Spec> for &[u8] {
 
 impl Spec {
     pub fn new(entries: Vec<ScSpecEntry>) -> Self {
-        Self(Some(entries))
+        let mut index = HashMap::with_capacity(entries.len());
+        for (i, entry) in entries.iter().enumerate() {
+            // The first of entries sharing a name is the one found, as when they were scanned.
+            index.entry(entry_name(entry).to_vec()).or_insert(i);
+        }
+        Self {
+            entries: Some(entries),
+            index,
+        }
+    }
+
+    pub fn entries(&self) -> Option<&[ScSpecEntry]> {
+        self.entries.as_deref()
     }
 
     pub fn from_wasm(wasm: &[u8]) -> Result<Spec, Error> {
@@ -96,7 +114,7 @@ impl Spec {
 impl Spec {
     /// # Errors
     /// Could fail to find User Defined Type
-    pub fn doc(&self, name: &str, type_: &ScType) -> Result<Option<&'static str>, Error> {
+    pub fn doc(&self, name: &str, type_: &ScType) -> Result<Option<String>, Error> {
         let mut str = match type_ {
             ScType::Val
             | ScType::U64
@@ -125,7 +143,7 @@ impl Spec {
             ),
             ScType::Option(type_) => return self.doc(name, &type_.value_type),
             ScType::Udt(ScSpecTypeUdt { name }) => {
-                let spec_type = self.find(&name.to_utf8_string_lossy())?;
+                let spec_type = self.find_udt(name)?;
                 match spec_type {
                     ScSpecEntry::FunctionV0(ScSpecFunctionV0 { doc, .. })
                     | ScSpecEntry::UdtStructV0(ScSpecUdtStructV0 { doc, .. })
@@ -152,7 +170,7 @@ impl Spec {
         if str.is_empty() {
             Ok(None)
         } else {
-            Ok(Some(Box::leak(str.into_boxed_str())))
+            Ok(Some(str))
         }
     }
 
@@ -160,23 +178,21 @@ impl Spec {
     ///
     /// Might return errors
     pub fn find(&self, name: &str) -> Result<&ScSpecEntry, Error> {
-        self.0
-            .as_ref()
-            .and_then(|specs| {
-                specs.iter().find(|e| {
-                    let entry_name = match e {
-                        ScSpecEntry::FunctionV0(x) => x.name.to_utf8_string_lossy(),
-                        ScSpecEntry::UdtStructV0(x) => x.name.to_utf8_string_lossy(),
-                        ScSpecEntry::UdtUnionV0(x) => x.name.to_utf8_string_lossy(),
-                        ScSpecEntry::UdtEnumV0(x) => x.name.to_utf8_string_lossy(),
-                        ScSpecEntry::UdtErrorEnumV0(x) => x.name.to_utf8_string_lossy(),
-                    };
-                    name == entry_name
-                })
-            })
+        self.get(name.as_bytes())
             .ok_or_else(|| Error::MissingEntry(name.to_owned()))
     }
 
+    /// Finds the entry of a user defined type, without first converting its name to a string.
+    fn find_udt(&self, name: &StringM<60>) -> Result<&ScSpecEntry, Error> {
+        self.get(name.as_slice())
+            .ok_or_else(|| Error::MissingEntry(name.to_utf8_string_lossy()))
+    }
+
+    fn get(&self, name: &[u8]) -> Option<&ScSpecEntry> {
+        let entries = self.entries.as_ref()?;
+        self.index.get(name).map(|&i| &entries[i])
+    }
+
     /// # Errors
     ///
     /// Might return errors
@@ -191,7 +207,7 @@ impl Spec {
     ///
     pub fn find_functions(&self) -> Result<impl Iterator<Item = &ScSpecFunctionV0>, Error> {
         Ok(self
-            .0
+            .entries
             .as_ref()
             .ok_or(Error::MissingSpec)?
             .iter()
@@ -230,9 +246,7 @@ impl Spec {
             if s == "null" {
                 return Ok(ScVal::Void);
             }
-            let ScSpecTypeOption { value_type } = b.as_ref().clone();
-            let v = value_type.as_ref().clone();
-            return self.from_string(s, &v);
+            return self.from_string(s, &b.value_type);
         }
         // Parse as string and for special types assume Value::String
         serde_json::from_str(s)
@@ -249,7 +263,7 @@ impl Spec {
                     | ScType::Address => Ok(Value::String(s.to_owned())),
                     ScType::Udt(ScSpecTypeUdt { name })
                         if matches!(
-                            self.find(&name.to_utf8_string_lossy())?,
+                            self.find_udt(name)?,
                             ScSpecEntry::UdtUnionV0(_) | ScSpecEntry::UdtStructV0(_)
                         ) =>
                     {
@@ -322,8 +336,7 @@ impl Spec {
     }
 
     fn parse_udt(&self, name: &StringM<60>, value: &Value) -> Result<ScVal, Error> {
-        let name = &name.to_utf8_string_lossy();
-        match (self.find(name)?, value) {
+        match (self.find_udt(name)?, value) {
             (ScSpecEntry::UdtStructV0(strukt), Value::Object(map)) => {
                 if strukt
                     .fields
@@ -359,7 +372,6 @@ impl Spec {
     ) -> Result<ScVal, Error> {
         let items = strukt
             .fields
-            .to_vec()
             .iter()
             .zip(array.iter())
             .map(|(f, v)| {
@@ -377,7 +389,6 @@ impl Spec {
     ) -> Result<ScVal, Error> {
         let items = strukt
             .fields
-            .to_vec()
             .iter()
             .map(|f| {
                 let name = &f.name.to_utf8_string_lossy();
@@ -556,7 +567,6 @@ impl Spec {
     ) -> Result<Value, Error> {
         Ok(Value::Array(
             vec_m
-                .to_vec()
                 .iter()
                 .map(|sc_val| self.xdr_to_json(sc_val, type_))
                 .collect::<Result<Vec<_>, Error>>()?,
@@ -586,8 +596,7 @@ impl Spec {
     ///
     /// May panic
     pub fn udt_to_json(&self, name: &StringM<60>, sc_obj: &ScVal) -> Result<Value, Error> {
-        let name = &name.to_utf8_string_lossy();
-        let udt = self.find(name)?;
+        let udt = self.find_udt(name)?;
         Ok(match (sc_obj, udt) {
             (ScVal::Map(Some(map)), ScSpecEntry::UdtStructV0(strukt)) => serde_json::Value::Object(
                 strukt
@@ -609,9 +618,7 @@ impl Spec {
                     .collect::<Result<Vec<_>, Error>>()?,
             ),
             (ScVal::Vec(Some(vec_)), ScSpecEntry::UdtUnionV0(union)) => {
-                let v = vec_.to_vec();
-                // let val = &v[0];
-                let (first, rest) = match v.split_at(1) {
+                let (first, rest) = match vec_.split_at(1) {
                     ([first], []) => (first, None),
                     ([first], rest) => (first, Some(rest)),
                     _ => return Err(Error::IllFormedEnum(union.name.to_utf8_string_lossy())),
@@ -694,21 +701,15 @@ impl Spec {
             (ScVal::U64(u64_), ScType::U64) => Value::Number(serde_json::Number::from(*u64_)),
 
             (ScVal::I64(i64_), ScType::I64) => Value::Number(serde_json::Number::from(*i64_)),
-            (int @ ScVal::U128(_), ScType::U128) => {
+            (ScVal::U128(UInt128Parts { hi, lo }), ScType::U128) => {
                 // Always output u128s as strings
-                let v: u128 = int
-                    .clone()
-                    .try_into()
-                    .map_err(|()| Error::InvalidValue(Some(ScType::U128)))?;
+                let v = (u128::from(*hi) << 64) | u128::from(*lo);
                 Value::String(v.to_string())
             }
 
-            (int @ ScVal::I128(_), ScType::I128) => {
+            (ScVal::I128(Int128Parts { hi, lo }), ScType::I128) => {
                 // Always output u128s as strings
-                let v: i128 = int
-                    .clone()
-                    .try_into()
-                    .map_err(|()| Error::InvalidValue(Some(ScType::I128)))?;
+                let v = (i128::from(*hi) << 64) | i128::from(*lo);
                 Value::String(v.to_string())
             }
 
@@ -732,6 +733,16 @@ impl Spec {
     }
 }
 
+fn entry_name(entry: &ScSpecEntry) -> &[u8] {
+    match entry {
+        ScSpecEntry::FunctionV0(x) => x.name.0.as_slice(),
+        ScSpecEntry::UdtStructV0(x) => x.name.as_slice(),
+        ScSpecEntry::UdtUnionV0(x) => x.name.as_slice(),
+        ScSpecEntry::UdtEnumV0(x) => x.name.as_slice(),
+        ScSpecEntry::UdtErrorEnumV0(x) => x.name.as_slice(),
+    }
+}
+
 /// # Errors
 ///
 /// Might return an error
@@ -1132,26 +1143,24 @@ impl Spec {
                 Some(format!("Map<{key}, {val}>"))
             }
             ScType::BytesN(t) => Some(format!("{}_hex_bytes", t.n)),
-            ScType::Udt(ScSpecTypeUdt { name }) => {
-                match self.find(&name.to_utf8_string_lossy()).ok()? {
-                    ScSpecEntry::UdtStructV0(ScSpecUdtStructV0 { fields, .. })
-                        if fields
-                            .first()
-                            .is_some_and(|f| f.name.to_utf8_string_lossy() == "0") =>
-                    {
-                        let fields = fields
-                            .iter()
-                            .map(|t| self.arg_value_name(&t.type_, depth + 1))
-                            .collect::<Option<Vec<_>>>()?
-                            .join(", ");
-                        Some(format!("[{fields}]"))
-                    }
-                    ScSpecEntry::UdtStructV0(strukt) => self.arg_value_udt(strukt, depth),
-                    ScSpecEntry::UdtUnionV0(union) => self.arg_value_union(union, depth),
-                    ScSpecEntry::UdtEnumV0(enum_) => Some(arg_value_enum(enum_)),
-                    ScSpecEntry::FunctionV0(_) | ScSpecEntry::UdtErrorEnumV0(_) => None,
+            ScType::Udt(ScSpecTypeUdt { name }) => match self.find_udt(name).ok()? {
+                ScSpecEntry::UdtStructV0(ScSpecUdtStructV0 { fields, .. })
+                    if fields
+                        .first()
+                        .is_some_and(|f| f.name.to_utf8_string_lossy() == "0") =>
+                {
+                    let fields = fields
+                        .iter()
+                        .map(|t| self.arg_value_name(&t.type_, depth + 1))
+                        .collect::<Option<Vec<_>>>()?
+                        .join(", ");
+                    Some(format!("[{fields}]"))
                 }
-            }
+                ScSpecEntry::UdtStructV0(strukt) => self.arg_value_udt(strukt, depth),
+                ScSpecEntry::UdtUnionV0(union) => self.arg_value_union(union, depth),
+                ScSpecEntry::UdtEnumV0(enum_) => Some(arg_value_enum(enum_)),
+                ScSpecEntry::FunctionV0(_) | ScSpecEntry::UdtErrorEnumV0(_) => None,
+            },
             // No specific value name for these yet.
             ScType::Val => None,
         }
@@ -1284,16 +1293,14 @@ impl Spec {
                 };
                 Some(format!("\"{res}\""))
             }
-            ScType::Udt(ScSpecTypeUdt { name }) => {
-                self.example_udts(name.to_utf8_string_lossy().as_ref())
-            }
+            ScType::Udt(ScSpecTypeUdt { name }) => self.example_udts(name),
             // No specific value name for these yet.
             ScType::Val => None,
         }
     }
 
-    fn example_udts(&self, name: &str) -> Option<String> {
-        match self.find(name).ok() {
+    fn example_udts(&self, name: &StringM<60>) -> Option<String> {
+        match self.find_udt(name).ok() {
             Some(ScSpecEntry::UdtStructV0(strukt)) => {
                 // Check if a tuple strukt
                 if !strukt.fields.is_empty() && strukt.fields[0].name.to_utf8_string_lossy() == "0"
@@ -1361,7 +1368,7 @@ impl Spec {
 mod tests {
     use super::*;
 
-    use stellar_xdr::curr::ScSpecTypeBytesN;
+    use stellar_xdr::curr::{ScSpecTypeBytesN, ScSpecUdtEnumCaseV0};
 
     #[test]
     fn from_json_primitives_bytesn() {
@@ -1410,6 +1417,51 @@ mod tests {
         );
     }
 
+    #[test]
+    fn find_uses_first_entry_of_each_name() {
+        let enum_ = |name: &str, value: u32| {
+            ScSpecEntry::UdtEnumV0(ScSpecUdtEnumV0 {
+                doc: StringM::default(),
+                lib: StringM::default(),
+                name: name.try_into().unwrap(),
+                cases: vec![ScSpecUdtEnumCaseV0 {
+                    doc: StringM::default(),
+                    name: "A".try_into().unwrap(),
+                    value,
+                }]
+                .try_into()
+                .unwrap(),
+            })
+        };
+        let spec = Spec::new(vec![
+            enum_("First", 1),
+            enum_("Second", 2),
+            enum_("First", 3),
+        ]);
+        let cases = |entry: &ScSpecEntry| match entry {
+            ScSpecEntry::UdtEnumV0(e) => e.cases[0].value,
+            _ => panic!("not an enum"),
+        };
+        assert_eq!(cases(spec.find("First").unwrap()), 1);
+        assert_eq!(cases(spec.find("Second").unwrap()), 2);
+        assert!(matches!(spec.find("Third"), Err(Error::MissingEntry(_))));
+        assert!(matches!(
+            Spec::default().find("First"),
+            Err(Error::MissingEntry(_))
+        ));
+    }
+
+    #[test]
+    fn sc_object_to_json_i128() {
+        let val = ScVal::I128(Int128Parts { hi: -1, lo: 0 });
+        assert_eq!(
+            Spec::default()
+                .sc_object_to_json(&val, &ScType::I128)
+                .unwrap(),
+            Value::String((-(1i128 << 64)).to_string())
+        );
+    }
+
     #[test]
     fn test_sc_address_from_json_strkey() {
         // All zero contract address
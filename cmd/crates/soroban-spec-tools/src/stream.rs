@@ -0,0 +1,656 @@
+//! Conversion between JSON and [`ScVal`]s of the types in a spec without building a
+//! [`serde_json::Value`] of the whole document.
+//!
+//! Vectors, maps, tuples, structs and unions are read and written one element at a time.
+//! Every other value is small, and is converted with [`Spec::from_json`] or
+//! [`Spec::xdr_to_json`], so that the JSON read and written here is the same as theirs.
+
+use std::{collections::BTreeMap, fmt, io};
+
+use serde::{
+    de::{self, DeserializeSeed, Deserializer, IgnoredAny, MapAccess, SeqAccess, Visitor},
+    ser::{self, Serialize, SerializeMap, Serializer},
+    Deserialize,
+};
+use serde_json::Value;
+use stellar_xdr::curr::{
+    ScMap, ScMapEntry, ScSpecEntry, ScSpecTypeDef as ScType, ScSpecTypeUdt, ScSpecUdtStructV0,
+    ScSpecUdtUnionCaseV0, ScSpecUdtUnionV0, ScSymbol, ScVal, ScVec,
+};
+
+use crate::{Error, Spec};
+
+impl Spec {
+    /// Reads a value of type `t` from the JSON document in `reader`, which should be buffered.
+    ///
+    /// # Errors
+    ///
+    /// Might return errors
+    pub fn from_json_reader(&self, reader: impl io::Read, t: &ScType) -> Result<ScVal, Error> {
+        let mut de = serde_json::Deserializer::from_reader(reader);
+        let val = self.typed(t).deserialize(&mut de)?;
+        de.end()?;
+        Ok(val)
+    }
+
+    /// Reads a value of type `t` from the JSON document `json`.
+    ///
+    /// # Errors
+    ///
+    /// Might return errors
+    pub fn from_json_slice(&self, json: &[u8], t: &ScType) -> Result<ScVal, Error> {
+        let mut de = serde_json::Deserializer::from_slice(json);
+        let val = self.typed(t).deserialize(&mut de)?;
+        de.end()?;
+        Ok(val)
+    }
+
+    /// Writes `val`, of type `t`, to `writer` as JSON.
+    ///
+    /// # Errors
+    ///
+    /// Might return errors
+    pub fn to_json_writer(
+        &self,
+        writer: impl io::Write,
+        val: &ScVal,
+        t: &ScType,
+    ) -> Result<(), Error> {
+        serde_json::to_writer(writer, &self.json(val, t))?;
+        Ok(())
+    }
+
+    /// `val`, of type `t`, as a value that serializes to the JSON [`Spec::xdr_to_json`]
+    /// returns for it.
+    pub fn json<'a>(&'a self, val: &'a ScVal, t: &'a ScType) -> Json<'a> {
+        Json {
+            spec: self,
+            val,
+            type_: t,
+        }
+    }
+
+    fn typed<'a>(&'a self, type_: &'a ScType) -> Typed<'a> {
+        Typed { spec: self, type_ }
+    }
+}
+
+fn de_error<E: de::Error>(e: impl Into<Error>) -> E {
+    E::custom(e.into())
+}
+
+fn ser_error<E: ser::Error>(e: impl Into<Error>) -> E {
+    E::custom(e.into())
+}
+
+/// Deserializes a value of a type of the spec.
+#[derive(Clone, Copy)]
+struct Typed<'a> {
+    spec: &'a Spec,
+    type_: &'a ScType,
+}
+
+impl<'de> DeserializeSeed<'de> for Typed<'_> {
+    type Value = ScVal;
+
+    fn deserialize<D: Deserializer<'de>>(self, de: D) -> Result<ScVal, D::Error> {
+        let Typed { spec, type_ } = self;
+        match type_ {
+            ScType::Option(option) => {
+                de.deserialize_option(OptionVisitor(spec.typed(&option.value_type)))
+            }
+            ScType::Vec(vec) => de.deserialize_seq(VecVisitor(spec.typed(&vec.element_type))),
+            ScType::Tuple(tuple) => de.deserialize_seq(TupleVisitor {
+                spec,
+                tuple: type_,
+                types: &tuple.value_types,
+            }),
+            ScType::Map(map) => de.deserialize_map(MapVisitor {
+                spec,
+                key_type: &map.key_type,
+                value_type: &map.value_type,
+            }),
+            ScType::Udt(ScSpecTypeUdt { name }) => match spec.find_udt(name).map_err(de_error)? {
+                ScSpecEntry::UdtStructV0(strukt) => {
+                    de.deserialize_any(StructVisitor { spec, strukt })
+                }
+                ScSpecEntry::UdtUnionV0(union) => de.deserialize_any(UnionVisitor { spec, union }),
+                _ => leaf(spec, type_, de),
+            },
+            _ => leaf(spec, type_, de),
+        }
+    }
+}
+
+fn leaf<'de, D: Deserializer<'de>>(spec: &Spec, type_: &ScType, de: D) -> Result<ScVal, D::Error> {
+    let value = Value::deserialize(de)?;
+    spec.from_json(&value, type_).map_err(de_error)
+}
+
+fn vec<E: de::Error>(items: Vec<ScVal>) -> Result<ScVal, E> {
+    let items: ScVec = items.try_into().map_err(Error::Xdr).map_err(de_error)?;
+    Ok(ScVal::Vec(Some(items)))
+}
+
+struct OptionVisitor<'a>(Typed<'a>);
+
+impl<'de> Visitor<'de> for OptionVisitor<'_> {
+    type Value = ScVal;
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str("an optional value")
+    }
+
+    fn visit_none<E: de::Error>(self) -> Result<ScVal, E> {
+        Ok(ScVal::Void)
+    }
+
+    fn visit_unit<E: de::Error>(self) -> Result<ScVal, E> {
+        Ok(ScVal::Void)
+    }
+
+    fn visit_some<D: Deserializer<'de>>(self, de: D) -> Result<ScVal, D::Error> {
+        self.0.deserialize(de)
+    }
+}
+
+struct VecVisitor<'a>(Typed<'a>);
+
+impl<'de> Visitor<'de> for VecVisitor<'_> {
+    type Value = ScVal;
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str("an array")
+    }
+
+    fn visit_seq<A: SeqAccess<'de>>(self, mut seq: A) -> Result<ScVal, A::Error> {
+        let mut items = Vec::with_capacity(seq.size_hint().unwrap_or_default());
+        while let Some(item) = seq.next_element_seed(self.0)? {
+            items.push(item);
+        }
+        vec(items)
+    }
+}
+
+struct TupleVisitor<'a> {
+    spec: &'a Spec,
+    tuple: &'a ScType,
+    types: &'a [ScType],
+}
+
+impl<'de> Visitor<'de> for TupleVisitor<'_> {
+    type Value = ScVal;
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        write!(f, "an array of {} values", self.types.len())
+    }
+
+    fn visit_seq<A: SeqAccess<'de>>(self, mut seq: A) -> Result<ScVal, A::Error> {
+        let invalid = || de_error(Error::InvalidValue(Some(self.tuple.clone())));
+        let mut items = Vec::with_capacity(self.types.len());
+        for type_ in self.types {
+            items.push(
+                seq.next_element_seed(self.spec.typed(type_))?
+                    .ok_or_else(invalid)?,
+            );
+        }
+        if seq.next_element::<IgnoredAny>()?.is_some() {
+            return Err(invalid());
+        }
+        vec(items)
+    }
+}
+
+struct MapVisitor<'a> {
+    spec: &'a Spec,
+    key_type: &'a ScType,
+    value_type: &'a ScType,
+}
+
+impl<'de> Visitor<'de> for MapVisitor<'_> {
+    type Value = ScVal;
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str("an object")
+    }
+
+    fn visit_map<A: MapAccess<'de>>(self, mut map: A) -> Result<ScVal, A::Error> {
+        let mut entries = Vec::with_capacity(map.size_hint().unwrap_or_default());
+        while let Some(key) = map.next_key::<String>()? {
+            let key = self
+                .spec
+                .from_string(&key, self.key_type)
+                .map_err(de_error)?;
+            let val = map.next_value_seed(self.spec.typed(self.value_type))?;
+            entries.push(ScMapEntry { key, val });
+        }
+        let map = ScMap::sorted_from(entries)
+            .map_err(Error::Xdr)
+            .map_err(de_error)?;
+        Ok(ScVal::Map(Some(map)))
+    }
+}
+
+struct StructVisitor<'a> {
+    spec: &'a Spec,
+    strukt: &'a ScSpecUdtStructV0,
+}
+
+impl<'de> Visitor<'de> for StructVisitor<'_> {
+    type Value = ScVal;
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        write!(f, "a {} struct", self.strukt.name.to_utf8_string_lossy())
+    }
+
+    fn visit_seq<A: SeqAccess<'de>>(self, mut seq: A) -> Result<ScVal, A::Error> {
+        let mut items = Vec::with_capacity(self.strukt.fields.len());
+        for field in self.strukt.fields.iter() {
+            match seq.next_element_seed(self.spec.typed(&field.type_))? {
+                Some(item) => items.push(item),
+                None => break,
+            }
+        }
+        while seq.next_element::<IgnoredAny>()?.is_some() {}
+        vec(items)
+    }
+
+    fn visit_map<A: MapAccess<'de>>(self, mut map: A) -> Result<ScVal, A::Error> {
+        let fields = &self.strukt.fields;
+        let mut values = vec![None; fields.len()];
+        // Structs with fields named "0", "1" and so on are tuple structs, decoded as vectors.
+        let tuple = fields.iter().any(|f| f.name.as_slice() == b"0");
+        let mut len = 0;
+        while let Some(key) = map.next_key::<String>()? {
+            len += 1;
+            let i = if tuple {
+                key.parse::<usize>().ok().filter(|i| *i < fields.len())
+            } else {
+                fields
+                    .iter()
+                    .position(|f| f.name.as_slice() == key.as_bytes())
+            };
+            match i {
+                Some(i) => {
+                    values[i] = Some(map.next_value_seed(self.spec.typed(&fields[i].type_))?)
+                }
+                None => map.next_value::<IgnoredAny>().map(|_| ())?,
+            }
+        }
+        if tuple {
+            let items = values
+                .into_iter()
+                .take(len)
+                .enumerate()
+                .map(|(i, v)| v.ok_or_else(|| de_error(Error::MissingKey(i.to_string()))))
+                .collect::<Result<Vec<_>, _>>()?;
+            return vec(items);
+        }
+        let entries = fields
+            .iter()
+            .zip(values)
+            .map(|(field, val)| {
+                let val = val.ok_or_else(|| {
+                    de_error(Error::MissingKey(field.name.to_utf8_string_lossy()))
+                })?;
+                let key = field
+                    .name
+                    .as_slice()
+                    .try_into()
+                    .map_err(Error::Xdr)
+                    .map_err(de_error)?;
+                Ok(ScMapEntry {
+                    key: ScVal::Symbol(ScSymbol(key)),
+                    val,
+                })
+            })
+            .collect::<Result<Vec<_>, _>>()?;
+        let map = ScMap::sorted_from(entries)
+            .map_err(Error::Xdr)
+            .map_err(de_error)?;
+        Ok(ScVal::Map(Some(map)))
+    }
+}
+
+struct UnionVisitor<'a> {
+    spec: &'a Spec,
+    union: &'a ScSpecUdtUnionV0,
+}
+
+impl UnionVisitor<'_> {
+    fn case<E: de::Error>(&self, name: &str) -> Result<(&ScSpecUdtUnionCaseV0, ScVal), E> {
+        let case = self
+            .union
+            .cases
+            .iter()
+            .find(|c| {
+                let case_name = match c {
+                    ScSpecUdtUnionCaseV0::VoidV0(v) => &v.name,
+                    ScSpecUdtUnionCaseV0::TupleV0(v) => &v.name,
+                };
+                case_name.as_slice() == name.as_bytes()
+            })
+            .ok_or_else(|| {
+                de_error(Error::EnumCase(
+                    name.to_string(),
+                    self.union.name.to_utf8_string_lossy(),
+                ))
+            })?;
+        let symbol = name.try_into().map_err(Error::Xdr).map_err(de_error)?;
+        Ok((case, ScVal::Symbol(ScSymbol(symbol))))
+    }
+}
+
+impl<'de> Visitor<'de> for UnionVisitor<'_> {
+    type Value = ScVal;
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        write!(
+            f,
+            "a case of the {} union",
+            self.union.name.to_utf8_string_lossy()
+        )
+    }
+
+    fn visit_str<E: de::Error>(self, v: &str) -> Result<ScVal, E> {
+        let (_, symbol) = self.case(v)?;
+        vec(vec![symbol])
+    }
+
+    fn visit_map<A: MapAccess<'de>>(self, mut map: A) -> Result<ScVal, A::Error> {
+        let Some(name) = map.next_key::<String>()? else {
+            return Err(de::Error::invalid_length(0, &self));
+        };
+        let (case, symbol) = self.case(&name)?;
+        let mut items = vec![symbol];
+        match case {
+            ScSpecUdtUnionCaseV0::TupleV0(tuple) if tuple.type_.len() == 1 => {
+                items.push(map.next_value_seed(self.spec.typed(&tuple.type_[0]))?);
+            }
+            ScSpecUdtUnionCaseV0::TupleV0(tuple) => {
+                items.extend(map.next_value_seed(CaseValues {
+                    spec: self.spec,
+                    types: &tuple.type_,
+                })?);
+            }
+            ScSpecUdtUnionCaseV0::VoidV0(_) => map.next_value::<IgnoredAny>().map(|_| ())?,
+        }
+        if map.next_key::<IgnoredAny>()?.is_some() {
+            return Err(de::Error::invalid_length(2, &self));
+        }
+        vec(items)
+    }
+}
+
+/// The values of a union case with several types, given as an array, or as an object with
+/// the keys "0", "1" and so on.
+struct CaseValues<'a> {
+    spec: &'a Spec,
+    types: &'a [ScType],
+}
+
+impl<'de> DeserializeSeed<'de> for CaseValues<'_> {
+    type Value = Vec<ScVal>;
+
+    fn deserialize<D: Deserializer<'de>>(self, de: D) -> Result<Vec<ScVal>, D::Error> {
+        de.deserialize_any(self)
+    }
+}
+
+impl<'de> Visitor<'de> for CaseValues<'_> {
+    type Value = Vec<ScVal>;
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        write!(f, "an array of {} values", self.types.len())
+    }
+
+    fn visit_seq<A: SeqAccess<'de>>(self, mut seq: A) -> Result<Vec<ScVal>, A::Error> {
+        let mut items = Vec::with_capacity(self.types.len());
+        for type_ in self.types {
+            match seq.next_element_seed(self.spec.typed(type_))? {
+                Some(item) => items.push(item),
+                None => break,
+            }
+        }
+        while seq.next_element::<IgnoredAny>()?.is_some() {}
+        Ok(items)
+    }
+
+    fn visit_map<A: MapAccess<'de>>(self, mut map: A) -> Result<Vec<ScVal>, A::Error> {
+        let mut values = vec![None; self.types.len()];
+        let mut len = 0;
+        while let Some(key) = map.next_key::<String>()? {
+            len += 1;
+            match key.parse::<usize>().ok().filter(|i| *i < self.types.len()) {
+                Some(i) => values[i] = Some(map.next_value_seed(self.spec.typed(&self.types[i]))?),
+                None => map.next_value::<IgnoredAny>().map(|_| ())?,
+            }
+        }
+        values
+            .into_iter()
+            .take(len)
+            .enumerate()
+            .map(|(i, v)| v.ok_or_else(|| de_error(Error::MissingKey(i.to_string()))))
+            .collect()
+    }
+}
+
+/// A value serialized as the JSON [`Spec::xdr_to_json`] returns for it.
+#[derive(Clone, Copy)]
+pub struct Json<'a> {
+    spec: &'a Spec,
+    val: &'a ScVal,
+    type_: &'a ScType,
+}
+
+impl Serialize for Json<'_> {
+    fn serialize<S: Serializer>(&self, s: S) -> Result<S::Ok, S::Error> {
+        let Json { spec, val, type_ } = *self;
+        match (val, type_) {
+            (ScVal::Vec(Some(vec_)), ScType::Vec(vec)) => {
+                s.collect_seq(vec_.iter().map(|v| spec.json(v, &vec.element_type)))
+            }
+            (ScVal::Vec(Some(vec_)), ScType::Tuple(tuple)) => s.collect_seq(
+                vec_.iter()
+                    .zip(tuple.value_types.iter())
+                    .map(|(v, t)| spec.json(v, t)),
+            ),
+            (ScVal::Map(Some(map)), ScType::Map(map_type)) => {
+                // Keys are JSON themselves, ordered as in a `serde_json::Map`.
+                let mut entries = BTreeMap::new();
+                for ScMapEntry { key, val } in map.iter() {
+                    let key = serde_json::to_string(&spec.json(key, &map_type.key_type))
+                        .map_err(ser_error)?;
+                    entries.insert(key, spec.json(val, &map_type.value_type));
+                }
+                s.collect_map(entries)
+            }
+            (ScVal::Vec(Some(_)) | ScVal::Map(Some(_)), ScType::Udt(ScSpecTypeUdt { name })) => {
+                match (val, spec.find_udt(name).map_err(ser_error)?) {
+                    (ScVal::Map(Some(map)), ScSpecEntry::UdtStructV0(strukt)) => s.collect_map(
+                        strukt
+                            .fields
+                            .iter()
+                            .zip(map.iter())
+                            .map(|(f, entry)| {
+                                (
+                                    f.name.to_utf8_string_lossy(),
+                                    spec.json(&entry.val, &f.type_),
+                                )
+                            })
+                            .collect::<BTreeMap<_, _>>(),
+                    ),
+                    (ScVal::Vec(Some(vec_)), ScSpecEntry::UdtStructV0(strukt)) => s.collect_seq(
+                        strukt
+                            .fields
+                            .iter()
+                            .zip(vec_.iter())
+                            .map(|(f, v)| spec.json(v, &f.type_)),
+                    ),
+                    (ScVal::Vec(Some(vec_)), ScSpecEntry::UdtUnionV0(union)) => {
+                        serialize_union(spec, union, vec_, s)
+                    }
+                    _ => spec
+                        .xdr_to_json(val, type_)
+                        .map_err(ser_error)?
+                        .serialize(s),
+                }
+            }
+            (ScVal::Vec(Some(_)) | ScVal::Map(Some(_)), ScType::Result(result)) => {
+                spec.json(val, &result.ok_type).serialize(s)
+            }
+            (ScVal::Vec(Some(_)) | ScVal::Map(Some(_)), ScType::Option(option)) => {
+                spec.json(val, &option.value_type).serialize(s)
+            }
+            _ => spec
+                .xdr_to_json(val, type_)
+                .map_err(ser_error)?
+                .serialize(s),
+        }
+    }
+}
+
+fn serialize_union<S: Serializer>(
+    spec: &Spec,
+    union: &ScSpecUdtUnionV0,
+    vec_: &[ScVal],
+    s: S,
+) -> Result<S::Ok, S::Error> {
+    let union_name = || union.name.to_utf8_string_lossy();
+    let Some((first, rest)) = vec_.split_first() else {
+        return Err(ser_error(Error::IllFormedEnum(union_name())));
+    };
+    let ScVal::Symbol(case_name) = first else {
+        return Err(ser_error(Error::EnumFirstValueNotSymbol));
+    };
+    let case = union
+        .cases
+        .iter()
+        .find(|case| {
+            let name = match case {
+                ScSpecUdtUnionCaseV0::VoidV0(v) => &v.name,
+                ScSpecUdtUnionCaseV0::TupleV0(v) => &v.name,
+            };
+            name.as_slice() == case_name.as_slice()
+        })
+        .ok_or_else(|| {
+            ser_error(Error::FailedToFindEnumCase(
+                case_name.to_utf8_string_lossy(),
+            ))
+        })?;
+    let case_name = case_name.to_utf8_string_lossy();
+    match case {
+        ScSpecUdtUnionCaseV0::TupleV0(_) if rest.is_empty() => Err(ser_error(
+            Error::EnumMissingSecondValue(union_name(), case_name),
+        )),
+        ScSpecUdtUnionCaseV0::TupleV0(tuple) => {
+            let mut map = s.serialize_map(Some(1))?;
+            if tuple.type_.len() == 1 {
+                map.serialize_entry(&case_name, &spec.json(&rest[0], &tuple.type_[0]))?;
+            } else {
+                let values = tuple
+                    .type_
+                    .iter()
+                    .zip(rest)
+                    .map(|(t, v)| spec.json(v, t))
+                    .collect::<Vec<_>>();
+                map.serialize_entry(&case_name, &values)?;
+            }
+            map.end()
+        }
+        ScSpecUdtUnionCaseV0::VoidV0(_) => s.serialize_str(&case_name),
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+    use stellar_xdr::curr::{
+        ScSpecTypeMap, ScSpecTypeOption, ScSpecTypeVec, ScSpecUdtStructFieldV0,
+        ScSpecUdtUnionCaseTupleV0, ScSpecUdtUnionCaseVoidV0, StringM,
+    };
+
+    fn spec() -> Spec {
+        let field = |name: &str, type_: ScType| ScSpecUdtStructFieldV0 {
+            doc: StringM::default(),
+            name: name.try_into().unwrap(),
+            type_,
+        };
+        Spec::new(vec![
+            ScSpecEntry::UdtStructV0(ScSpecUdtStructV0 {
+                doc: StringM::default(),
+                lib: StringM::default(),
+                name: "Point".try_into().unwrap(),
+                fields: vec![field("x", ScType::I128), field("y", ScType::U32)]
+                    .try_into()
+                    .unwrap(),
+            }),
+            ScSpecEntry::UdtUnionV0(ScSpecUdtUnionV0 {
+                doc: StringM::default(),
+                lib: StringM::default(),
+                name: "Shape".try_into().unwrap(),
+                cases: vec![
+                    ScSpecUdtUnionCaseV0::VoidV0(ScSpecUdtUnionCaseVoidV0 {
+                        doc: StringM::default(),
+                        name: "Empty".try_into().unwrap(),
+                    }),
+                    ScSpecUdtUnionCaseV0::TupleV0(ScSpecUdtUnionCaseTupleV0 {
+                        doc: StringM::default(),
+                        name: "Line".try_into().unwrap(),
+                        type_: vec![udt("Point"), udt("Point")].try_into().unwrap(),
+                    }),
+                ]
+                .try_into()
+                .unwrap(),
+            }),
+        ])
+    }
+
+    fn udt(name: &str) -> ScType {
+        ScType::Udt(ScSpecTypeUdt {
+            name: name.try_into().unwrap(),
+        })
+    }
+
+    #[test]
+    fn matches_value_conversion() {
+        let spec = spec();
+        let type_ = ScType::Map(Box::new(ScSpecTypeMap {
+            key_type: Box::new(ScType::Symbol),
+            value_type: Box::new(ScType::Vec(Box::new(ScSpecTypeVec {
+                element_type: Box::new(ScType::Option(Box::new(ScSpecTypeOption {
+                    value_type: Box::new(udt("Shape")),
+                }))),
+            }))),
+        }));
+        let json = r#"{
+            "b": ["Empty", null, {"Line": [{"x": "-5", "y": 1}, {"y": 2, "x": "7", "z": 0}]}],
+            "a": [{"Line": {"0": {"x": "1", "y": 0}, "1": {"x": "2", "y": 3}}}]
+        }"#;
+
+        let streamed = spec.from_json_slice(json.as_bytes(), &type_).unwrap();
+        let value: Value = serde_json::from_str(json).unwrap();
+        assert_eq!(streamed, spec.from_json(&value, &type_).unwrap());
+        assert_eq!(
+            spec.from_json_reader(json.as_bytes(), &type_).unwrap(),
+            streamed
+        );
+
+        let mut written = Vec::new();
+        spec.to_json_writer(&mut written, &streamed, &type_)
+            .unwrap();
+        assert_eq!(
+            String::from_utf8(written).unwrap(),
+            spec.xdr_to_json(&streamed, &type_).unwrap().to_string()
+        );
+    }
+
+    #[test]
+    fn rejects_missing_fields() {
+        let json = br#"[{"x": "1"}]"#;
+        let type_ = ScType::Vec(Box::new(ScSpecTypeVec {
+            element_type: Box::new(udt("Point")),
+        }));
+        assert!(spec().from_json_slice(json, &type_).is_err());
+    }
+}
@@ -1,8 +1,8 @@
 #![allow(non_snake_case)]
 use heck::{ToLowerCamelCase, ToShoutySnakeCase};
-use include_dir::{include_dir, Dir};
+use include_dir::{include_dir, Dir, DirEntry, File};
 use std::{
-    fs,
+    fs, io,
     io::Write,
     path::{Path, PathBuf},
 };
@@ -16,6 +16,9 @@ const NETWORK_PASSPHRASE_TESTNET: &str = "Test SDF Network ; September 2015";
 const NETWORK_PASSPHRASE_FUTURENET: &str = "Test SDF Future Network ; October 2022";
 const NETWORK_PASSPHRASE_STANDALONE: &str = "Standalone Network ; February 2017";
 
+/// Files of the template with placeholders to replace.
+const TEMPLATED_FILES: [&str; 3] = ["package.json", "README.md", "src/index.ts"];
+
 pub struct Project(PathBuf);
 
 impl TryInto<Project> for PathBuf {
@@ -34,6 +37,11 @@ impl AsRef<Path> for Project {
 }
 
 impl Project {
+    /// A project in `root`, without writing anything to it.
+    pub fn new(root: PathBuf) -> Self {
+        Self(root)
+    }
+
     /// Initialize a new JS client project, updating placeholder strings in the template and
     /// appending functions for each method in the contract to the index.ts file.
     ///
@@ -63,31 +71,17 @@ impl Project {
         rpc_url: &str,
         network_passphrase: &str,
     ) -> std::io::Result<()> {
-        let replacement_strings = &[
-            ("INSERT_CONTRACT_NAME_HERE", contract_name),
-            (
-                "INSERT_SCREAMING_SNAKE_CASE_CONTRACT_NAME_HERE",
-                &contract_name.to_shouty_snake_case(),
-            ),
-            (
-                "INSERT_CAMEL_CASE_CONTRACT_NAME_HERE",
-                &contract_name.to_lower_camel_case(),
-            ),
-            ("INSERT_CONTRACT_ID_HERE", contract_id),
-            ("INSERT_NETWORK_PASSPHRASE_HERE", network_passphrase),
-            ("INSERT_RPC_URL_HERE", rpc_url),
-        ];
+        let replacement_strings =
+            replacement_strings(contract_name, contract_id, rpc_url, network_passphrase);
         let root: &Path = self.as_ref();
-        ["package.json", "README.md", "src/index.ts"]
-            .into_iter()
-            .try_for_each(|file_name| {
-                let file = &root.join(file_name);
-                let mut contents = fs::read_to_string(file)?;
-                for (pattern, replacement) in replacement_strings {
-                    contents = contents.replace(pattern, replacement);
-                }
-                fs::write(file, contents)
-            })
+        TEMPLATED_FILES.into_iter().try_for_each(|file_name| {
+            let file = &root.join(file_name);
+            let mut contents = fs::read_to_string(file)?;
+            for (pattern, replacement) in &replacement_strings {
+                contents = contents.replace(pattern, replacement);
+            }
+            fs::write(file, contents)
+        })
     }
 
     fn append_index_ts(
@@ -96,12 +90,70 @@ impl Project {
         contract_id: &str,
         network_passphrase: &str,
     ) -> std::io::Result<()> {
-        let networks = Project::format_networks_object(contract_id, network_passphrase);
-        let types_and_fns = generate(spec);
         fs::OpenOptions::new()
             .append(true)
             .open(self.0.join("src/index.ts"))?
-            .write_all(format!("\n\n{networks}\n\n{types_and_fns}").as_bytes())
+            .write_all(index_ts_suffix(spec, contract_id, network_passphrase).as_bytes())
+    }
+
+    /// The files [`Project::init`] writes, with paths relative to the root of the project.
+    pub fn files(
+        contract_name: &str,
+        contract_id: &str,
+        rpc_url: &str,
+        network_passphrase: &str,
+        spec: &[ScSpecEntry],
+    ) -> Vec<(PathBuf, Vec<u8>)> {
+        let replacement_strings =
+            replacement_strings(contract_name, contract_id, rpc_url, network_passphrase);
+        let mut template = Vec::new();
+        template_files(&PROJECT_DIR, &mut template);
+        template
+            .into_iter()
+            .map(|file| {
+                let path = file.path();
+                let is_templated = TEMPLATED_FILES.iter().any(|f| path == Path::new(f));
+                let contents = match file.contents_utf8() {
+                    Some(contents) if is_templated => {
+                        let mut contents = contents.to_string();
+                        for (pattern, replacement) in &replacement_strings {
+                            contents = contents.replace(pattern, replacement);
+                        }
+                        if path == Path::new("src/index.ts") {
+                            contents.push_str(&index_ts_suffix(
+                                spec,
+                                contract_id,
+                                network_passphrase,
+                            ));
+                        }
+                        contents.into_bytes()
+                    }
+                    _ => file.contents().to_vec(),
+                };
+                (path.to_path_buf(), contents)
+            })
+            .collect()
+    }
+
+    /// Writes the `files`, with paths relative to the root of the project, whose contents
+    /// differ from those on disk, returning the paths written. Files that are unchanged are
+    /// left alone, so incremental builds of the project do not see them as modified.
+    pub fn write_changed(&self, files: &[(PathBuf, Vec<u8>)]) -> io::Result<Vec<PathBuf>> {
+        let mut written = Vec::new();
+        for (path, contents) in files {
+            let file = self.0.join(path);
+            match fs::read(&file) {
+                Ok(existing) if existing == *contents => continue,
+                Err(e) if e.kind() != io::ErrorKind::NotFound => return Err(e),
+                _ => {}
+            }
+            if let Some(dir) = file.parent() {
+                fs::create_dir_all(dir)?;
+            }
+            fs::write(&file, contents)?;
+            written.push(path.clone());
+        }
+        Ok(written)
     }
 
     fn format_networks_object(contract_id: &str, network_passphrase: &str) -> String {
@@ -122,6 +174,48 @@ impl Project {
     }
 }
 
+fn replacement_strings(
+    contract_name: &str,
+    contract_id: &str,
+    rpc_url: &str,
+    network_passphrase: &str,
+) -> [(&'static str, String); 6] {
+    [
+        ("INSERT_CONTRACT_NAME_HERE", contract_name.to_string()),
+        (
+            "INSERT_SCREAMING_SNAKE_CASE_CONTRACT_NAME_HERE",
+            contract_name.to_shouty_snake_case(),
+        ),
+        (
+            "INSERT_CAMEL_CASE_CONTRACT_NAME_HERE",
+            contract_name.to_lower_camel_case(),
+        ),
+        ("INSERT_CONTRACT_ID_HERE", contract_id.to_string()),
+        (
+            "INSERT_NETWORK_PASSPHRASE_HERE",
+            network_passphrase.to_string(),
+        ),
+        ("INSERT_RPC_URL_HERE", rpc_url.to_string()),
+    ]
+}
+
+/// What is appended to the template's index.ts: the networks and the types and client of the
+/// contract.
+fn index_ts_suffix(spec: &[ScSpecEntry], contract_id: &str, network_passphrase: &str) -> String {
+    let networks = Project::format_networks_object(contract_id, network_passphrase);
+    let types_and_fns = generate(spec);
+    format!("\n\n{networks}\n\n{types_and_fns}")
+}
+
+fn template_files(dir: &'static Dir<'static>, files: &mut Vec<&'static File<'static>>) {
+    for entry in dir.entries() {
+        match entry {
+            DirEntry::Dir(dir) => template_files(dir, files),
+            DirEntry::File(file) => files.push(file),
+        }
+    }
+}
+
 #[cfg(test)]
 mod test {
     use temp_dir::TempDir;
@@ -173,6 +267,31 @@ mod test {
         println!("Updated Snapshot!");
     }
 
+    #[test]
+    fn write_changed_only_writes_changed_files() {
+        let args = (
+            "test_custom_types",
+            "CA3D5KRYM6CB7OWQ6TWYRR3Z4T7GNZLKERYNZGGA5SOAOPIFY6YQGAXE",
+            "https://rpc-futurenet.stellar.org:443",
+            "Test SDF Future Network ; October 2022",
+        );
+        let temp_dir = TempDir::new().unwrap();
+        let p: Project = temp_dir.path().to_path_buf().try_into().unwrap();
+        p.init(args.0, args.1, args.2, args.3, &[]).unwrap();
+
+        let files = Project::files(args.0, args.1, args.2, args.3, &[]);
+        assert!(p.write_changed(&files).unwrap().is_empty());
+
+        let other_id = "CBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB";
+        let files = Project::files(args.0, other_id, args.2, args.3, &[]);
+        let mut written = p.write_changed(&files).unwrap();
+        written.sort();
+        assert_eq!(
+            written,
+            [PathBuf::from("README.md"), PathBuf::from("src/index.ts")]
+        );
+    }
+
     fn assert_dirs_equal<P: AsRef<Path>>(dir1: P, dir2: P) {
         let walker1 = WalkDir::new(&dir1);
         let walker2 = WalkDir::new(&dir2);
@@ -17,6 +17,9 @@
 //! - `TestEnv::cmd_arr` is a generic function which takes an array of `&str` which is passed directly to clap.
 //!    This is the preferred way since it ensures no string parsing footguns.
 //! - `TestEnv::invoke` a convenience function for using the invoke command.
+//! - `TestEnv::new` gives each `TestEnv` its own funded `test` account, leased from accounts funded
+//!    once per run, so that tests can run in parallel. `TestEnv::install` likewise installs each
+//!    contract once per run.
 //!
 #![allow(
     clippy::missing_errors_doc,
@@ -34,7 +37,9 @@ use soroban_cli::{
     CommandParser,
 };
 
+mod pool;
 mod wasm;
+pub use pool::{Lease, Pool};
 pub use wasm::Wasm;
 
 pub const TEST_ACCOUNT: &str = "test";
@@ -58,6 +63,8 @@ pub enum Error {
 pub struct TestEnv {
     pub temp_dir: TempDir,
     pub rpc_url: String,
+    /// The account the `test` identity is, returned to the pool when the `TestEnv` is dropped.
+    pub account: Option<Lease>,
 }
 
 impl Default for TestEnv {
@@ -66,6 +73,7 @@ impl Default for TestEnv {
         Self {
             temp_dir,
             rpc_url: "http://localhost:8889/soroban/rpc".to_string(),
+            account: None,
         }
     }
 }
@@ -99,12 +107,21 @@ impl TestEnv {
     }
 
     pub fn with_rpc_url(rpc_url: &str) -> TestEnv {
+        let account = Pool::for_rpc_url(rpc_url).lease();
         let env = TestEnv {
             rpc_url: rpc_url.to_string(),
             ..Default::default()
         };
-        env.generate_account("test", None).assert().success();
-        env
+        config::locator::Args {
+            global: false,
+            config_dir: Some(env.dir().to_path_buf()),
+        }
+        .write_identity(TEST_ACCOUNT, account.secret())
+        .unwrap();
+        TestEnv {
+            account: Some(account),
+            ..env
+        }
     }
 
     pub fn new() -> TestEnv {
@@ -145,6 +162,12 @@ impl TestEnv {
         cmd
     }
 
+    /// Installs `wasm` with the test account and returns its hash. Each contract is only installed
+    /// once per run on each RPC server, however many tests install it.
+    pub fn install(&self, wasm: &Wasm) -> String {
+        pool::install(self, wasm)
+    }
+
     pub fn fund_account(&self, account: &str) -> Assert {
         self.new_assert_cmd("keys")
             .arg("fund")
@@ -225,6 +248,7 @@ impl TestEnv {
                 rpc_url: Some(self.rpc_url.clone()),
                 network_passphrase: Some(LOCAL_NETWORK_PASSPHRASE.to_string()),
                 network: None,
+                ..Default::default()
             },
             source_account: account.to_string(),
             locator: config::locator::Args {
@@ -251,6 +275,7 @@ impl TestEnv {
                 very_verbose: false,
                 list: false,
                 no_cache: false,
+                metrics: None,
             }),
             Some(&config),
         )
@@ -278,9 +303,14 @@ impl TestEnv {
             .to_string()
     }
 
-    /// Copy the contents of the current `TestEnv` to another `TestEnv`
+    /// Copy the contents of the current `TestEnv` to another `TestEnv`, which shares its account
+    /// instead of leasing one of its own.
     pub fn fork(&self) -> Result<TestEnv, Error> {
-        let this = TestEnv::new();
+        let this = TestEnv {
+            rpc_url: self.rpc_url.clone(),
+            account: self.account.clone(),
+            ..Default::default()
+        };
         self.save(&this.temp_dir)?;
         Ok(this)
     }
@@ -0,0 +1,141 @@
+//! State shared by the tests of a run: accounts funded once and leased to one `TestEnv` at a
+//! time, and the hashes of the contracts installed so far.
+//!
+//! Funding an account through friendbot for every test serializes the tests on it, and tests
+//! sharing an account race each other for its sequence numbers. Instead, the first `TestEnv` of a
+//! run funds `SOROBAN_TEST_ACCOUNTS` accounts at once, by default one for each core, and every
+//! `TestEnv` then leases one for itself. When all are in use another account is funded rather than
+//! waiting for one to be returned, as the test holding it may be the one asking.
+
+use std::{
+    collections::BTreeMap,
+    num::NonZeroUsize,
+    sync::{Arc, Mutex, MutexGuard, OnceLock, PoisonError},
+    thread,
+};
+
+use soroban_cli::commands::config::{locator, secret::Secret};
+
+use crate::{AssertExt, TestEnv, Wasm};
+
+/// Number of accounts funded for each RPC server, overriding the number of cores.
+pub const ACCOUNTS_ENV: &str = "SOROBAN_TEST_ACCOUNTS";
+
+static POOLS: Mutex<BTreeMap<String, Arc<Pool>>> = Mutex::new(BTreeMap::new());
+
+static INSTALLED: Mutex<BTreeMap<(String, [u8; 32]), Arc<OnceLock<String>>>> =
+    Mutex::new(BTreeMap::new());
+
+fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    // A test panicking while holding the lock leaves the state consistent.
+    mutex.lock().unwrap_or_else(PoisonError::into_inner)
+}
+
+/// The accounts funded on one RPC server.
+pub struct Pool {
+    rpc_url: String,
+    size: usize,
+    funded: OnceLock<()>,
+    free: Mutex<Vec<Arc<Secret>>>,
+}
+
+/// An account leased from a [`Pool`], returned to it when the lease and all its clones are
+/// dropped.
+#[derive(Clone)]
+pub struct Lease(Arc<Leased>);
+
+struct Leased {
+    pool: Arc<Pool>,
+    secret: Arc<Secret>,
+}
+
+impl Pool {
+    /// The pool of accounts funded on `rpc_url`, created on first use.
+    pub fn for_rpc_url(rpc_url: &str) -> Arc<Pool> {
+        lock(&POOLS)
+            .entry(rpc_url.to_string())
+            .or_insert_with(|| {
+                let size = std::env::var(ACCOUNTS_ENV)
+                    .ok()
+                    .and_then(|n| n.parse().ok())
+                    .unwrap_or_else(|| thread::available_parallelism().map_or(1, NonZeroUsize::get))
+                    .max(1);
+                Arc::new(Pool {
+                    rpc_url: rpc_url.to_string(),
+                    size,
+                    funded: OnceLock::new(),
+                    free: Mutex::new(Vec::new()),
+                })
+            })
+            .clone()
+    }
+
+    /// Leases an account no other `TestEnv` is using, funding the accounts of the pool first if
+    /// this is the first lease, or funding one more if all of them are in use.
+    pub fn lease(self: &Arc<Self>) -> Lease {
+        self.funded
+            .get_or_init(|| lock(&self.free).extend(self.fund(self.size)));
+        let free = lock(&self.free).pop();
+        let secret = free.unwrap_or_else(|| self.fund(1).pop().expect("funded one account"));
+        Lease(Arc::new(Leased {
+            pool: self.clone(),
+            secret,
+        }))
+    }
+
+    /// Generates and funds `count` accounts at once.
+    fn fund(&self, count: usize) -> Vec<Arc<Secret>> {
+        let env = TestEnv {
+            rpc_url: self.rpc_url.clone(),
+            ..Default::default()
+        };
+        let names = (0..count).map(|i| format!("pool-{i}")).collect::<Vec<_>>();
+        thread::scope(|s| {
+            for name in &names {
+                let env = &env;
+                s.spawn(move || env.generate_account(name, None).assert().success());
+            }
+        });
+        let locator = locator::Args {
+            global: false,
+            config_dir: Some(env.dir().to_path_buf()),
+        };
+        names
+            .iter()
+            .map(|name| Arc::new(locator.read_identity(name).unwrap()))
+            .collect()
+    }
+}
+
+impl Lease {
+    /// The seed phrase of the account, funded at hd path 0.
+    pub fn secret(&self) -> &Secret {
+        &self.0.secret
+    }
+}
+
+impl Drop for Leased {
+    fn drop(&mut self) {
+        lock(&self.pool.free).push(self.secret.clone());
+    }
+}
+
+/// Installs `wasm` with the account of `env`, once per run for each RPC server, returning its
+/// hash. Tests installing the same contract at the same time wait for the first to finish.
+pub fn install(env: &TestEnv, wasm: &Wasm) -> String {
+    let installed = lock(&INSTALLED)
+        .entry((env.rpc_url.clone(), wasm.hash().unwrap().0))
+        .or_default()
+        .clone();
+    installed
+        .get_or_init(|| {
+            env.new_assert_cmd("contract")
+                .arg("install")
+                .arg("--wasm")
+                .arg(wasm.path())
+                .assert()
+                .success()
+                .stdout_as_str()
+        })
+        .clone()
+}
@@ -211,5 +211,5 @@ fn parse_enum_const() {
 
 fn get_spec() -> Spec {
     let res = soroban_spec::read::from_wasm(&CUSTOM_TYPES.bytes()).unwrap();
-    Spec(Some(res))
+    Spec::new(res)
 }
@@ -1,3 +1,4 @@
+use sha2::{Digest, Sha256};
 use soroban_cli::commands;
 use soroban_sdk::xdr::{Limits, WriteXdr};
 use soroban_test::{TestEnv, Wasm};
@@ -23,6 +24,18 @@ where
 
 pub const TEST_SALT: &str = "f55ff16f66f43360266b95db6f8fec01d76031054306ae4a4b380598f6cfd114";
 
+/// A salt of its own for each `TestEnv`, as a pooled account deploys the same contracts for each
+/// test it is leased to.
+pub fn test_salt(sandbox: &TestEnv) -> String {
+    Sha256::new()
+        .chain_update(TEST_SALT)
+        .chain_update(sandbox.dir().to_string_lossy().as_bytes())
+        .finalize()
+        .iter()
+        .map(|b| format!("{b:02x}"))
+        .collect()
+}
+
 pub enum DeployKind {
     BuildOnly,
     Normal,
@@ -60,13 +73,20 @@ pub async fn deploy_contract(
     wasm: &Wasm<'static>,
     deploy: DeployKind,
 ) -> String {
+    // Contracts are installed once per run, and only deployed by each test.
+    let (wasm_arg, wasm_value) = match deploy {
+        DeployKind::BuildOnly | DeployKind::SimOnly => {
+            ("--wasm", wasm.path().display().to_string())
+        }
+        DeployKind::Normal => ("--wasm-hash", sandbox.install(wasm)),
+    };
     let cmd = sandbox.cmd_with_config::<_, commands::contract::deploy::wasm::Cmd>(&[
         "--fee",
         "1000000",
-        "--wasm",
-        &wasm.path().to_string_lossy(),
+        wasm_arg,
+        &wasm_value,
         "--salt",
-        TEST_SALT,
+        &test_salt(sandbox),
         "--ignore-checks",
         deploy.to_string().as_str(),
     ]);
@@ -5,6 +5,7 @@ use ledger_transport_hid::{
     LedgerHIDError, TransportNativeHID,
 };
 
+use sha2::{Digest, Sha256};
 use soroban_env_host::xdr::{Hash, Transaction};
 use std::vec;
 use stellar_strkey::DecodeError;
@@ -42,6 +43,7 @@ const P2_SIGN_TX_MORE: u8 = 0x80;
 const GET_APP_CONFIGURATION: u8 = 0x06;
 const P1_GET_APP_CONFIGURATION: u8 = 0x00;
 const P2_GET_APP_CONFIGURATION: u8 = 0x00;
+const HASH_SIGNING_ENABLED: u8 = 0x01;
 
 const SIGN_TX_HASH: u8 = 0x08;
 const P1_SIGN_TX_HASH: u8 = 0x00;
@@ -134,51 +136,54 @@ where
         transaction: Transaction,
         network_id: Hash,
     ) -> Result<Vec<u8>, Error> {
-        let tagged_transaction = TransactionSignaturePayloadTaggedTransaction::Tx(transaction);
-        let signature_payload = TransactionSignaturePayload {
-            network_id,
-            tagged_transaction,
-        };
-        let mut signature_payload_as_bytes = signature_payload.to_xdr(Limits::none())?;
-
-        let mut hd_path_to_bytes = hd_path.into().to_vec()?;
-
-        let capacity = 1 + hd_path_to_bytes.len() + signature_payload_as_bytes.len();
-        let mut data: Vec<u8> = Vec::with_capacity(capacity);
-
-        data.insert(0, HD_PATH_ELEMENTS_COUNT);
-        data.append(&mut hd_path_to_bytes);
-        data.append(&mut signature_payload_as_bytes);
-
-        let chunks = data.chunks(CHUNK_SIZE as usize);
-        let chunks_count = chunks.len();
-
-        let mut result = Vec::with_capacity(SIGN_TX_RESPONSE_SIZE);
-        for (i, chunk) in chunks.enumerate() {
-            let is_first_chunk = i == 0;
-            let is_last_chunk = chunks_count == i + 1;
+        let commands = sign_tx_commands(&hd_path.into(), transaction, network_id)?;
+        self.send_commands_to_ledger(commands).await
+    }
 
-            let command = APDUCommand {
-                cla: CLA,
-                ins: SIGN_TX,
-                p1: if is_first_chunk {
-                    P1_SIGN_TX_FIRST
-                } else {
-                    P1_SIGN_TX_NOT_FIRST
-                },
-                p2: if is_last_chunk {
-                    P2_SIGN_TX_LAST
+    /// Sign many Stellar transactions, in order, with the account on the Ledger device
+    ///
+    /// Every payload is serialized and split into APDU commands before the first one is sent, so
+    /// that between prompts the device only waits on the operator. When hash signing is enabled
+    /// on the device, the hash of each transaction is signed instead, needing a single command
+    /// per transaction.
+    /// # Errors
+    /// Returns an error if there is an issue with connecting with the device or signing any of the given txs on the device
+    pub async fn sign_transactions(
+        &self,
+        hd_path: impl Into<HdPath>,
+        transactions: impl IntoIterator<Item = Transaction>,
+        network_id: Hash,
+    ) -> Result<Vec<Vec<u8>>, Error> {
+        let hd_path = hd_path.into();
+        let hash_signing = self.hash_signing_enabled().await?;
+        let commands = transactions
+            .into_iter()
+            .map(|transaction| {
+                if hash_signing {
+                    let payload =
+                        signature_payload(transaction, network_id.clone()).to_xdr(Limits::none())?;
+                    Ok(vec![sign_hash_command(
+                        &hd_path,
+                        &Sha256::digest(&payload),
+                    )?])
                 } else {
-                    P2_SIGN_TX_MORE
-                },
-                data: chunk.to_vec(),
-            };
+                    sign_tx_commands(&hd_path, transaction, network_id.clone())
+                }
+            })
+            .collect::<Result<Vec<_>, Error>>()?;
 
-            let mut r = self.send_command_to_ledger(command).await?;
-            result.append(&mut r);
+        let mut signatures = Vec::with_capacity(commands.len());
+        for commands in commands {
+            signatures.push(self.send_commands_to_ledger(commands).await?);
         }
+        Ok(signatures)
+    }
 
-        Ok(result)
+    /// Whether the device's Stellar app allows signing transaction hashes, as reported in the
+    /// first byte of its configuration
+    async fn hash_signing_enabled(&self) -> Result<bool, Error> {
+        let config = self.get_app_configuration().await?;
+        Ok(config.first() == Some(&HASH_SIGNING_ENABLED))
     }
 
     /// The `display_and_confirm` bool determines if the Ledger will display the public key on its screen and requires user approval to share
@@ -216,6 +221,19 @@ where
             .and_then(|p| Ok(stellar_strkey::ed25519::PublicKey::from_payload(&p)?))
     }
 
+    /// Sends the commands of a single signature in order, concatenating their responses
+    async fn send_commands_to_ledger(
+        &self,
+        commands: Vec<APDUCommand<Vec<u8>>>,
+    ) -> Result<Vec<u8>, Error> {
+        let mut result = Vec::with_capacity(SIGN_TX_RESPONSE_SIZE);
+        for command in commands {
+            let mut r = self.send_command_to_ledger(command).await?;
+            result.append(&mut r);
+        }
+        Ok(result)
+    }
+
     async fn send_command_to_ledger(
         &self,
         command: APDUCommand<Vec<u8>>,
@@ -265,25 +283,82 @@ where
     /// # Errors
     /// Returns an error if there is an issue with connecting with the device or signing the given tx on the device. Or, if the device has not enabled hash signing
     async fn sign_blob(&self, index: &Self::Key, blob: &[u8]) -> Result<Vec<u8>, Error> {
-        let mut hd_path_to_bytes = index.to_vec()?;
+        self.send_command_to_ledger(sign_hash_command(index, blob)?)
+            .await
+    }
+}
 
-        let capacity = 1 + hd_path_to_bytes.len() + blob.len();
-        let mut data: Vec<u8> = Vec::with_capacity(capacity);
+fn signature_payload(transaction: Transaction, network_id: Hash) -> TransactionSignaturePayload {
+    TransactionSignaturePayload {
+        network_id,
+        tagged_transaction: TransactionSignaturePayloadTaggedTransaction::Tx(transaction),
+    }
+}
 
-        data.insert(0, HD_PATH_ELEMENTS_COUNT);
-        data.append(&mut hd_path_to_bytes);
-        data.extend_from_slice(blob);
+/// Builds the commands signing `transaction`, its payload split into as many chunks as needed
+fn sign_tx_commands(
+    hd_path: &HdPath,
+    transaction: Transaction,
+    network_id: Hash,
+) -> Result<Vec<APDUCommand<Vec<u8>>>, Error> {
+    let mut signature_payload_as_bytes =
+        signature_payload(transaction, network_id).to_xdr(Limits::none())?;
 
-        let command = APDUCommand {
-            cla: CLA,
-            ins: SIGN_TX_HASH,
-            p1: P1_SIGN_TX_HASH,
-            p2: P2_SIGN_TX_HASH,
-            data,
-        };
+    let mut hd_path_to_bytes = hd_path.to_vec()?;
 
-        self.send_command_to_ledger(command).await
-    }
+    let capacity = 1 + hd_path_to_bytes.len() + signature_payload_as_bytes.len();
+    let mut data: Vec<u8> = Vec::with_capacity(capacity);
+
+    data.insert(0, HD_PATH_ELEMENTS_COUNT);
+    data.append(&mut hd_path_to_bytes);
+    data.append(&mut signature_payload_as_bytes);
+
+    let chunks = data.chunks(CHUNK_SIZE as usize);
+    let chunks_count = chunks.len();
+
+    Ok(chunks
+        .enumerate()
+        .map(|(i, chunk)| {
+            let is_first_chunk = i == 0;
+            let is_last_chunk = chunks_count == i + 1;
+
+            APDUCommand {
+                cla: CLA,
+                ins: SIGN_TX,
+                p1: if is_first_chunk {
+                    P1_SIGN_TX_FIRST
+                } else {
+                    P1_SIGN_TX_NOT_FIRST
+                },
+                p2: if is_last_chunk {
+                    P2_SIGN_TX_LAST
+                } else {
+                    P2_SIGN_TX_MORE
+                },
+                data: chunk.to_vec(),
+            }
+        })
+        .collect())
+}
+
+/// Builds the command signing a hash, or any other blob, with hash signing
+fn sign_hash_command(hd_path: &HdPath, blob: &[u8]) -> Result<APDUCommand<Vec<u8>>, Error> {
+    let mut hd_path_to_bytes = hd_path.to_vec()?;
+
+    let capacity = 1 + hd_path_to_bytes.len() + blob.len();
+    let mut data: Vec<u8> = Vec::with_capacity(capacity);
+
+    data.insert(0, HD_PATH_ELEMENTS_COUNT);
+    data.append(&mut hd_path_to_bytes);
+    data.extend_from_slice(blob);
+
+    Ok(APDUCommand {
+        cla: CLA,
+        ins: SIGN_TX_HASH,
+        p1: P1_SIGN_TX_HASH,
+        p2: P2_SIGN_TX_HASH,
+        data,
+    })
 }
 
 fn get_transport() -> Result<TransportNativeHID, Error> {
@@ -492,4 +567,79 @@ mod test {
 
         mock_server.assert();
     }
+
+    #[tokio::test]
+    async fn test_sign_txs_with_hash_signing_enabled() {
+        use sha2::{Digest, Sha256};
+        use stellar_xdr::curr::{
+            Limits, TransactionSignaturePayload, TransactionSignaturePayloadTaggedTransaction,
+            WriteXdr,
+        };
+
+        let server = MockServer::start();
+        let mock_config = server.mock(|when, then| {
+            when.method(POST)
+                .path("/")
+                .json_body(json!({ "apduHex": "e006000000" }));
+            then.status(200)
+                .header("content-type", "application/json")
+                .json_body(json!({"data": "010500039000"}));
+        });
+
+        let txs = (1..=2)
+            .map(|seq_num| Transaction {
+                source_account: MuxedAccount::Ed25519(Uint256([0; 32])),
+                fee: 100,
+                seq_num: SequenceNumber(seq_num),
+                cond: Preconditions::None,
+                memo: Memo::None,
+                ext: TransactionExt::V0,
+                operations: [Operation {
+                    source_account: None,
+                    body: OperationBody::Payment(PaymentOp {
+                        destination: MuxedAccount::Ed25519(Uint256([0; 32])),
+                        asset: xdr::Asset::Native,
+                        amount: 100,
+                    }),
+                }]
+                .try_into()
+                .unwrap(),
+            })
+            .collect::<Vec<_>>();
+        let mock_signs = txs
+            .iter()
+            .enumerate()
+            .map(|(i, tx)| {
+                let payload = TransactionSignaturePayload {
+                    network_id: test_network_hash(),
+                    tagged_transaction: TransactionSignaturePayloadTaggedTransaction::Tx(
+                        tx.clone(),
+                    ),
+                }
+                .to_xdr(Limits::none())
+                .unwrap();
+                let hash = hex::encode(Sha256::digest(&payload));
+                server.mock(|when, then| {
+                    when.method(POST).path("/").json_body(
+                        json!({ "apduHex": format!("e00800002d038000002c8000009480000000{hash}") }),
+                    );
+                    then.status(200)
+                        .header("content-type", "application/json")
+                        .json_body(json!({"data": format!("{}9000", hex::encode([i as u8; 64]))}));
+                })
+            })
+            .collect::<Vec<_>>();
+
+        let ledger = ledger(&server);
+        let signatures = ledger
+            .sign_transactions(0, txs, test_network_hash())
+            .await
+            .unwrap();
+        assert_eq!(signatures, vec![vec![0u8; 64], vec![1u8; 64]]);
+
+        mock_config.assert();
+        for mock_sign in mock_signs {
+            mock_sign.assert();
+        }
+    }
 }
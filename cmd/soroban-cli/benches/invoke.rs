@@ -0,0 +1,185 @@
+//! Benchmarks of the work done locally to invoke a contract, over the fixture contracts: parsing
+//! the function call, reading cached specs and signing auth entries. Build the fixtures first
+//! with `make build-test-wasms`.
+
+use std::ffi::OsString;
+
+use criterion::{black_box, criterion_group, criterion_main, BenchmarkId, Criterion};
+use ed25519_dalek::SigningKey;
+use sha2::{Digest, Sha256};
+use soroban_cli::{
+    commands::{
+        config::{self, data, locator},
+        contract::invoke,
+    },
+    signer,
+};
+use soroban_env_host::xdr::{
+    AccountId, Hash, HostFunction, Int128Parts, InvokeContractArgs, InvokeHostFunctionOp, Memo,
+    MuxedAccount, Operation, OperationBody, Preconditions, PublicKey, ScAddress, ScSymbol, ScVal,
+    SequenceNumber, SorobanAddressCredentials, SorobanAuthorizationEntry,
+    SorobanAuthorizedFunction, SorobanAuthorizedInvocation, SorobanCredentials, Transaction,
+    TransactionExt, Uint256, VecM,
+};
+use soroban_spec_tools::Spec;
+
+const FIXTURES: [&str; 4] = ["test_token", "test_custom_types", "test_udt", "test_swap"];
+
+const NETWORK_PASSPHRASE: &str = "Test SDF Network ; September 2015";
+
+fn fixture(name: &str) -> Vec<u8> {
+    let path = std::path::Path::new(env!("CARGO_MANIFEST_DIR"))
+        .join("../../target/wasm32-unknown-unknown/test-wasms")
+        .join(name)
+        .with_extension("wasm");
+    std::fs::read(&path).unwrap_or_else(|e| {
+        panic!(
+            "cannot read {}, build the fixtures with `make build-test-wasms`: {e}",
+            path.display()
+        )
+    })
+}
+
+/// A call of each function in `spec`, with an example value for every argument.
+fn calls(spec: &Spec) -> Vec<Vec<OsString>> {
+    spec.find_functions()
+        .unwrap()
+        .map(|f| {
+            let mut slop = vec![OsString::from(f.name.to_utf8_string_lossy())];
+            for input in f.inputs.iter() {
+                if let Some(example) = spec.example(&input.type_) {
+                    slop.push(format!("--{}={example}", input.name.to_utf8_string_lossy()).into());
+                }
+            }
+            slop
+        })
+        .collect()
+}
+
+fn build_host_function_parameters(c: &mut Criterion) {
+    // Addresses are looked up as identities first, in an empty config directory.
+    let config_dir = tempfile::tempdir().unwrap();
+    let config = config::Args {
+        locator: locator::Args {
+            global: false,
+            config_dir: Some(config_dir.path().to_path_buf()),
+        },
+        ..Default::default()
+    };
+    let mut group = c.benchmark_group("build_host_function_parameters");
+    for name in FIXTURES {
+        let entries = soroban_spec::read::from_wasm(&fixture(name)).unwrap();
+        let cmds = calls(&Spec::new(entries.clone()))
+            .into_iter()
+            .map(|slop| invoke::Cmd {
+                contract_id: name.to_string(),
+                slop,
+                ..Default::default()
+            })
+            // Functions whose arguments have no example that parses are left out.
+            .filter(|cmd| {
+                cmd.build_host_function_parameters([0; 32], &entries, &config)
+                    .is_ok()
+            })
+            .collect::<Vec<_>>();
+        group.bench_with_input(BenchmarkId::from_parameter(name), &cmds, |b, cmds| {
+            b.iter(|| {
+                for cmd in cmds {
+                    black_box(
+                        cmd.build_host_function_parameters([0; 32], &entries, &config)
+                            .unwrap(),
+                    );
+                }
+            });
+        });
+    }
+    group.finish();
+}
+
+fn read_spec(c: &mut Criterion) {
+    let data_dir = tempfile::tempdir().unwrap();
+    std::env::set_var(data::XDG_DATA_HOME, data_dir.path());
+    let mut group = c.benchmark_group("read_spec");
+    for name in FIXTURES {
+        let wasm = fixture(name);
+        let hash = hex::encode(Sha256::digest(&wasm));
+        data::write_spec(&hash, &soroban_spec::read::from_wasm(&wasm).unwrap()).unwrap();
+        group.bench_with_input(BenchmarkId::from_parameter(name), &hash, |b, hash| {
+            b.iter(|| data::read_spec(black_box(hash)).unwrap());
+        });
+    }
+    group.finish();
+}
+
+/// A transaction invoking `transfer` on a token, with `auths` entries to be signed by `signer`.
+fn transfer_tx(signer: &SigningKey, auths: i64) -> Transaction {
+    let address = ScAddress::Account(AccountId(PublicKey::PublicKeyTypeEd25519(Uint256(
+        signer.verifying_key().to_bytes(),
+    ))));
+    let args = InvokeContractArgs {
+        contract_address: ScAddress::Contract(Hash([1; 32])),
+        function_name: ScSymbol("transfer".try_into().unwrap()),
+        args: vec![
+            ScVal::Address(address.clone()),
+            ScVal::Address(ScAddress::Contract(Hash([2; 32]))),
+            ScVal::I128(Int128Parts { hi: 0, lo: 100 }),
+        ]
+        .try_into()
+        .unwrap(),
+    };
+    let auth = (0..auths)
+        .map(|nonce| SorobanAuthorizationEntry {
+            credentials: SorobanCredentials::Address(SorobanAddressCredentials {
+                address: address.clone(),
+                nonce,
+                signature_expiration_ledger: 0,
+                signature: ScVal::Void,
+            }),
+            root_invocation: SorobanAuthorizedInvocation {
+                function: SorobanAuthorizedFunction::ContractFn(args.clone()),
+                sub_invocations: VecM::default(),
+            },
+        })
+        .collect::<Vec<_>>();
+    Transaction {
+        source_account: MuxedAccount::Ed25519(Uint256(signer.verifying_key().to_bytes())),
+        fee: 100,
+        seq_num: SequenceNumber(1),
+        cond: Preconditions::None,
+        memo: Memo::None,
+        operations: vec![Operation {
+            source_account: None,
+            body: OperationBody::InvokeHostFunction(InvokeHostFunctionOp {
+                host_function: HostFunction::InvokeContract(args),
+                auth: auth.try_into().unwrap(),
+            }),
+        }]
+        .try_into()
+        .unwrap(),
+        ext: TransactionExt::V0,
+    }
+}
+
+fn sign_soroban_authorizations(c: &mut Criterion) {
+    let source = SigningKey::from_bytes(&[1; 32]);
+    let signers = [SigningKey::from_bytes(&[2; 32])];
+    let mut group = c.benchmark_group("sign_soroban_authorizations");
+    for auths in [1, 4, 16] {
+        let tx = transfer_tx(&signers[0], auths);
+        group.bench_with_input(BenchmarkId::from_parameter(auths), &tx, |b, tx| {
+            b.iter(|| {
+                signer::sign_soroban_authorizations(tx, &source, &signers, 1000, NETWORK_PASSPHRASE)
+                    .unwrap()
+            });
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    build_host_function_parameters,
+    read_spec,
+    sign_soroban_authorizations
+);
+criterion_main!(benches);
@@ -2,7 +2,7 @@ use clap::CommandFactory;
 use dotenvy::dotenv;
 use tracing_subscriber::{fmt, EnvFilter};
 
-use crate::{commands, Root};
+use crate::{commands, metrics, Root};
 
 #[tokio::main]
 pub async fn main() {
@@ -70,7 +70,11 @@ pub async fn main() {
             .expect("Failed to set the global tracing subscriber");
     }
 
-    if let Err(e) = root.run().await {
+    let res = root.run().await;
+    if let Some(format) = root.global_args.metrics {
+        metrics::print(format);
+    }
+    if let Err(e) = res {
         eprintln!("error: {e}");
         std::process::exit(1);
     }
@@ -1,3 +1,6 @@
+use std::ops::Bound;
+
+use chrono::{DateTime, Utc};
 use clap::command;
 
 use super::super::super::config::locator;
@@ -19,6 +22,14 @@ pub struct Cmd {
 
     #[arg(long, short = 'l')]
     pub long: bool,
+
+    /// Only list actions performed at or after this time, e.g. `2024-06-01T00:00:00Z`
+    #[arg(long)]
+    pub since: Option<DateTime<Utc>>,
+
+    /// Only list actions performed before this time, e.g. `2024-06-01T00:00:00Z`
+    #[arg(long)]
+    pub until: Option<DateTime<Utc>>,
 }
 
 impl Cmd {
@@ -29,16 +40,29 @@ impl Cmd {
     }
 
     pub fn ls(&self) -> Result<Vec<String>, Error> {
-        Ok(data::list_ulids()?
+        Ok(data::list_ulids_in(self.range())?
             .iter()
             .map(ToString::to_string)
             .collect())
     }
 
     pub fn ls_l(&self) -> Result<Vec<String>, Error> {
-        Ok(data::list_actions()?
+        Ok(data::list_actions_in(self.range())?
             .iter()
             .map(ToString::to_string)
             .collect())
     }
+
+    /// The requested time range, in milliseconds since the unix epoch.
+    fn range(&self) -> (Bound<u64>, Bound<u64>) {
+        let ms = |time: &DateTime<Utc>| u64::try_from(time.timestamp_millis()).unwrap_or(0);
+        (
+            self.since
+                .as_ref()
+                .map_or(Bound::Unbounded, |t| Bound::Included(ms(t))),
+            self.until
+                .as_ref()
+                .map_or(Bound::Unbounded, |t| Bound::Excluded(ms(t))),
+        )
+    }
 }
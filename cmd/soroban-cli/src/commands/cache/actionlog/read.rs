@@ -1,4 +1,4 @@
-use std::{fs, io, path::PathBuf};
+use std::io::{self, Write};
 
 use super::super::super::config::locator;
 use crate::commands::config::data;
@@ -25,15 +25,9 @@ pub struct Cmd {
 
 impl Cmd {
     pub fn run(&self) -> Result<(), Error> {
-        let file = self.file()?;
-        tracing::debug!("reading file {}", file.display());
-        let mut file = fs::File::open(file).map_err(|_| Error::NotFound(self.id.clone()))?;
-        let mut stdout = io::stdout();
-        let _ = io::copy(&mut file, &mut stdout);
+        let id = ulid::Ulid::from_string(&self.id).map_err(|_| Error::NotFound(self.id.clone()))?;
+        let data = data::read_raw(&id)?.ok_or_else(|| Error::NotFound(self.id.clone()))?;
+        let _ = io::stdout().write_all(&data);
         Ok(())
     }
-
-    pub fn file(&self) -> Result<PathBuf, Error> {
-        Ok(data::actions_dir()?.join(&self.id).with_extension("json"))
-    }
 }
@@ -2,10 +2,18 @@ use crate::rpc::{GetTransactionResponse, GetTransactionResponseRaw, SimulateTran
 use directories::ProjectDirs;
 use http::Uri;
 use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+use std::ops::RangeBounds;
 use std::str::FromStr;
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
 
 use crate::xdr::{self, WriteXdr};
 
+pub mod action_log;
+mod file_lock;
+pub mod resource_history;
+pub mod spec_cache;
+
 #[derive(thiserror::Error, Debug)]
 pub enum Error {
     #[error("Failed to find project directories")]
@@ -20,6 +28,10 @@ pub enum Error {
     Ulid(#[from] ulid::DecodeError),
     #[error(transparent)]
     Xdr(#[from] xdr::Error),
+    #[error("Action {0} not found in the action log")]
+    ActionNotFound(ulid::Ulid),
+    #[error("Spec entry too large for the spec cache")]
+    SpecCacheEntryTooLarge,
 }
 
 pub const XDG_DATA_HOME: &str = "XDG_DATA_HOME";
@@ -50,63 +62,144 @@ pub fn spec_dir() -> Result<std::path::PathBuf, Error> {
     Ok(dir)
 }
 
+pub fn snapshot_dir() -> Result<std::path::PathBuf, Error> {
+    let dir = data_local_dir()?.join("snapshots");
+    std::fs::create_dir_all(&dir)?;
+    Ok(dir)
+}
+
+pub fn optimized_wasm_dir() -> Result<std::path::PathBuf, Error> {
+    let dir = data_local_dir()?.join("optimized");
+    std::fs::create_dir_all(&dir)?;
+    Ok(dir)
+}
+
+pub fn contract_dir(network_passphrase: &str) -> Result<std::path::PathBuf, Error> {
+    let network_id = hex::encode(Sha256::digest(network_passphrase.as_bytes()));
+    let dir = data_local_dir()?.join("contract").join(network_id);
+    std::fs::create_dir_all(&dir)?;
+    Ok(dir)
+}
+
+fn action_log() -> Result<action_log::Log, Error> {
+    Ok(action_log::Log::new(actions_dir()?))
+}
+
 pub fn write(action: Action, rpc_url: &Uri) -> Result<ulid::Ulid, Error> {
     let data = Data {
         action,
         rpc_url: rpc_url.to_string(),
     };
     let id = ulid::Ulid::new();
-    let file = actions_dir()?.join(id.to_string()).with_extension("json");
-    std::fs::write(file, serde_json::to_string(&data)?)?;
+    action_log()?.append(id, &serde_json::to_vec(&data)?)?;
     Ok(id)
 }
 
+/// The JSON of action `id`, if it is in the action log.
+pub fn read_raw(id: &ulid::Ulid) -> Result<Option<Vec<u8>>, Error> {
+    action_log()?.read(*id)
+}
+
 pub fn read(id: &ulid::Ulid) -> Result<(Action, Uri), Error> {
-    let file = actions_dir()?.join(id.to_string()).with_extension("json");
-    let data: Data = serde_json::from_str(&std::fs::read_to_string(file)?)?;
+    let raw = read_raw(id)?.ok_or(Error::ActionNotFound(*id))?;
+    let data: Data = serde_json::from_slice(&raw)?;
     Ok((data.action, http::Uri::from_str(&data.rpc_url)?))
 }
 
 pub fn write_spec(hash: &str, spec_entries: &[xdr::ScSpecEntry]) -> Result<(), Error> {
-    let file = spec_dir()?.join(hash);
-    tracing::trace!("writing spec to {:?}", file);
-    let mut contents: Vec<u8> = Vec::new();
-    for entry in spec_entries {
-        contents.extend(entry.to_xdr(xdr::Limits::none())?);
-    }
-    std::fs::write(file, contents)?;
-    Ok(())
+    spec_cache::write(hash, spec_entries)
 }
 
 pub fn read_spec(hash: &str) -> Result<Vec<xdr::ScSpecEntry>, Error> {
+    if let Some(spec) = spec_cache::open(hash)? {
+        return spec.entries();
+    }
+    // Specs cached before the shared cache file existed are stored in one file per hash.
     let file = spec_dir()?.join(hash);
     tracing::trace!("reading spec from {:?}", file);
     Ok(soroban_spec::read::parse_raw(&std::fs::read(file)?)?)
 }
 
+/// Reads only the entries of the spec needed to call the first function whose name matches,
+/// falling back to the whole spec when the function is not in it or the spec was cached before
+/// the shared cache file existed.
+pub fn read_function_spec(
+    hash: &str,
+    matches: impl Fn(&str) -> bool,
+) -> Result<Vec<xdr::ScSpecEntry>, Error> {
+    if let Some(spec) = spec_cache::open(hash)? {
+        if let Some(entries) = spec.function_entries(matches)? {
+            return Ok(entries);
+        }
+        return spec.entries();
+    }
+    read_spec(hash)
+}
+
+pub fn write_contract_instance(
+    contract_id: &str,
+    network_passphrase: &str,
+    instance: &ContractInstance,
+) -> Result<(), Error> {
+    let file = contract_dir(network_passphrase)?
+        .join(contract_id)
+        .with_extension("json");
+    tracing::trace!("writing contract instance to {:?}", file);
+    std::fs::write(file, serde_json::to_string(instance)?)?;
+    Ok(())
+}
+
+/// Returns the cached instance of a contract, unless it is missing or may have expired.
+pub fn read_contract_instance(
+    contract_id: &str,
+    network_passphrase: &str,
+) -> Result<Option<ContractInstance>, Error> {
+    let file = contract_dir(network_passphrase)?
+        .join(contract_id)
+        .with_extension("json");
+    let Ok(contents) = std::fs::read_to_string(&file) else {
+        return Ok(None);
+    };
+    tracing::trace!("reading contract instance from {:?}", file);
+    let instance: ContractInstance = serde_json::from_str(&contents)?;
+    Ok(instance.is_live().then_some(instance))
+}
+
+pub fn remove_contract_instance(contract_id: &str, network_passphrase: &str) -> Result<(), Error> {
+    let file = contract_dir(network_passphrase)?
+        .join(contract_id)
+        .with_extension("json");
+    match std::fs::remove_file(file) {
+        Err(e) if e.kind() != std::io::ErrorKind::NotFound => Err(e.into()),
+        _ => Ok(()),
+    }
+}
+
 pub fn list_ulids() -> Result<Vec<ulid::Ulid>, Error> {
-    let dir = actions_dir()?;
-    let mut list = std::fs::read_dir(dir)?
-        .map(|entry| {
-            entry
-                .map(|e| e.file_name().into_string().unwrap())
-                .map_err(Error::from)
-        })
-        .collect::<Result<Vec<String>, Error>>()?;
-    list.sort();
-    Ok(list
-        .iter()
-        .map(|s| ulid::Ulid::from_str(s.trim_end_matches(".json")))
-        .collect::<Result<Vec<_>, _>>()?)
+    list_ulids_in(..)
+}
+
+/// Ids of the actions performed in `range`, in milliseconds since the unix epoch.
+pub fn list_ulids_in(range: impl RangeBounds<u64>) -> Result<Vec<ulid::Ulid>, Error> {
+    action_log()?.ids(range)
 }
 
 pub fn list_actions() -> Result<Vec<DatedAction>, Error> {
-    list_ulids()?
+    list_actions_in(..)
+}
+
+pub fn list_actions_in(range: impl RangeBounds<u64>) -> Result<Vec<DatedAction>, Error> {
+    action_log()?
+        .records(range)?
         .into_iter()
         .rev()
-        .map(|id| {
-            let (action, uri) = read(&id)?;
-            Ok(DatedAction(id, action, uri))
+        .map(|(id, raw)| {
+            let data: Data = serde_json::from_slice(&raw)?;
+            Ok(DatedAction(
+                id,
+                data.action,
+                http::Uri::from_str(&data.rpc_url)?,
+            ))
         })
         .collect::<Result<Vec<_>, Error>>()
 }
@@ -122,7 +215,8 @@ impl std::fmt::Display for DatedAction {
                 .error
                 .as_ref()
                 .map_or_else(|| "SUCCESS".to_string(), |_| "ERROR".to_string()),
-            Action::Send { response } => response.status.to_string(),
+            Action::Send { response, .. } => response.status.to_string(),
+            Action::Pending { .. } => "PENDING".to_string(),
         };
         write!(f, "{id} {} {status} {datetime} {uri} ", a.type_str(),)
     }
@@ -134,6 +228,46 @@ fn to_datatime(id: &ulid::Ulid) -> chrono::DateTime<chrono::Utc> {
     chrono::DateTime::from_timestamp_millis(id.timestamp_ms().try_into().unwrap()).unwrap()
 }
 
+/// Average time between ledgers, used to estimate the current ledger from a cached one.
+const LEDGER_CLOSE_TIME: Duration = Duration::from_secs(5);
+
+/// Where a contract's code lives, as of `latest_ledger`, and until when its instance is live.
+#[derive(Serialize, Deserialize, Clone, Debug, PartialEq, Eq)]
+#[serde(rename_all = "snake_case")]
+pub struct ContractInstance {
+    /// Hex encoded hash of the contract's wasm, or `None` for a Stellar Asset Contract.
+    pub wasm_hash: Option<String>,
+    pub live_until_ledger: u32,
+    pub latest_ledger: u32,
+    /// Seconds since the unix epoch at which `latest_ledger` was observed.
+    pub fetched_at: u64,
+}
+
+impl ContractInstance {
+    pub fn new(wasm_hash: Option<String>, live_until_ledger: u32, latest_ledger: u32) -> Self {
+        Self {
+            wasm_hash,
+            live_until_ledger,
+            latest_ledger,
+            fetched_at: now().as_secs(),
+        }
+    }
+
+    /// Whether the instance is expected to still be live, estimating the current ledger from
+    /// the time passed since it was fetched.
+    pub fn is_live(&self) -> bool {
+        let elapsed = now().saturating_sub(Duration::from_secs(self.fetched_at));
+        let ledgers = elapsed.as_secs() / LEDGER_CLOSE_TIME.as_secs();
+        u64::from(self.latest_ledger) + ledgers < u64::from(self.live_until_ledger)
+    }
+}
+
+fn now() -> Duration {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .unwrap_or_default()
+}
+
 #[derive(Serialize, Deserialize)]
 #[serde(rename_all = "snake_case")]
 struct Data {
@@ -149,6 +283,14 @@ pub enum Action {
     },
     Send {
         response: GetTransactionResponseRaw,
+        /// Hex encoded hash of the transaction, for transactions that were pending.
+        #[serde(default, skip_serializing_if = "Option::is_none")]
+        hash: Option<String>,
+    },
+    /// A transaction sent without waiting for it to be applied, see [`pending_hashes`].
+    Pending {
+        /// Hex encoded hash of the transaction.
+        hash: String,
     },
 }
 
@@ -157,6 +299,7 @@ impl Action {
         match self {
             Action::Simulate { .. } => "Simulate",
             Action::Send { .. } => "Send    ",
+            Action::Pending { .. } => "Pending ",
         }
         .to_string()
     }
@@ -178,10 +321,41 @@ impl TryFrom<GetTransactionResponse> for Action {
                 result_xdr: res.result.as_ref().map(to_xdr).transpose()?,
                 result_meta_xdr: res.result_meta.as_ref().map(to_xdr).transpose()?,
             },
+            hash: None,
         })
     }
 }
 
+/// How far back the action log is searched for pending transactions. RPC servers only keep
+/// recent transactions, so older ones could not be confirmed anyway.
+const PENDING_WINDOW: Duration = Duration::from_secs(24 * 60 * 60);
+
+/// Hashes of the transactions sent to `rpc_url` without waiting, that have not been recorded
+/// as applied since, in the order they were sent.
+pub fn pending_hashes(rpc_url: &Uri) -> Result<Vec<String>, Error> {
+    let since = now().saturating_sub(PENDING_WINDOW).as_millis();
+    let actions = action_log()?
+        .records(u64::try_from(since).unwrap_or_default()..)?
+        .into_iter()
+        .map(|(_, raw)| serde_json::from_slice(&raw))
+        .collect::<Result<Vec<Data>, _>>()?;
+    Ok(pending_in(actions, &rpc_url.to_string()))
+}
+
+fn pending_in(actions: impl IntoIterator<Item = Data>, rpc_url: &str) -> Vec<String> {
+    let mut pending = Vec::new();
+    for data in actions.into_iter().filter(|data| data.rpc_url == rpc_url) {
+        match data.action {
+            Action::Pending { hash } => pending.push(hash),
+            Action::Send {
+                hash: Some(hash), ..
+            } => pending.retain(|h| *h != hash),
+            _ => {}
+        }
+    }
+    pending
+}
+
 fn to_xdr(data: &impl WriteXdr) -> Result<String, xdr::Error> {
     data.to_xdr_base64(xdr::Limits::none())
 }
@@ -208,4 +382,45 @@ mod test {
             _ => panic!("Action mismatch"),
         }
     }
+
+    #[test]
+    fn test_pending_in() {
+        let data = |action, rpc_url: &str| Data {
+            action,
+            rpc_url: rpc_url.to_string(),
+        };
+        let pending = |hash: &str| Action::Pending {
+            hash: hash.to_string(),
+        };
+        let actions = [
+            data(pending("aa"), "http://localhost:8000/"),
+            data(pending("bb"), "http://localhost:8000/"),
+            data(pending("cc"), "http://localhost:8001/"),
+            data(
+                Action::Send {
+                    response: GetTransactionResponseRaw {
+                        status: "SUCCESS".to_string(),
+                        envelope_xdr: None,
+                        result_xdr: None,
+                        result_meta_xdr: None,
+                    },
+                    hash: Some("aa".to_string()),
+                },
+                "http://localhost:8000/",
+            ),
+        ];
+        assert_eq!(pending_in(actions, "http://localhost:8000/"), ["bb"]);
+    }
+
+    #[test]
+    fn test_contract_instance_expiry() {
+        let live = ContractInstance::new(None, 1_000, 100);
+        assert!(live.is_live());
+        let expired = ContractInstance::new(None, 101, 100);
+        assert!(!ContractInstance {
+            fetched_at: expired.fetched_at - 10,
+            ..expired
+        }
+        .is_live());
+    }
 }
@@ -0,0 +1,448 @@
+//! Append-only log of the actions, simulations and transactions, that the CLI performed.
+//!
+//! Actions are appended to segment files in [`super::actions_dir`], each named after the id of
+//! the first action written to it. Once a segment grows past [`SEGMENT_SIZE`], later actions go
+//! to a new one. Each action is one record:
+//!
+//! ```text
+//! id: u128      the ulid of the action, big endian
+//! len: u32      length of the data, little endian
+//! data: [u8]    the action as JSON
+//! ```
+//!
+//! A record is appended with a single write, under a lock so that a record left incomplete by a
+//! process that died is cut off before the next one is appended after it. Every segment has an
+//! index of the ids in it and their offsets, brought up to date when the log is read:
+//!
+//! ```text
+//! indexed_len: u64                 length of the segment covered by the index
+//! entries: [id: u128, offset: u64]
+//! ```
+//!
+//! Actions that older versions stored as one JSON file each are moved into the log the first
+//! time it is read.
+
+use std::{
+    fs::{self, OpenOptions},
+    io::{self, Read, Seek, SeekFrom, Write},
+    ops::{Bound, RangeBounds},
+    path::{Path, PathBuf},
+    str::FromStr,
+    time::{SystemTime, UNIX_EPOCH},
+};
+
+use ulid::Ulid;
+
+use super::{file_lock::FileLock, Error};
+
+/// Size past which a segment is no longer appended to.
+const SEGMENT_SIZE: u64 = 4 * 1024 * 1024;
+const SEGMENT_EXTENSION: &str = "log";
+const INDEX_EXTENSION: &str = "idx";
+const RECORD_HEADER_LEN: usize = 16 + 4;
+const INDEX_ENTRY_LEN: usize = 16 + 8;
+/// How far the clocks of the processes appending to a segment are assumed to drift apart.
+const MAX_CLOCK_SKEW_MS: u64 = 24 * 60 * 60 * 1000;
+
+pub struct Log {
+    dir: PathBuf,
+    segment_size: u64,
+}
+
+impl Log {
+    pub fn new(dir: PathBuf) -> Self {
+        Self {
+            dir,
+            segment_size: SEGMENT_SIZE,
+        }
+    }
+
+    pub fn append(&self, id: Ulid, data: &[u8]) -> Result<(), Error> {
+        let segment = match self.segments()?.pop() {
+            Some((_, segment)) if fs::metadata(&segment)?.len() < self.segment_size => segment,
+            _ => self.segment_path(id),
+        };
+        let _lock = FileLock::acquire(&segment)?;
+        if segment.exists() {
+            let (indexed_len, _) = self.update_index(&segment)?;
+            if fs::metadata(&segment)?.len() > indexed_len {
+                tracing::debug!("cutting off an incomplete record at the end of {segment:?}");
+                OpenOptions::new()
+                    .write(true)
+                    .open(&segment)?
+                    .set_len(indexed_len)?;
+            }
+        }
+        append_records(&segment, &[(id, data)], false)?;
+        Ok(())
+    }
+
+    /// The data of action `id`, if it is in the log.
+    pub fn read(&self, id: Ulid) -> Result<Option<Vec<u8>>, Error> {
+        self.migrate()?;
+        // Actions are most likely in the segment with the closest start before them.
+        let mut segments = self.segments()?;
+        segments.reverse();
+        let (before, after): (Vec<_>, Vec<_>) =
+            segments.into_iter().partition(|(start, _)| *start <= id);
+        for (_, segment) in before.into_iter().chain(after) {
+            if let Some(&(_, offset)) = self.index(&segment)?.iter().find(|(i, _)| *i == id) {
+                return Ok(Some(read_record(&segment, offset)?));
+            }
+        }
+        Ok(None)
+    }
+
+    /// Ids of the actions performed in `range`, in milliseconds since the unix epoch, sorted.
+    pub fn ids(&self, range: impl RangeBounds<u64>) -> Result<Vec<Ulid>, Error> {
+        let mut ids = self
+            .indexes_in(&range)?
+            .into_iter()
+            .flat_map(|(_, entries)| entries.into_iter().map(|(id, _)| id))
+            .collect::<Vec<_>>();
+        ids.sort();
+        Ok(ids)
+    }
+
+    /// The ids and data of the actions performed in `range`, sorted by id. Each segment is
+    /// indexed and read once.
+    pub fn records(&self, range: impl RangeBounds<u64>) -> Result<Vec<(Ulid, Vec<u8>)>, Error> {
+        let mut records = Vec::new();
+        for (segment, entries) in self.indexes_in(&range)? {
+            if entries.is_empty() {
+                continue;
+            }
+            let bytes = fs::read(&segment)?;
+            for (id, offset) in entries {
+                let data = usize::try_from(offset)
+                    .ok()
+                    .and_then(|offset| record_data(&bytes, offset))
+                    .ok_or_else(|| invalid_record(&segment, offset))?;
+                records.push((id, data.to_vec()));
+            }
+        }
+        records.sort_by_key(|(id, _)| *id);
+        Ok(records)
+    }
+
+    /// The index entries of the actions performed in `range`, for each segment that may have
+    /// some.
+    fn indexes_in(
+        &self,
+        range: &impl RangeBounds<u64>,
+    ) -> Result<Vec<(PathBuf, Vec<(Ulid, u64)>)>, Error> {
+        self.migrate()?;
+        let mut indexes = Vec::new();
+        for (start, segment) in self.segments()? {
+            // Segments start with their earliest action, later ones only hold later actions.
+            let after_range = match range.end_bound() {
+                Bound::Included(end) => start.timestamp_ms() > *end,
+                Bound::Excluded(end) => start.timestamp_ms() >= *end,
+                Bound::Unbounded => false,
+            };
+            if after_range {
+                break;
+            }
+            let mut entries = self.index(&segment)?;
+            entries.retain(|(id, _)| range.contains(&id.timestamp_ms()));
+            indexes.push((segment, entries));
+        }
+        Ok(indexes)
+    }
+
+    fn segment_path(&self, start: Ulid) -> PathBuf {
+        self.dir
+            .join(start.to_string())
+            .with_extension(SEGMENT_EXTENSION)
+    }
+
+    /// Every segment with the id it starts at, in order.
+    fn segments(&self) -> Result<Vec<(Ulid, PathBuf)>, Error> {
+        let mut segments = Vec::new();
+        for entry in fs::read_dir(&self.dir)? {
+            let path = entry?.path();
+            if path.extension().and_then(|e| e.to_str()) != Some(SEGMENT_EXTENSION) {
+                continue;
+            }
+            if let Some(start) = file_ulid(&path) {
+                segments.push((start, path));
+            }
+        }
+        segments.sort();
+        Ok(segments)
+    }
+
+    /// The index of `segment`, after adding the records appended since it was last updated.
+    fn index(&self, segment: &Path) -> Result<Vec<(Ulid, u64)>, Error> {
+        Ok(self.update_index(segment)?.1)
+    }
+
+    /// Brings the index of `segment` up to date, returning it along with the length of the
+    /// segment it covers. Indexing stops at the first record that is incomplete or whose header
+    /// is not one `append` writes, as nothing after it can be trusted.
+    fn update_index(&self, segment: &Path) -> Result<(u64, Vec<(Ulid, u64)>), Error> {
+        let index_file = segment.with_extension(INDEX_EXTENSION);
+        let (mut indexed_len, mut entries) = match fs::read(&index_file) {
+            Ok(index) => parse_index(&index).unwrap_or_default(),
+            Err(e) if e.kind() == io::ErrorKind::NotFound => (0, Vec::new()),
+            Err(e) => return Err(e.into()),
+        };
+        if fs::metadata(segment)?.len() <= indexed_len {
+            return Ok((indexed_len, entries));
+        }
+        let start = file_ulid(segment).unwrap_or_default();
+        let mut file = fs::File::open(segment)?;
+        file.seek(SeekFrom::Start(indexed_len))?;
+        let mut tail = Vec::new();
+        file.read_to_end(&mut tail)?;
+        let mut offset = 0;
+        while let Some(header) = tail.get(offset..offset + RECORD_HEADER_LEN) {
+            let id = Ulid(u128::from_be_bytes(header[..16].try_into().unwrap()));
+            let len = u32::from_le_bytes(header[16..].try_into().unwrap()) as usize;
+            let end = offset + RECORD_HEADER_LEN + len;
+            // A record being written by another process is indexed once it is complete.
+            if end > tail.len() || !plausible_id(id, start) {
+                break;
+            }
+            entries.push((id, indexed_len + offset as u64));
+            offset = end;
+        }
+        indexed_len += offset as u64;
+
+        let mut index = Vec::with_capacity(8 + entries.len() * INDEX_ENTRY_LEN);
+        index.extend(indexed_len.to_le_bytes());
+        for (id, offset) in &entries {
+            index.extend(id.0.to_be_bytes());
+            index.extend(offset.to_le_bytes());
+        }
+        // Written to a new file and renamed, so readers never see half an index.
+        let mut tmp = tempfile::NamedTempFile::new_in(&self.dir)?;
+        tmp.write_all(&index)?;
+        tmp.persist(&index_file).map_err(|e| e.error)?;
+        Ok((indexed_len, entries))
+    }
+
+    /// Moves actions stored as `{ulid}.json` files into segments of their own.
+    fn migrate(&self) -> Result<(), Error> {
+        let mut files = Vec::new();
+        for entry in fs::read_dir(&self.dir)? {
+            let path = entry?.path();
+            if path.extension().and_then(|e| e.to_str()) != Some("json") {
+                continue;
+            }
+            if let Some(id) = file_ulid(&path) {
+                files.push((id, path));
+            }
+        }
+        if files.is_empty() {
+            return Ok(());
+        }
+        files.sort();
+        tracing::debug!("moving {} actions into the action log", files.len());
+        let mut files = files.into_iter().peekable();
+        while files.peek().is_some() {
+            // Moved in segments of the usual size, each read and written in one go.
+            let mut records = Vec::new();
+            let mut size = 0;
+            while let Some((id, path)) = files.next_if(|_| size < self.segment_size) {
+                let data = fs::read(&path)?;
+                size += (RECORD_HEADER_LEN + data.len()) as u64;
+                records.push((id, path, data));
+            }
+            let segment = self.segment_path(records[0].0);
+            let to_append = records
+                .iter()
+                .map(|(id, _, data)| (*id, data.as_slice()))
+                .collect::<Vec<_>>();
+            match append_records(&segment, &to_append, true) {
+                // Another process is moving the same files.
+                Err(e) if e.kind() == io::ErrorKind::AlreadyExists => return Ok(()),
+                res => res?,
+            }
+            for (_, path, _) in records {
+                match fs::remove_file(path) {
+                    Err(e) if e.kind() != io::ErrorKind::NotFound => return Err(e.into()),
+                    _ => {}
+                }
+            }
+        }
+        Ok(())
+    }
+}
+
+fn file_ulid(path: &Path) -> Option<Ulid> {
+    Ulid::from_str(path.file_stem()?.to_str()?).ok()
+}
+
+/// Appends `records` to `segment` in a single write. With `create_new`, fails if the segment
+/// exists.
+fn append_records(segment: &Path, records: &[(Ulid, &[u8])], create_new: bool) -> io::Result<()> {
+    let len = records
+        .iter()
+        .map(|(_, data)| RECORD_HEADER_LEN + data.len())
+        .sum();
+    let mut buf = Vec::with_capacity(len);
+    for (id, data) in records {
+        let data_len = u32::try_from(data.len())
+            .map_err(|_| io::Error::new(io::ErrorKind::InvalidInput, "action too large"))?;
+        buf.extend(id.0.to_be_bytes());
+        buf.extend(data_len.to_le_bytes());
+        buf.extend_from_slice(data);
+    }
+    let mut options = OpenOptions::new();
+    if create_new {
+        options.write(true).create_new(true);
+    } else {
+        options.append(true).create(true);
+    }
+    options.open(segment)?.write_all(&buf)
+}
+
+/// Whether `id` can be that of an action appended to the segment starting at `start`, rather
+/// than bytes of a record left incomplete.
+fn plausible_id(id: Ulid, start: Ulid) -> bool {
+    let now = SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map_or(0, |d| u64::try_from(d.as_millis()).unwrap_or(u64::MAX));
+    id.timestamp_ms().saturating_add(MAX_CLOCK_SKEW_MS) >= start.timestamp_ms()
+        && id.timestamp_ms() <= now.saturating_add(MAX_CLOCK_SKEW_MS)
+}
+
+fn read_record(segment: &Path, offset: u64) -> Result<Vec<u8>, Error> {
+    let mut file = fs::File::open(segment)?;
+    let segment_len = file.metadata()?.len();
+    file.seek(SeekFrom::Start(offset))?;
+    let mut header = [0; RECORD_HEADER_LEN];
+    file.read_exact(&mut header)?;
+    let len = u32::from_le_bytes(header[16..].try_into().unwrap());
+    if offset + RECORD_HEADER_LEN as u64 + u64::from(len) > segment_len {
+        return Err(invalid_record(segment, offset));
+    }
+    let mut data = vec![0; len as usize];
+    file.read_exact(&mut data)?;
+    Ok(data)
+}
+
+/// The data of the record at `offset` in the bytes of a segment, if it is all there.
+fn record_data(segment: &[u8], offset: usize) -> Option<&[u8]> {
+    let header = segment.get(offset..offset.checked_add(RECORD_HEADER_LEN)?)?;
+    let len = u32::from_le_bytes(header[16..].try_into().ok()?) as usize;
+    let start = offset + RECORD_HEADER_LEN;
+    segment.get(start..start.checked_add(len)?)
+}
+
+fn invalid_record(segment: &Path, offset: u64) -> Error {
+    io::Error::new(
+        io::ErrorKind::InvalidData,
+        format!(
+            "incomplete record at offset {offset} of {}",
+            segment.display()
+        ),
+    )
+    .into()
+}
+
+fn parse_index(index: &[u8]) -> Option<(u64, Vec<(Ulid, u64)>)> {
+    let indexed_len = u64::from_le_bytes(index.get(..8)?.try_into().ok()?);
+    let entries = index[8..]
+        .chunks_exact(INDEX_ENTRY_LEN)
+        .map(|entry| {
+            (
+                Ulid(u128::from_be_bytes(entry[..16].try_into().unwrap())),
+                u64::from_le_bytes(entry[16..].try_into().unwrap()),
+            )
+        })
+        .collect();
+    Some((indexed_len, entries))
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn append_read_rotate_and_migrate() {
+        let dir = tempfile::tempdir().unwrap();
+        let log = Log {
+            dir: dir.path().to_path_buf(),
+            segment_size: 64,
+        };
+
+        let old = Ulid::from_parts(1_000, 1);
+        fs::write(dir.path().join(format!("{old}.json")), b"{\"old\":true}").unwrap();
+        let ids = (0..5)
+            .map(|i| {
+                let id = Ulid::from_parts(2_000 + i, 0);
+                log.append(id, format!("{{\"action\":{i}}}").as_bytes())
+                    .unwrap();
+                id
+            })
+            .collect::<Vec<_>>();
+        assert!(log.segments().unwrap().len() > 1);
+
+        assert_eq!(log.read(ids[3]).unwrap().unwrap(), b"{\"action\":3}");
+        assert_eq!(log.read(old).unwrap().unwrap(), b"{\"old\":true}");
+        assert!(!dir.path().join(format!("{old}.json")).exists());
+        assert!(log.read(Ulid::from_parts(3_000, 0)).unwrap().is_none());
+
+        let mut all = vec![old];
+        all.extend(&ids);
+        assert_eq!(log.ids(..).unwrap(), all);
+        assert_eq!(log.ids(2_001..2_003).unwrap(), ids[1..3]);
+
+        // Records appended after the index was written are picked up.
+        let last = Ulid::from_parts(2_010, 0);
+        log.append(last, b"{}").unwrap();
+        assert_eq!(log.ids(2_010..).unwrap(), [last]);
+        assert_eq!(
+            log.records(2_003..).unwrap(),
+            [
+                (ids[3], b"{\"action\":3}".to_vec()),
+                (ids[4], b"{\"action\":4}".to_vec()),
+                (last, b"{}".to_vec()),
+            ]
+        );
+    }
+
+    #[test]
+    fn incomplete_record_is_cut_off_before_appending() {
+        let dir = tempfile::tempdir().unwrap();
+        let log = Log::new(dir.path().to_path_buf());
+        let first = Ulid::from_parts(1_000, 0);
+        log.append(first, b"{\"first\":true}").unwrap();
+        let (_, segment) = log.segments().unwrap().pop().unwrap();
+        let len = fs::metadata(&segment).unwrap().len();
+
+        // A process died after writing part of a record.
+        let torn = Ulid::from_parts(1_001, 0);
+        log.append(torn, b"{\"torn\":true}").unwrap();
+        let file = OpenOptions::new().write(true).open(&segment).unwrap();
+        file.set_len(len + RECORD_HEADER_LEN as u64 + 5).unwrap();
+
+        let next = Ulid::from_parts(1_002, 0);
+        log.append(next, b"{\"next\":true}").unwrap();
+        assert_eq!(log.ids(..).unwrap(), [first, next]);
+        assert_eq!(log.read(next).unwrap().unwrap(), b"{\"next\":true}");
+        assert!(log.read(torn).unwrap().is_none());
+    }
+
+    #[test]
+    fn implausible_record_header_stops_indexing() {
+        let dir = tempfile::tempdir().unwrap();
+        let log = Log::new(dir.path().to_path_buf());
+        let first = Ulid::from_parts(1_000, 0);
+        log.append(first, b"{}").unwrap();
+        let (_, segment) = log.segments().unwrap().pop().unwrap();
+        // Bytes of a record that was written over, read as a header with an id far in the
+        // future and a huge length.
+        let mut garbage = vec![0xff; RECORD_HEADER_LEN];
+        garbage.extend(b"{}");
+        OpenOptions::new()
+            .append(true)
+            .open(&segment)
+            .unwrap()
+            .write_all(&garbage)
+            .unwrap();
+        assert_eq!(log.ids(..).unwrap(), [first]);
+    }
+}
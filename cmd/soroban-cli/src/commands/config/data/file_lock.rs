@@ -0,0 +1,80 @@
+//! Lock shared by the processes writing to the same cache file.
+//!
+//! The lock is a `<file>.lock` file that is created exclusively next to the file it guards and
+//! removed when the guard is dropped. A lock older than [`STALE_AFTER`] was left by a process that
+//! died while holding it, and is broken.
+
+use std::{
+    fs::{self, OpenOptions},
+    io,
+    path::{Path, PathBuf},
+    thread,
+    time::Duration,
+};
+
+const RETRY_INTERVAL: Duration = Duration::from_millis(10);
+/// Far longer than any writer holds the lock for.
+const STALE_AFTER: Duration = Duration::from_secs(10);
+
+pub struct FileLock {
+    path: PathBuf,
+}
+
+impl FileLock {
+    /// Waits until no other process holds the lock of `file`, then takes it.
+    pub fn acquire(file: &Path) -> io::Result<Self> {
+        let mut path = file.as_os_str().to_owned();
+        path.push(".lock");
+        let path = PathBuf::from(path);
+        loop {
+            match OpenOptions::new().write(true).create_new(true).open(&path) {
+                Ok(_) => return Ok(FileLock { path }),
+                Err(e) if e.kind() == io::ErrorKind::AlreadyExists => {
+                    if is_stale(&path) {
+                        tracing::debug!("breaking stale lock {path:?}");
+                        let _ = fs::remove_file(&path);
+                    } else {
+                        thread::sleep(RETRY_INTERVAL);
+                    }
+                }
+                Err(e) => return Err(e),
+            }
+        }
+    }
+}
+
+impl Drop for FileLock {
+    fn drop(&mut self) {
+        let _ = fs::remove_file(&self.path);
+    }
+}
+
+fn is_stale(path: &Path) -> bool {
+    fs::metadata(path)
+        .and_then(|m| m.modified())
+        .ok()
+        .and_then(|modified| modified.elapsed().ok())
+        .is_some_and(|age| age > STALE_AFTER)
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn lock_is_exclusive_and_released_on_drop() {
+        let t = assert_fs::TempDir::new().unwrap();
+        let file = t.path().join("cache.bin");
+        let lock = t.path().join("cache.bin.lock");
+        let guard = FileLock::acquire(&file).unwrap();
+        assert!(lock.exists());
+        assert!(OpenOptions::new()
+            .write(true)
+            .create_new(true)
+            .open(&lock)
+            .is_err());
+        drop(guard);
+        assert!(!lock.exists());
+        drop(FileLock::acquire(&file).unwrap());
+    }
+}
@@ -0,0 +1,403 @@
+//! History of the resources used by recent invocations of each contract function, used to
+//! choose how much to pad simulated instructions and to skip simulating repeated calls.
+//!
+//! Each function's history is a small JSON file in [`resources_dir`], kept next to the action
+//! log, under a directory per network and contract.
+
+use std::{
+    collections::VecDeque,
+    io::Write,
+    path::{Path, PathBuf},
+    time::Duration,
+};
+
+use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+
+use super::{data_local_dir, now, Error};
+use crate::xdr::{
+    Limits, OperationBody, ReadXdr, SequenceNumber, SorobanCredentials, SorobanTransactionData,
+    Transaction, TransactionExt, WriteXdr,
+};
+
+/// Number of invocations remembered per function.
+const MAX_SAMPLES: usize = 20;
+
+/// Successful invocations needed before padding is chosen from the history.
+const MIN_SAMPLES: usize = 3;
+
+/// Padding used without enough history, or once an invocation has failed, in thousandths of
+/// the simulated instructions.
+const DEFAULT_PADDING: u64 = 1_500;
+
+/// Smallest padding used, however steady the simulated instructions have been.
+const MIN_PADDING: u64 = 1_050;
+
+/// How long a simulated transaction is reused for an identical call. Past this, the ledger
+/// entries it reads are likely enough to have changed that it is simulated again.
+const REUSE_FOR: Duration = Duration::from_secs(5 * 60);
+
+/// How long the compute settings of a network are trusted.
+const COMPUTE_SETTINGS_FOR: Duration = Duration::from_secs(60 * 60);
+
+pub fn resources_dir(network_passphrase: &str) -> Result<PathBuf, Error> {
+    let network_id = hex::encode(Sha256::digest(network_passphrase.as_bytes()));
+    let dir = data_local_dir()?.join("resources").join(network_id);
+    std::fs::create_dir_all(&dir)?;
+    Ok(dir)
+}
+
+/// The resources of one invocation.
+#[derive(Serialize, Deserialize, Clone, Debug, PartialEq, Eq)]
+#[serde(rename_all = "snake_case")]
+pub struct Sample {
+    pub simulated_instructions: u32,
+    /// Instructions the transaction was submitted with, after padding.
+    pub instructions: u32,
+    pub read_bytes: u32,
+    pub write_bytes: u32,
+    pub resource_fee: i64,
+    /// Fee charged by the network, once the transaction has been applied.
+    pub fee_charged: Option<i64>,
+    /// Whether the transaction succeeded, once it has been applied.
+    pub success: Option<bool>,
+}
+
+/// A simulated transaction kept to be submitted again for an identical call.
+#[derive(Serialize, Deserialize, Clone, Debug)]
+#[serde(rename_all = "snake_case")]
+struct Reusable {
+    /// Hex encoded hash of the transaction as built before simulation.
+    key: String,
+    /// Base64 XDR of the simulated transaction.
+    transaction: String,
+    /// Seconds since the unix epoch at which the transaction was simulated.
+    simulated_at: u64,
+    /// Instructions reported by the simulation, before padding.
+    #[serde(default)]
+    simulated_instructions: u32,
+}
+
+#[derive(Serialize, Deserialize, Default, Debug)]
+#[serde(rename_all = "snake_case")]
+struct Contents {
+    samples: VecDeque<Sample>,
+    reusable: Option<Reusable>,
+}
+
+/// The history of one contract function on one network.
+#[derive(Debug)]
+pub struct History {
+    file: PathBuf,
+    contents: Contents,
+}
+
+impl History {
+    /// Opens the history of `function`, which is empty if it has never been invoked.
+    pub fn open(
+        network_passphrase: &str,
+        contract_id: &[u8; 32],
+        function: &str,
+    ) -> Result<Self, Error> {
+        let dir = resources_dir(network_passphrase)?.join(hex::encode(contract_id));
+        std::fs::create_dir_all(&dir)?;
+        let file = dir.join(function).with_extension("json");
+        let contents = match std::fs::read_to_string(&file) {
+            // A history that cannot be read is started again, it is only a hint.
+            Ok(contents) => serde_json::from_str(&contents).unwrap_or_default(),
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => Contents::default(),
+            Err(e) => return Err(e.into()),
+        };
+        Ok(Self { file, contents })
+    }
+
+    pub fn save(&self) -> Result<(), Error> {
+        tracing::trace!("writing resource history to {:?}", self.file);
+        write_atomically(&self.file, &serde_json::to_string(&self.contents)?)
+    }
+
+    pub fn samples(&self) -> impl Iterator<Item = &Sample> {
+        self.contents.samples.iter()
+    }
+
+    /// The instructions to submit a transaction simulated with `simulated` instructions with.
+    ///
+    /// Without enough history, or after a recent failure, the default padding is used. Once
+    /// enough invocations succeeded, the padding covers how far their simulated instructions
+    /// have varied, plus a small margin.
+    pub fn padded_instructions(&self, simulated: u32) -> u32 {
+        let succeeded = self
+            .samples()
+            .filter(|s| s.success == Some(true))
+            .map(|s| s.simulated_instructions)
+            .collect::<Vec<_>>();
+        let failed = self.samples().any(|s| s.success == Some(false));
+        let padding = match (succeeded.iter().min(), succeeded.iter().max()) {
+            (Some(&min), Some(&max)) if !failed && succeeded.len() >= MIN_SAMPLES && min > 0 => {
+                let spread = u64::from(max) * 1_000 / u64::from(min) - 1_000;
+                (spread + MIN_PADDING).min(DEFAULT_PADDING)
+            }
+            _ => DEFAULT_PADDING,
+        };
+        pad(simulated, padding)
+    }
+
+    /// Records the resources of `tx`, simulated with `simulated_instructions`, before it is
+    /// submitted.
+    pub fn record_simulation(&mut self, simulated_instructions: u32, tx: &Transaction) {
+        let TransactionExt::V1(SorobanTransactionData {
+            resources,
+            resource_fee,
+            ..
+        }) = &tx.ext
+        else {
+            return;
+        };
+        if self.contents.samples.len() == MAX_SAMPLES {
+            self.contents.samples.pop_front();
+        }
+        self.contents.samples.push_back(Sample {
+            simulated_instructions,
+            instructions: resources.instructions,
+            read_bytes: resources.read_bytes,
+            write_bytes: resources.write_bytes,
+            resource_fee: *resource_fee,
+            fee_charged: None,
+            success: None,
+        });
+    }
+
+    /// Records the resources of `tx`, returned by [`History::reusable`], before it is submitted,
+    /// so that its outcome is recorded like that of a simulated transaction.
+    pub fn record_reuse(&mut self, tx: &Transaction) {
+        let simulated_instructions = self
+            .contents
+            .reusable
+            .as_ref()
+            .map_or(0, |reusable| reusable.simulated_instructions);
+        self.record_simulation(simulated_instructions, tx);
+    }
+
+    /// Records the outcome of the last submitted transaction. `built` is the transaction as
+    /// built before simulation and `simulated` the one submitted, before any signing. A
+    /// successful transaction is kept to be reused for identical calls, unless its auth entries
+    /// had to be signed, as their nonces cannot be used twice.
+    pub fn record_result(
+        &mut self,
+        built: &Transaction,
+        simulated: &Transaction,
+        fee_charged: Option<i64>,
+        success: bool,
+    ) -> Result<(), Error> {
+        let mut simulated_instructions = 0;
+        if let Some(sample) = self.contents.samples.back_mut() {
+            if sample.success.is_none() {
+                sample.fee_charged = fee_charged;
+                sample.success = Some(success);
+                simulated_instructions = sample.simulated_instructions;
+            }
+        }
+        let key = reuse_key(built)?;
+        self.contents.reusable = match self.contents.reusable.take() {
+            // Reusing a transaction does not make its simulation any more recent.
+            Some(reusable) if success && reusable.key == key && reusable.is_fresh() => {
+                Some(reusable)
+            }
+            _ if success && !needs_signed_auth(simulated) => Some(Reusable {
+                key,
+                transaction: simulated.to_xdr_base64(Limits::none())?,
+                simulated_at: now().as_secs(),
+                simulated_instructions,
+            }),
+            _ => None,
+        };
+        Ok(())
+    }
+
+    /// A previously simulated transaction for a call identical to `built`, with the sequence
+    /// number of `built`, if one was simulated recently enough.
+    pub fn reusable(&self, built: &Transaction) -> Result<Option<Transaction>, Error> {
+        let Some(reusable) = &self.contents.reusable else {
+            return Ok(None);
+        };
+        if !reusable.is_fresh() || reusable.key != reuse_key(built)? {
+            return Ok(None);
+        }
+        let mut tx = Transaction::from_xdr_base64(&reusable.transaction, Limits::none())?;
+        tx.seq_num = built.seq_num.clone();
+        Ok(Some(tx))
+    }
+}
+
+impl Reusable {
+    fn is_fresh(&self) -> bool {
+        now().saturating_sub(Duration::from_secs(self.simulated_at)) < REUSE_FOR
+    }
+}
+
+/// The instructions to submit with when there is no history to go by.
+pub fn default_padded_instructions(simulated: u32) -> u32 {
+    pad(simulated, DEFAULT_PADDING)
+}
+
+fn pad(instructions: u32, padding: u64) -> u32 {
+    u32::try_from((u64::from(instructions) * padding).div_ceil(1_000)).unwrap_or(u32::MAX)
+}
+
+/// Identifies a call by everything in its transaction but the sequence number.
+fn reuse_key(built: &Transaction) -> Result<String, Error> {
+    let mut tx = built.clone();
+    tx.seq_num = SequenceNumber(0);
+    Ok(hex::encode(Sha256::digest(tx.to_xdr(Limits::none())?)))
+}
+
+fn needs_signed_auth(tx: &Transaction) -> bool {
+    tx.operations.iter().any(|op| match &op.body {
+        OperationBody::InvokeHostFunction(body) => body
+            .auth
+            .iter()
+            .any(|auth| matches!(auth.credentials, SorobanCredentials::Address(_))),
+        _ => false,
+    })
+}
+
+/// The instruction settings of a network, from its `ContractComputeV0` config setting.
+#[derive(Serialize, Deserialize, Clone, Copy, Debug, PartialEq, Eq)]
+#[serde(rename_all = "snake_case")]
+pub struct ComputeSettings {
+    pub tx_max_instructions: i64,
+    pub fee_rate_per_instructions_increment: i64,
+    /// Seconds since the unix epoch at which the settings were fetched.
+    pub fetched_at: u64,
+}
+
+impl ComputeSettings {
+    pub fn new(tx_max_instructions: i64, fee_rate_per_instructions_increment: i64) -> Self {
+        Self {
+            tx_max_instructions,
+            fee_rate_per_instructions_increment,
+            fetched_at: now().as_secs(),
+        }
+    }
+}
+
+pub fn read_compute_settings(network_passphrase: &str) -> Result<Option<ComputeSettings>, Error> {
+    let file = resources_dir(network_passphrase)?.join("compute.json");
+    let Ok(contents) = std::fs::read_to_string(file) else {
+        return Ok(None);
+    };
+    let settings: ComputeSettings = serde_json::from_str(&contents)?;
+    let elapsed = now().saturating_sub(Duration::from_secs(settings.fetched_at));
+    Ok((elapsed < COMPUTE_SETTINGS_FOR).then_some(settings))
+}
+
+pub fn write_compute_settings(
+    network_passphrase: &str,
+    settings: &ComputeSettings,
+) -> Result<(), Error> {
+    let file = resources_dir(network_passphrase)?.join("compute.json");
+    write_atomically(&file, &serde_json::to_string(settings)?)
+}
+
+/// Writes `contents` to a temporary file next to `file`, then renames it over `file`, so that
+/// concurrent invocations never read a partially written file.
+fn write_atomically(file: &Path, contents: &str) -> Result<(), Error> {
+    let dir = file.parent().unwrap_or_else(|| Path::new("."));
+    let mut tmp = tempfile::NamedTempFile::new_in(dir)?;
+    tmp.write_all(contents.as_bytes())?;
+    tmp.persist(file).map_err(|e| e.error)?;
+    Ok(())
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+    use crate::xdr::{
+        ExtensionPoint, LedgerFootprint, Memo, MuxedAccount, Preconditions, SorobanResources,
+        Uint256, VecM,
+    };
+
+    fn history(samples: &[(u32, bool)]) -> History {
+        History {
+            file: PathBuf::new(),
+            contents: Contents {
+                samples: samples
+                    .iter()
+                    .map(|&(simulated_instructions, success)| Sample {
+                        simulated_instructions,
+                        instructions: simulated_instructions,
+                        read_bytes: 0,
+                        write_bytes: 0,
+                        resource_fee: 0,
+                        fee_charged: None,
+                        success: Some(success),
+                    })
+                    .collect(),
+                reusable: None,
+            },
+        }
+    }
+
+    #[test]
+    fn padding_adapts_to_history() {
+        assert_eq!(history(&[]).padded_instructions(1_000), 1_500);
+        assert_eq!(
+            history(&[(1_000, true), (1_000, true)]).padded_instructions(1_000),
+            1_500
+        );
+        let steady = history(&[(1_000, true), (1_000, true), (1_000, true)]);
+        assert_eq!(steady.padded_instructions(1_000), 1_050);
+        let varying = history(&[(1_000, true), (1_100, true), (1_000, true)]);
+        assert_eq!(varying.padded_instructions(1_000), 1_150);
+        let failed = history(&[(1_000, true), (1_000, false), (1_000, true), (1_000, true)]);
+        assert_eq!(failed.padded_instructions(1_000), 1_500);
+        assert_eq!(history(&[]).padded_instructions(u32::MAX), u32::MAX);
+    }
+
+    fn transaction(seq_num: i64, instructions: u32) -> Transaction {
+        Transaction {
+            source_account: MuxedAccount::Ed25519(Uint256([0; 32])),
+            fee: 100,
+            seq_num: SequenceNumber(seq_num),
+            cond: Preconditions::None,
+            memo: Memo::None,
+            operations: VecM::default(),
+            ext: TransactionExt::V1(SorobanTransactionData {
+                ext: ExtensionPoint::V0,
+                resources: SorobanResources {
+                    footprint: LedgerFootprint {
+                        read_only: VecM::default(),
+                        read_write: VecM::default(),
+                    },
+                    instructions,
+                    read_bytes: 0,
+                    write_bytes: 0,
+                },
+                resource_fee: 0,
+            }),
+        }
+    }
+
+    #[test]
+    fn reused_submits_are_sampled() {
+        let mut history = history(&[]);
+        let built = transaction(1, 0);
+        history.record_simulation(1_000, &transaction(1, 1_500));
+        history
+            .record_result(&built, &transaction(1, 1_500), Some(100), true)
+            .unwrap();
+
+        let reused = history.reusable(&transaction(2, 0)).unwrap().unwrap();
+        history.record_reuse(&reused);
+        history
+            .record_result(&transaction(2, 0), &reused, None, false)
+            .unwrap();
+
+        let samples = history.samples().collect::<Vec<_>>();
+        assert_eq!(samples.len(), 2);
+        assert_eq!(samples[1].simulated_instructions, 1_000);
+        assert_eq!(samples[1].instructions, 1_500);
+        assert_eq!(samples[1].success, Some(false));
+        assert!(history.reusable(&transaction(3, 0)).unwrap().is_none());
+    }
+}
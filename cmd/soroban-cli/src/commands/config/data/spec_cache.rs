@@ -0,0 +1,479 @@
+//! Shared on-disk cache of contract specs, keyed by wasm hash.
+//!
+//! Every spec is stored in a single append-only file in [`super::spec_dir`]. The file starts
+//! with a magic and a version, followed by one record per wasm hash:
+//!
+//! ```text
+//! record_len: u32                       length of the rest of the record
+//! key_len: u16, key: [u8]               the wasm hash
+//! entry_count: u32
+//! index: [kind: u8, name_len: u16, name: [u8], offset: u32, len: u32]
+//! entries: [u8]                         XDR of each entry, `offset` is relative to here
+//! ```
+//!
+//! All integers are little endian. The file is memory mapped, so finding a hash only touches
+//! the record headers, and invoking a function only decodes the function and the types it uses.
+
+use std::{
+    collections::BTreeMap,
+    fs::{File, OpenOptions},
+    io::{self, Write},
+    ops::Range,
+    path::Path,
+};
+
+use memmap2::Mmap;
+
+use super::{file_lock::FileLock, spec_dir, Error};
+use crate::xdr::{self, ReadXdr, ScSpecEntry, ScSpecTypeDef, ScSpecUdtUnionCaseV0, WriteXdr};
+
+const MAGIC: &[u8; 4] = b"SSPC";
+const VERSION: u32 = 1;
+const HEADER_LEN: usize = MAGIC.len() + 4;
+/// The version is part of the file name so that a new format never has to rewrite a file that
+/// another process may have mapped.
+const FILE_NAME: &str = "specs-v1.bin";
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+enum Kind {
+    Function = 0,
+    Type = 1,
+}
+
+impl Kind {
+    fn from_u8(kind: u8) -> Option<Self> {
+        match kind {
+            0 => Some(Kind::Function),
+            1 => Some(Kind::Type),
+            _ => None,
+        }
+    }
+}
+
+struct IndexEntry {
+    kind: Kind,
+    name: String,
+    range: Range<usize>,
+}
+
+/// The spec of one wasm hash, decoded from the memory mapped cache as entries are needed.
+pub struct CachedSpec {
+    map: Mmap,
+    index: Vec<IndexEntry>,
+}
+
+impl CachedSpec {
+    /// Decodes every entry of the spec.
+    pub fn entries(&self) -> Result<Vec<ScSpecEntry>, Error> {
+        self.index.iter().map(|e| self.decode(e)).collect()
+    }
+
+    /// Decodes the first function whose name matches, and the types it refers to directly or
+    /// through other types, which is all that is needed to call it. Entries keep the order they
+    /// appear in the contract. `None` if no function matches.
+    pub fn function_entries(
+        &self,
+        matches: impl Fn(&str) -> bool,
+    ) -> Result<Option<Vec<ScSpecEntry>>, Error> {
+        let Some(function) = self
+            .index
+            .iter()
+            .position(|e| e.kind == Kind::Function && matches(&e.name))
+        else {
+            return Ok(None);
+        };
+        let mut needed = BTreeMap::from([(function, self.decode(&self.index[function])?)]);
+        let mut pending = vec![function];
+        while let Some(i) = pending.pop() {
+            let mut names = Vec::new();
+            for type_ in referenced_types(&needed[&i]) {
+                udt_names(type_, &mut names);
+            }
+            for (j, entry) in self.index.iter().enumerate() {
+                if entry.kind == Kind::Type
+                    && names.contains(&entry.name)
+                    && !needed.contains_key(&j)
+                {
+                    needed.insert(j, self.decode(entry)?);
+                    pending.push(j);
+                }
+            }
+        }
+        Ok(Some(needed.into_values().collect()))
+    }
+
+    fn decode(&self, entry: &IndexEntry) -> Result<ScSpecEntry, Error> {
+        Ok(ScSpecEntry::from_xdr(
+            &self.map[entry.range.clone()],
+            xdr::Limits::none(),
+        )?)
+    }
+}
+
+/// Looks up the spec of `hash` in the shared cache.
+pub fn open(hash: &str) -> Result<Option<CachedSpec>, Error> {
+    open_at(&spec_dir()?.join(FILE_NAME), hash)
+}
+
+/// Appends the spec of `hash` to the shared cache, unless it is already there.
+pub fn write(hash: &str, spec_entries: &[ScSpecEntry]) -> Result<(), Error> {
+    write_at(&spec_dir()?.join(FILE_NAME), hash, spec_entries)
+}
+
+fn open_at(path: &Path, hash: &str) -> Result<Option<CachedSpec>, Error> {
+    let file = match File::open(path) {
+        Ok(file) => file,
+        Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(None),
+        Err(e) => return Err(e.into()),
+    };
+    if file.metadata()?.len() < HEADER_LEN as u64 {
+        return Ok(None);
+    }
+    tracing::trace!("reading spec {hash} from {path:?}");
+    // SAFETY: the cache is only ever appended to, and every record is bounds checked before
+    // use, so the mapped bytes that are read are never modified.
+    let map = unsafe { Mmap::map(&file)? };
+    let Some(index) = find_record(&map, hash.as_bytes()) else {
+        return Ok(None);
+    };
+    Ok(Some(CachedSpec { map, index }))
+}
+
+fn write_at(path: &Path, hash: &str, spec_entries: &[ScSpecEntry]) -> Result<(), Error> {
+    if open_at(path, hash)?.is_some() {
+        return Ok(());
+    }
+    let record = encode_record(hash.as_bytes(), spec_entries)?;
+    // Writers take turns, so that a record left incomplete by a writer that died is dropped
+    // before the next record is appended after it, where it would never be found.
+    let _lock = FileLock::acquire(path)?;
+    let file = match File::open(path) {
+        Ok(file) => Some(file),
+        Err(e) if e.kind() == io::ErrorKind::NotFound => None,
+        Err(e) => return Err(e.into()),
+    };
+    // SAFETY: see `open_at`, the file is replaced rather than modified in place below.
+    let map = file.map(|file| unsafe { Mmap::map(&file) }).transpose()?;
+    let map = map.as_deref().unwrap_or_default();
+    if find_record(map, hash.as_bytes()).is_some() {
+        return Ok(());
+    }
+    let end = records_end(map);
+    if end != Some(map.len()) {
+        tracing::trace!("rewriting {path:?} without its incomplete records");
+        // Other processes may have the file mapped, so rather than truncating it, the complete
+        // records are copied to a new file that replaces it.
+        let dir = path.parent().unwrap_or_else(|| Path::new("."));
+        let mut tmp = tempfile::NamedTempFile::new_in(dir)?;
+        match end {
+            Some(end) => tmp.write_all(&map[..end])?,
+            None => {
+                tmp.write_all(MAGIC)?;
+                tmp.write_all(&VERSION.to_le_bytes())?;
+            }
+        }
+        tmp.persist(path).map_err(|e| e.error)?;
+    }
+    tracing::trace!("writing spec {hash} to {path:?}");
+    OpenOptions::new()
+        .append(true)
+        .open(path)?
+        .write_all(&record)?;
+    Ok(())
+}
+
+fn encode_record(key: &[u8], spec_entries: &[ScSpecEntry]) -> Result<Vec<u8>, Error> {
+    let mut index = Vec::new();
+    let mut entries = Vec::new();
+    for entry in spec_entries {
+        let (kind, name) = kind_and_name(entry);
+        let xdr = entry.to_xdr(xdr::Limits::none())?;
+        index.push(kind as u8);
+        index.extend(len_u16(name.len())?.to_le_bytes());
+        index.extend(name.as_bytes());
+        index.extend(len_u32(entries.len())?.to_le_bytes());
+        index.extend(len_u32(xdr.len())?.to_le_bytes());
+        entries.extend(xdr);
+    }
+    let mut body = Vec::with_capacity(2 + key.len() + 4 + index.len() + entries.len());
+    body.extend(len_u16(key.len())?.to_le_bytes());
+    body.extend(key);
+    body.extend(len_u32(spec_entries.len())?.to_le_bytes());
+    body.extend(index);
+    body.extend(entries);
+
+    let mut record = Vec::with_capacity(4 + body.len());
+    record.extend(len_u32(body.len())?.to_le_bytes());
+    record.extend(body);
+    Ok(record)
+}
+
+fn kind_and_name(entry: &ScSpecEntry) -> (Kind, String) {
+    match entry {
+        ScSpecEntry::FunctionV0(x) => (Kind::Function, x.name.to_utf8_string_lossy()),
+        ScSpecEntry::UdtStructV0(x) => (Kind::Type, x.name.to_utf8_string_lossy()),
+        ScSpecEntry::UdtUnionV0(x) => (Kind::Type, x.name.to_utf8_string_lossy()),
+        ScSpecEntry::UdtEnumV0(x) => (Kind::Type, x.name.to_utf8_string_lossy()),
+        ScSpecEntry::UdtErrorEnumV0(x) => (Kind::Type, x.name.to_utf8_string_lossy()),
+    }
+}
+
+/// The types used by the inputs and outputs of a function, or by the fields and cases of a type.
+fn referenced_types(entry: &ScSpecEntry) -> Vec<&ScSpecTypeDef> {
+    match entry {
+        ScSpecEntry::FunctionV0(x) => x
+            .inputs
+            .iter()
+            .map(|i| &i.type_)
+            .chain(x.outputs.iter())
+            .collect(),
+        ScSpecEntry::UdtStructV0(x) => x.fields.iter().map(|f| &f.type_).collect(),
+        ScSpecEntry::UdtUnionV0(x) => x
+            .cases
+            .iter()
+            .flat_map(|c| match c {
+                ScSpecUdtUnionCaseV0::TupleV0(t) => t.type_.iter().collect(),
+                ScSpecUdtUnionCaseV0::VoidV0(_) => Vec::new(),
+            })
+            .collect(),
+        ScSpecEntry::UdtEnumV0(_) | ScSpecEntry::UdtErrorEnumV0(_) => Vec::new(),
+    }
+}
+
+fn udt_names(type_: &ScSpecTypeDef, names: &mut Vec<String>) {
+    match type_ {
+        ScSpecTypeDef::Option(x) => udt_names(&x.value_type, names),
+        ScSpecTypeDef::Result(x) => {
+            udt_names(&x.ok_type, names);
+            udt_names(&x.error_type, names);
+        }
+        ScSpecTypeDef::Vec(x) => udt_names(&x.element_type, names),
+        ScSpecTypeDef::Map(x) => {
+            udt_names(&x.key_type, names);
+            udt_names(&x.value_type, names);
+        }
+        ScSpecTypeDef::Tuple(x) => x.value_types.iter().for_each(|t| udt_names(t, names)),
+        ScSpecTypeDef::Udt(x) => names.push(x.name.to_utf8_string_lossy()),
+        _ => {}
+    }
+}
+
+fn len_u16(len: usize) -> Result<u16, Error> {
+    u16::try_from(len).map_err(|_| Error::SpecCacheEntryTooLarge)
+}
+
+fn len_u32(len: usize) -> Result<u32, Error> {
+    u32::try_from(len).map_err(|_| Error::SpecCacheEntryTooLarge)
+}
+
+/// Scans the records of the cache for `key`, returning the index of the last matching record.
+/// A damaged or truncated record ends the scan, as nothing after it can be trusted.
+fn find_record(map: &[u8], key: &[u8]) -> Option<Vec<IndexEntry>> {
+    if !has_header(map) {
+        return None;
+    }
+    let mut found = None;
+    let mut pos = HEADER_LEN;
+    while let Some((start, record)) = next_record(map, pos) {
+        let key_len = read_u16(record, 0).unwrap_or_default() as usize;
+        if record.get(2..2 + key_len) == Some(key) {
+            let Some(mut index) = read_index(record, 2 + key_len) else {
+                break;
+            };
+            for entry in &mut index {
+                entry.range = entry.range.start + start..entry.range.end + start;
+            }
+            found = Some(index);
+        }
+        pos = start + record.len();
+    }
+    found
+}
+
+/// The offset just past the last complete record, or `None` if the file has no valid header.
+fn records_end(map: &[u8]) -> Option<usize> {
+    if !has_header(map) {
+        return None;
+    }
+    let mut pos = HEADER_LEN;
+    while let Some((start, record)) = next_record(map, pos) {
+        pos = start + record.len();
+    }
+    Some(pos)
+}
+
+fn has_header(map: &[u8]) -> bool {
+    map.get(..MAGIC.len()) == Some(MAGIC) && read_u32(map, MAGIC.len()) == Some(VERSION)
+}
+
+/// Returns the record at `pos` along with the offset of its body, if it is complete.
+fn next_record(map: &[u8], pos: usize) -> Option<(usize, &[u8])> {
+    let start = pos + 4;
+    let end = start.checked_add(read_u32(map, pos)? as usize)?;
+    Some((start, map.get(start..end)?))
+}
+
+fn read_index(record: &[u8], mut pos: usize) -> Option<Vec<IndexEntry>> {
+    let count = read_u32(record, pos)? as usize;
+    pos += 4;
+    let mut index = Vec::with_capacity(count.min(record.len()));
+    for _ in 0..count {
+        let kind = Kind::from_u8(*record.get(pos)?)?;
+        let name_len = read_u16(record, pos + 1)? as usize;
+        let name = std::str::from_utf8(record.get(pos + 3..pos + 3 + name_len)?).ok()?;
+        pos += 3 + name_len;
+        let offset = read_u32(record, pos)? as usize;
+        let len = read_u32(record, pos + 4)? as usize;
+        pos += 8;
+        index.push(IndexEntry {
+            kind,
+            name: name.to_string(),
+            range: offset..offset + len,
+        });
+    }
+    // Entry offsets are relative to the end of the index, make them relative to the record.
+    for entry in &mut index {
+        entry.range = entry.range.start + pos..entry.range.end + pos;
+    }
+    (index.iter().all(|e| e.range.end <= record.len())).then_some(index)
+}
+
+fn read_u16(bytes: &[u8], pos: usize) -> Option<u16> {
+    Some(u16::from_le_bytes(
+        bytes.get(pos..pos + 2)?.try_into().ok()?,
+    ))
+}
+
+fn read_u32(bytes: &[u8], pos: usize) -> Option<u32> {
+    Some(u32::from_le_bytes(
+        bytes.get(pos..pos + 4)?.try_into().ok()?,
+    ))
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+    use crate::xdr::{
+        ScSpecFunctionInputV0, ScSpecFunctionV0, ScSpecTypeUdt, ScSpecTypeVec, ScSpecUdtEnumV0,
+        ScSpecUdtStructFieldV0, ScSpecUdtStructV0, ScSymbol, StringM, VecM,
+    };
+
+    fn function(name: &str) -> ScSpecEntry {
+        ScSpecEntry::FunctionV0(ScSpecFunctionV0 {
+            doc: StringM::default(),
+            name: ScSymbol(name.try_into().unwrap()),
+            inputs: VecM::default(),
+            outputs: VecM::default(),
+        })
+    }
+
+    fn udt(name: &str) -> ScSpecEntry {
+        ScSpecEntry::UdtEnumV0(ScSpecUdtEnumV0 {
+            doc: StringM::default(),
+            lib: StringM::default(),
+            name: name.try_into().unwrap(),
+            cases: VecM::default(),
+        })
+    }
+
+    #[test]
+    fn shared_file_serves_many_hashes() {
+        let t = assert_fs::TempDir::new().unwrap();
+        let path = t.path().join(FILE_NAME);
+        let a = vec![function("hello"), udt("Color")];
+        let b = vec![function("inc"), function("get")];
+        write_at(&path, "aa", &a).unwrap();
+        write_at(&path, "bb", &b).unwrap();
+        // Writing a hash that is already cached is a no-op.
+        write_at(&path, "aa", &a).unwrap();
+
+        let spec = open_at(&path, "aa").unwrap().unwrap();
+        assert_eq!(spec.entries().unwrap(), a);
+
+        let spec = open_at(&path, "bb").unwrap().unwrap();
+        assert_eq!(spec.entries().unwrap(), b);
+        assert_eq!(
+            spec.function_entries(|name| name == "get").unwrap(),
+            Some(vec![function("get")])
+        );
+        assert!(open_at(&path, "cc").unwrap().is_none());
+    }
+
+    #[test]
+    fn truncated_record_is_ignored() {
+        let t = assert_fs::TempDir::new().unwrap();
+        let path = t.path().join(FILE_NAME);
+        write_at(&path, "aa", &[function("hello")]).unwrap();
+        let len = std::fs::metadata(&path).unwrap().len();
+        write_at(&path, "bb", &[function("inc")]).unwrap();
+        let file = OpenOptions::new().write(true).open(&path).unwrap();
+        file.set_len(len + 10).unwrap();
+
+        assert!(open_at(&path, "aa").unwrap().is_some());
+        assert!(open_at(&path, "bb").unwrap().is_none());
+
+        // The next write drops the incomplete record instead of appending after it.
+        write_at(&path, "cc", &[function("get")]).unwrap();
+        assert!(open_at(&path, "aa").unwrap().is_some());
+        assert!(open_at(&path, "cc").unwrap().is_some());
+        write_at(&path, "bb", &[function("inc")]).unwrap();
+        assert!(open_at(&path, "bb").unwrap().is_some());
+    }
+
+    #[test]
+    fn function_entries_include_the_types_it_uses() {
+        let t = assert_fs::TempDir::new().unwrap();
+        let path = t.path().join(FILE_NAME);
+        let point = ScSpecEntry::UdtStructV0(ScSpecUdtStructV0 {
+            doc: StringM::default(),
+            lib: StringM::default(),
+            name: "Point".try_into().unwrap(),
+            fields: [ScSpecUdtStructFieldV0 {
+                doc: StringM::default(),
+                name: "color".try_into().unwrap(),
+                type_: udt_type("Color"),
+            }]
+            .try_into()
+            .unwrap(),
+        });
+        let draw = ScSpecEntry::FunctionV0(ScSpecFunctionV0 {
+            doc: StringM::default(),
+            name: ScSymbol("draw".try_into().unwrap()),
+            inputs: [ScSpecFunctionInputV0 {
+                doc: StringM::default(),
+                name: "points".try_into().unwrap(),
+                type_: ScSpecTypeDef::Vec(Box::new(ScSpecTypeVec {
+                    element_type: Box::new(udt_type("Point")),
+                })),
+            }]
+            .try_into()
+            .unwrap(),
+            outputs: VecM::default(),
+        });
+        let entries = vec![
+            udt("Color"),
+            function("hello"),
+            udt("Unused"),
+            point.clone(),
+            draw.clone(),
+        ];
+        write_at(&path, "aa", &entries).unwrap();
+
+        let spec = open_at(&path, "aa").unwrap().unwrap();
+        assert_eq!(
+            spec.function_entries(|name| name == "draw").unwrap(),
+            Some(vec![udt("Color"), point, draw])
+        );
+        assert_eq!(
+            spec.function_entries(|name| name == "hello").unwrap(),
+            Some(vec![function("hello")])
+        );
+        assert_eq!(spec.function_entries(|name| name == "Color").unwrap(), None);
+    }
+
+    fn udt_type(name: &str) -> ScSpecTypeDef {
+        ScSpecTypeDef::Udt(ScSpecTypeUdt {
+            name: name.try_into().unwrap(),
+        })
+    }
+}
@@ -3,8 +3,6 @@ use std::path::PathBuf;
 use clap::{arg, command};
 use serde::{Deserialize, Serialize};
 
-use soroban_rpc::Client;
-
 use crate::{
     signer,
     xdr::{Transaction, TransactionEnvelope},
@@ -80,7 +78,7 @@ impl Args {
     ) -> Result<Option<Transaction>, Error> {
         let network = self.get_network()?;
         let source_key = self.key_pair()?;
-        let client = Client::new(&network.rpc_url)?;
+        let client = network.rpc_client()?;
         let latest_ledger = client.get_latest_ledger().await?.sequence;
         let seq_num = latest_ledger + 60; // ~ 5 min
         Ok(signer::sign_soroban_authorizations(
@@ -1,6 +1,6 @@
 use clap::arg;
 use serde::{Deserialize, Serialize};
-use std::{io::Write, str::FromStr};
+use std::{io::Write, num::NonZeroUsize, ops::Range, str::FromStr, thread};
 use stellar_strkey::ed25519::{PrivateKey, PublicKey};
 
 use crate::utils;
@@ -124,6 +124,40 @@ impl Secret {
         Ok(utils::into_signing_key(&self.private_key(index)?))
     }
 
+    /// Public keys of the accounts at the hd paths `indexes`, derived on all cores. The seed is
+    /// only computed from the seed phrase once by each.
+    pub fn public_keys(&self, indexes: Range<usize>) -> Result<Vec<PublicKey>, Error> {
+        let indexes = indexes.collect::<Vec<_>>();
+        let workers = thread::available_parallelism().map_or(1, NonZeroUsize::get);
+        let chunk_size = indexes.len().div_ceil(workers).max(1);
+        let derive = |chunk: &[usize]| -> Result<Vec<PublicKey>, Error> {
+            let Secret::SeedPhrase { seed_phrase } = self else {
+                return chunk.iter().map(|&i| self.public_key(Some(i))).collect();
+            };
+            let seed = sep5::SeedPhrase::from_str(seed_phrase)?;
+            chunk
+                .iter()
+                .map(|&i| {
+                    let private =
+                        PrivateKey::from_payload(&seed.from_path_index(i, None)?.private().0)?;
+                    let key = utils::into_signing_key(&private);
+                    Ok(PublicKey::from_payload(key.verifying_key().as_bytes())?)
+                })
+                .collect()
+        };
+        thread::scope(|s| {
+            let workers = indexes
+                .chunks(chunk_size)
+                .map(|chunk| s.spawn(move || derive(chunk)))
+                .collect::<Vec<_>>();
+            let mut keys = Vec::with_capacity(indexes.len());
+            for worker in workers {
+                keys.extend(worker.join().expect("key derivation panicked")?);
+            }
+            Ok(keys)
+        })
+    }
+
     pub fn from_seed(seed: Option<&str>) -> Result<Self, Error> {
         let seed_phrase = if let Some(seed) = seed.map(str::as_bytes) {
             sep5::SeedPhrase::from_entropy(seed)
@@ -144,3 +178,19 @@ fn read_password() -> Result<String, Error> {
     std::io::stdout().flush().map_err(|_| Error::PasswordRead)?;
     rpassword::read_password().map_err(|_| Error::PasswordRead)
 }
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn public_keys_match_each_hd_path() {
+        let secret = Secret::test_seed_phrase().unwrap();
+        let keys = secret.public_keys(3..40).unwrap();
+        assert_eq!(keys.len(), 37);
+        for (key, i) in keys.iter().zip(3..) {
+            assert_eq!(*key, secret.public_key(Some(i)).unwrap());
+        }
+        assert!(secret.public_keys(5..5).unwrap().is_empty());
+    }
+}
@@ -1,6 +1,11 @@
-use std::{ffi::OsString, fmt::Debug, path::PathBuf};
+use std::{
+    ffi::OsString,
+    fmt::Debug,
+    path::{Path, PathBuf},
+};
 
 use clap::{command, Parser};
+use soroban_env_host::xdr::ScSpecEntry;
 use soroban_spec_tools::contract as contract_spec;
 use soroban_spec_typescript::{self as typescript, boilerplate::Project};
 use stellar_strkey::DecodeError;
@@ -17,6 +22,8 @@ use crate::{
     get_spec::{self, get_remote_contract_spec},
 };
 
+mod manifest;
+
 #[derive(Parser, Debug, Clone)]
 #[group(skip)]
 pub struct Cmd {
@@ -24,14 +31,26 @@ pub struct Cmd {
     #[arg(long)]
     pub wasm: Option<std::path::PathBuf>,
     /// Where to place generated project
-    #[arg(long)]
-    pub output_dir: PathBuf,
+    #[arg(long, required_unless_present = "manifest")]
+    pub output_dir: Option<PathBuf>,
     /// Whether to overwrite output directory if it already exists
     #[arg(long)]
     pub overwrite: bool,
     /// The contract ID/address on the network
-    #[arg(long, visible_alias = "id")]
-    pub contract_id: String,
+    #[arg(long, visible_alias = "id", required_unless_present = "manifest")]
+    pub contract_id: Option<String>,
+    /// TOML manifest listing several contracts to generate bindings for
+    ///
+    /// Each `[[contract]]` table sets the `contract_id` and the `output_dir` of the project,
+    /// relative to the manifest, and optionally the `wasm` file to read the spec from instead
+    /// of the network. Projects are generated in parallel and only files whose contents
+    /// changed are written, projects whose inputs are unchanged are skipped. Projects are not
+    /// built.
+    #[arg(
+        long,
+        conflicts_with_all = ["wasm", "output_dir", "overwrite", "contract_id"],
+    )]
+    pub manifest: Option<PathBuf>,
     #[command(flatten)]
     pub locator: locator::Args,
     #[command(flatten)]
@@ -65,6 +84,18 @@ pub enum Error {
     Spec(#[from] contract_spec::Error),
     #[error(transparent)]
     Wasm(#[from] wasm::Error),
+    #[error("cannot read manifest {path}: {error}")]
+    CannotReadManifest {
+        path: PathBuf,
+        error: std::io::Error,
+    },
+    #[error("invalid manifest {path}: {error}")]
+    InvalidManifest {
+        path: PathBuf,
+        error: toml::de::Error,
+    },
+    #[error("{failed} of {total} bindings failed to generate")]
+    ManifestFailed { failed: usize, total: usize },
     #[error("Failed to get file name from path: {0:?}")]
     FailedToGetFileName(PathBuf),
     #[error("cannot parse contract ID {0}: {1}")]
@@ -85,74 +116,49 @@ impl NetworkRunnable for Cmd {
         global_args: Option<&global::Args>,
         config: Option<&config::Args>,
     ) -> Result<(), Error> {
-        let spec = if let Some(wasm) = &self.wasm {
-            let wasm: wasm::Args = wasm.into();
-            wasm.parse()?.spec
-        } else {
-            let network = config.map_or_else(
-                || self.network.get(&self.locator).map_err(Error::from),
-                |c| c.get_network().map_err(Error::from),
-            )?;
-
-            let contract_id = self
-                .locator
-                .resolve_contract_id(&self.contract_id, &network.network_passphrase)?
-                .0;
-
-            get_remote_contract_spec(
-                &contract_id,
-                &self.locator,
-                &self.network,
-                global_args,
-                config,
-            )
-            .await
-            .map_err(Error::from)?
+        if let Some(manifest) = &self.manifest {
+            return self.run_manifest(global_args, config, manifest).await;
+        }
+        let (Some(output_dir), Some(contract_id)) = (&self.output_dir, &self.contract_id) else {
+            unreachable!("clap requires --output-dir and --contract-id without --manifest");
         };
-        if self.output_dir.is_file() {
-            return Err(Error::IsFile(self.output_dir.clone()));
+        let spec = self
+            .spec(self.wasm.as_deref(), contract_id, global_args, config)
+            .await?;
+        if output_dir.is_file() {
+            return Err(Error::IsFile(output_dir.clone()));
         }
-        if self.output_dir.exists() {
+        if output_dir.exists() {
             if self.overwrite {
-                std::fs::remove_dir_all(&self.output_dir)?;
+                std::fs::remove_dir_all(output_dir)?;
             } else {
-                return Err(Error::OutputDirExists(self.output_dir.clone()));
+                return Err(Error::OutputDirExists(output_dir.clone()));
             }
         }
-        std::fs::create_dir_all(&self.output_dir)?;
-        let p: Project = self.output_dir.clone().try_into()?;
+        std::fs::create_dir_all(output_dir)?;
+        let p: Project = output_dir.clone().try_into()?;
         let Network {
             rpc_url,
             network_passphrase,
             ..
-        } = self
-            .network
-            .get(&self.locator)
-            .ok()
-            .unwrap_or_else(Network::futurenet);
-        let absolute_path = self.output_dir.canonicalize()?;
-        let file_name = absolute_path
-            .file_name()
-            .ok_or_else(|| Error::FailedToGetFileName(absolute_path.clone()))?;
-        let contract_name = &file_name
-            .to_str()
-            .ok_or_else(|| Error::NotUtf8(file_name.to_os_string()))?;
+        } = self.bindings_network();
+        let contract_name = contract_name(output_dir)?;
         p.init(
-            contract_name,
-            &self.contract_id,
+            &contract_name,
+            contract_id,
             &rpc_url,
             &network_passphrase,
             &spec,
         )?;
         std::process::Command::new("npm")
             .arg("install")
-            .current_dir(&self.output_dir)
+            .current_dir(output_dir)
             .spawn()?
             .wait()?;
         std::process::Command::new("npm")
             .arg("run")
             .arg("build")
-            .current_dir(&self.output_dir)
+            .current_dir(output_dir)
             .spawn()?
             .wait()?;
         Ok(())
@@ -163,4 +169,57 @@ impl Cmd {
     pub async fn run(&self) -> Result<(), Error> {
         self.run_against_rpc_server(None, None).await
     }
+
+    /// The spec of the contract, from `wasm` if given or else from the network.
+    async fn spec(
+        &self,
+        wasm: Option<&Path>,
+        contract_id: &str,
+        global_args: Option<&global::Args>,
+        config: Option<&config::Args>,
+    ) -> Result<Vec<ScSpecEntry>, Error> {
+        if let Some(wasm) = wasm {
+            let wasm = wasm::Args {
+                wasm: wasm.to_path_buf(),
+            };
+            return Ok(wasm.spec_entries()?);
+        }
+        let network = config.map_or_else(
+            || self.network.get(&self.locator).map_err(Error::from),
+            |c| c.get_network().map_err(Error::from),
+        )?;
+        let contract_id = self
+            .locator
+            .resolve_contract_id(contract_id, &network.network_passphrase)?
+            .0;
+        get_remote_contract_spec(
+            &contract_id,
+            &self.locator,
+            &self.network,
+            global_args,
+            config,
+        )
+        .await
+        .map_err(Error::from)
+    }
+
+    /// The network written into the generated projects.
+    fn bindings_network(&self) -> Network {
+        self.network
+            .get(&self.locator)
+            .ok()
+            .unwrap_or_else(Network::futurenet)
+    }
+}
+
+/// The name of the contract in a project, taken from the name of its directory.
+fn contract_name(output_dir: &Path) -> Result<String, Error> {
+    let absolute_path = output_dir.canonicalize()?;
+    let file_name = absolute_path
+        .file_name()
+        .ok_or_else(|| Error::FailedToGetFileName(absolute_path.clone()))?;
+    Ok(file_name
+        .to_str()
+        .ok_or_else(|| Error::NotUtf8(file_name.to_os_string()))?
+        .to_string())
 }
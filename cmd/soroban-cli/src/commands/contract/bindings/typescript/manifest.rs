@@ -0,0 +1,216 @@
+use std::{
+    fs, io,
+    num::NonZeroUsize,
+    path::{Path, PathBuf},
+    sync::atomic::{AtomicUsize, Ordering},
+    thread,
+};
+
+use futures_util::{stream, StreamExt};
+use serde::Deserialize;
+use sha2::{Digest, Sha256};
+use soroban_env_host::xdr::{Limits, ScSpecEntry, WriteXdr};
+use soroban_spec_typescript::boilerplate::Project;
+
+use super::{contract_name, Cmd, Error};
+use crate::commands::{config, global, network::Network};
+
+/// Number of contract specs fetched from the network at once.
+const MAX_FETCHES_IN_FLIGHT: usize = 4;
+
+/// File in each generated project holding the hash of what it was generated from.
+const INPUTS_HASH_FILE: &str = ".bindings-inputs.sha256";
+
+#[derive(Deserialize)]
+#[serde(deny_unknown_fields)]
+struct Manifest {
+    #[serde(default, rename = "contract")]
+    contracts: Vec<ManifestEntry>,
+}
+
+#[derive(Deserialize)]
+#[serde(deny_unknown_fields)]
+struct ManifestEntry {
+    contract_id: String,
+    output_dir: PathBuf,
+    wasm: Option<PathBuf>,
+}
+
+/// A project to generate, with everything it is generated from.
+struct Bindings {
+    output_dir: PathBuf,
+    contract_name: String,
+    contract_id: String,
+    spec: Vec<ScSpecEntry>,
+}
+
+enum Outcome {
+    /// Generated from the same inputs as last time, and no file had changed since.
+    Unchanged,
+    /// Generated from the same inputs as last time, rewriting files changed since.
+    Restored(usize),
+    Written(usize),
+}
+
+impl Cmd {
+    pub(super) async fn run_manifest(
+        &self,
+        global_args: Option<&global::Args>,
+        config: Option<&config::Args>,
+        path: &Path,
+    ) -> Result<(), Error> {
+        let contents = fs::read_to_string(path).map_err(|error| Error::CannotReadManifest {
+            path: path.to_path_buf(),
+            error,
+        })?;
+        let manifest: Manifest =
+            toml::from_str(&contents).map_err(|error| Error::InvalidManifest {
+                path: path.to_path_buf(),
+                error,
+            })?;
+        let base = path.parent().unwrap_or(Path::new(""));
+
+        let specs = stream::iter(&manifest.contracts)
+            .map(|entry| {
+                let wasm = entry.wasm.as_ref().map(|wasm| base.join(wasm));
+                async move {
+                    self.spec(wasm.as_deref(), &entry.contract_id, global_args, config)
+                        .await
+                }
+            })
+            .buffered(MAX_FETCHES_IN_FLIGHT)
+            .collect::<Vec<_>>()
+            .await;
+        let mut results = Vec::with_capacity(specs.len());
+        let mut bindings = Vec::new();
+        for (entry, spec) in manifest.contracts.iter().zip(specs) {
+            let output_dir = base.join(&entry.output_dir);
+            let prepared = spec.and_then(|spec| {
+                if output_dir.is_file() {
+                    return Err(Error::IsFile(output_dir.clone()));
+                }
+                fs::create_dir_all(&output_dir)?;
+                Ok(Bindings {
+                    contract_name: contract_name(&output_dir)?,
+                    output_dir: output_dir.clone(),
+                    contract_id: entry.contract_id.clone(),
+                    spec,
+                })
+            });
+            match prepared {
+                Ok(b) => {
+                    results.push(None);
+                    bindings.push((results.len() - 1, b));
+                }
+                Err(e) => results.push(Some(Err(e))),
+            }
+        }
+
+        let network = self.bindings_network();
+        for (i, res) in generate_all(&bindings, &network) {
+            results[i] = Some(res.map_err(Error::from));
+        }
+
+        let total = results.len();
+        let mut failed = 0;
+        for (entry, res) in manifest.contracts.iter().zip(results) {
+            let output_dir = entry.output_dir.display();
+            match res.expect("every contract has a result") {
+                Ok(Outcome::Unchanged) => eprintln!("{output_dir}: up to date"),
+                Ok(Outcome::Restored(n)) => eprintln!("{output_dir}: restored {n} files"),
+                Ok(Outcome::Written(0)) => eprintln!("{output_dir}: no files changed"),
+                Ok(Outcome::Written(n)) => eprintln!("{output_dir}: wrote {n} files"),
+                Err(e) => {
+                    failed += 1;
+                    eprintln!("error: {output_dir}: {e}");
+                }
+            }
+        }
+        if failed > 0 {
+            return Err(Error::ManifestFailed { failed, total });
+        }
+        Ok(())
+    }
+}
+
+/// Generates every project using all cores, returning the outcome for the index given with
+/// each.
+fn generate_all(
+    bindings: &[(usize, Bindings)],
+    network: &Network,
+) -> Vec<(usize, io::Result<Outcome>)> {
+    let next = AtomicUsize::new(0);
+    let workers = thread::available_parallelism()
+        .map_or(1, NonZeroUsize::get)
+        .min(bindings.len());
+    let next = &next;
+    thread::scope(|s| {
+        let workers = (0..workers)
+            .map(|_| {
+                s.spawn(move || {
+                    let mut done = Vec::new();
+                    while let Some((i, b)) = bindings.get(next.fetch_add(1, Ordering::Relaxed)) {
+                        done.push((*i, generate(b, network)));
+                    }
+                    done
+                })
+            })
+            .collect::<Vec<_>>();
+        workers
+            .into_iter()
+            .flat_map(|worker| worker.join().expect("bindings worker panicked"))
+            .collect()
+    })
+}
+
+/// Generates a project, writing only the files that differ from what is on disk, so that files
+/// deleted or edited since the last generation are restored.
+fn generate(b: &Bindings, network: &Network) -> io::Result<Outcome> {
+    let hash = inputs_hash(b, network)?;
+    let hash_file = b.output_dir.join(INPUTS_HASH_FILE);
+    let same_inputs = match fs::read_to_string(&hash_file) {
+        Ok(existing) => existing.trim() == hash,
+        Err(e) if e.kind() == io::ErrorKind::NotFound => false,
+        Err(e) => return Err(e),
+    };
+    let files = Project::files(
+        &b.contract_name,
+        &b.contract_id,
+        &network.rpc_url,
+        &network.network_passphrase,
+        &b.spec,
+    );
+    let written = Project::new(b.output_dir.clone()).write_changed(&files)?;
+    if same_inputs {
+        return Ok(match written.len() {
+            0 => Outcome::Unchanged,
+            n => Outcome::Restored(n),
+        });
+    }
+    fs::write(hash_file, hash)?;
+    Ok(Outcome::Written(written.len()))
+}
+
+/// Hash of everything a project is generated from, including the version and revision of the
+/// generator, as templates change between builds of the same version.
+fn inputs_hash(b: &Bindings, network: &Network) -> io::Result<String> {
+    let mut hasher = Sha256::new();
+    for part in [
+        env!("CARGO_PKG_VERSION"),
+        env!("GIT_REVISION"),
+        b.contract_name.as_str(),
+        b.contract_id.as_str(),
+        network.rpc_url.as_str(),
+        network.network_passphrase.as_str(),
+    ] {
+        hasher.update((part.len() as u64).to_le_bytes());
+        hasher.update(part);
+    }
+    for entry in &b.spec {
+        let xdr = entry
+            .to_xdr(Limits::none())
+            .map_err(|e| io::Error::new(io::ErrorKind::InvalidData, e))?;
+        hasher.update(xdr);
+    }
+    Ok(hex::encode(hasher.finalize()))
+}
@@ -1,16 +1,19 @@
 use clap::Parser;
 use itertools::Itertools;
 use std::{
-    collections::HashSet,
+    collections::{HashMap, HashSet},
     env,
     ffi::OsStr,
     fmt::Debug,
-    fs, io,
+    fs,
+    io::{self, BufReader},
     path::Path,
     process::{Command, ExitStatus, Stdio},
 };
 
-use cargo_metadata::{Metadata, MetadataCommand, Package};
+use cargo_metadata::{Message, Metadata, MetadataCommand, Package};
+
+use super::optimize;
 
 /// Build a contract from source
 ///
@@ -19,6 +22,9 @@ use cargo_metadata::{Metadata, MetadataCommand, Package};
 /// target. Unless configured otherwise, crates are built with their default
 /// features and with their release profile.
 ///
+/// When more than one crate is built, they are all built by a single cargo
+/// invocation, so that cargo can schedule them to use every core.
+///
 /// To view the commands that will be executed, without executing them, use the
 /// --print-commands-only option.
 #[derive(Parser, Debug, Clone)]
@@ -56,6 +62,16 @@ pub struct Cmd {
     /// If ommitted, wasm files are written only to the cargo target directory.
     #[arg(long)]
     pub out_dir: Option<std::path::PathBuf>,
+    /// Optimize each wasm file once it is built, writing it next to the built file with a
+    /// .optimized.wasm suffix. The optimized file is what gets copied to --out-dir.
+    ///
+    /// Optimized output is cached by the hash of the input, so an unchanged wasm file is not
+    /// optimized again.
+    #[arg(long)]
+    pub optimize: bool,
+    /// Number of parallel jobs cargo runs, defaults to the number of CPUs
+    #[arg(long, short = 'j', help_heading = "Other")]
+    pub jobs: Option<u32>,
     /// Print commands to build without executing them
     #[arg(long, conflicts_with = "out_dir", help_heading = "Other")]
     pub print_commands_only: bool,
@@ -77,6 +93,12 @@ pub enum Error {
     CopyingWasmFile(io::Error),
     #[error("getting the current directory: {0}")]
     GettingCurrentDir(io::Error),
+    #[error("reading cargo output: {0}")]
+    ReadingCargoOutput(io::Error),
+    #[error(transparent)]
+    Optimize(#[from] optimize::Error),
+    #[error("no wasm file was built for {}; check that they have crate-type cdylib", .packages.join(", "))]
+    MissingWasm { packages: Vec<String> },
 }
 
 impl Cmd {
@@ -95,6 +117,10 @@ impl Cmd {
             }
         }
 
+        if packages.len() > 1 {
+            return self.build_packages(&packages);
+        }
+
         for p in packages {
             let mut cmd = Command::new("cargo");
             cmd.stdout(Stdio::piped());
@@ -106,18 +132,7 @@ impl Cmd {
                 manifest_path.to_string_lossy()
             ));
             cmd.arg("--crate-type=cdylib");
-            cmd.arg("--target=wasm32-unknown-unknown");
-            if self.profile == "release" {
-                cmd.arg("--release");
-            } else {
-                cmd.arg(format!("--profile={}", self.profile));
-            }
-            if self.all_features {
-                cmd.arg("--all-features");
-            }
-            if self.no_default_features {
-                cmd.arg("--no-default-features");
-            }
+            self.add_common_args(&mut cmd);
             if let Some(features) = self.features() {
                 let requested: HashSet<String> = features.iter().cloned().collect();
                 let available = p.features.iter().map(|f| f.0).cloned().collect();
@@ -140,20 +155,147 @@ impl Cmd {
                     return Err(Error::Exit(status));
                 }
 
-                if let Some(out_dir) = &self.out_dir {
-                    fs::create_dir_all(out_dir).map_err(Error::CreatingOutDir)?;
+                let file = format!("{}.wasm", p.name.replace('-', "_"));
+                let target_file_path = Path::new(target_dir)
+                    .join("wasm32-unknown-unknown")
+                    .join(&self.profile)
+                    .join(&file);
+                self.finish_package(&p.name, &target_file_path)?;
+            }
+        }
+
+        Ok(())
+    }
+
+    /// Builds several packages with one cargo invocation, printing compiler messages prefixed
+    /// with the package they are for, and copying each wasm file to the out dir as soon as its
+    /// package is built.
+    fn build_packages(&self, packages: &[Package]) -> Result<(), Error> {
+        let mut cmd = Command::new("cargo");
+        cmd.arg("build");
+        cmd.arg(format!(
+            "--manifest-path={}",
+            self.manifest_path.to_string_lossy()
+        ));
+        for p in packages {
+            cmd.arg(format!("--package={}", p.name));
+        }
+        self.add_common_args(&mut cmd);
+        if let Some(features) = self.features() {
+            // Only activate each feature on the packages that have it.
+            let activate = packages
+                .iter()
+                .flat_map(|p| {
+                    features
+                        .iter()
+                        .filter(|f| p.features.contains_key(*f))
+                        .map(|f| format!("{}/{f}", p.name))
+                })
+                .join(",");
+            if !activate.is_empty() {
+                cmd.arg(format!("--features={activate}"));
+            }
+        }
+        let cmd_str = format!(
+            "cargo {}",
+            cmd.get_args().map(OsStr::to_string_lossy).join(" ")
+        );
+        if self.print_commands_only {
+            println!("{cmd_str}");
+            return Ok(());
+        }
+        eprintln!("{cmd_str}");
 
-                    let file = format!("{}.wasm", p.name.replace('-', "_"));
-                    let target_file_path = Path::new(target_dir)
-                        .join("wasm32-unknown-unknown")
-                        .join(&self.profile)
-                        .join(&file);
-                    let out_file_path = Path::new(out_dir).join(&file);
-                    fs::copy(target_file_path, out_file_path).map_err(Error::CopyingWasmFile)?;
+        cmd.arg("--message-format=json");
+        cmd.stdout(Stdio::piped());
+        let mut child = cmd.spawn().map_err(Error::CargoCmd)?;
+        let names: HashMap<_, _> = packages.iter().map(|p| (&p.id, &p.name)).collect();
+        let mut finished = HashSet::new();
+        let stdout = child.stdout.take().expect("stdout is piped");
+        for message in Message::parse_stream(BufReader::new(stdout)) {
+            match message.map_err(Error::ReadingCargoOutput)? {
+                Message::CompilerMessage(msg) => {
+                    let name = names.get(&msg.package_id).map_or("", |name| name.as_str());
+                    if let Some(rendered) = &msg.message.rendered {
+                        for line in rendered.lines() {
+                            eprintln!("[{name}] {line}");
+                        }
+                    }
+                }
+                Message::CompilerArtifact(artifact) => {
+                    let Some(name) = names.get(&artifact.package_id) else {
+                        continue;
+                    };
+                    let Some(wasm) = artifact
+                        .filenames
+                        .iter()
+                        .find(|f| f.extension() == Some("wasm"))
+                    else {
+                        continue;
+                    };
+                    eprintln!("[{name}] built {wasm}");
+                    self.finish_package(name, wasm.as_std_path())?;
+                    finished.insert(artifact.package_id.clone());
                 }
+                Message::TextLine(line) => println!("{line}"),
+                _ => {}
             }
         }
+        let status = child.wait().map_err(Error::CargoCmd)?;
+        if !status.success() {
+            return Err(Error::Exit(status));
+        }
+        let missing = packages
+            .iter()
+            .filter(|p| !finished.contains(&p.id))
+            .map(|p| p.name.clone())
+            .collect::<Vec<_>>();
+        if !missing.is_empty() {
+            return Err(Error::MissingWasm { packages: missing });
+        }
+        Ok(())
+    }
 
+    fn add_common_args(&self, cmd: &mut Command) {
+        cmd.arg("--target=wasm32-unknown-unknown");
+        if self.profile == "release" {
+            cmd.arg("--release");
+        } else {
+            cmd.arg(format!("--profile={}", self.profile));
+        }
+        if self.all_features {
+            cmd.arg("--all-features");
+        }
+        if self.no_default_features {
+            cmd.arg("--no-default-features");
+        }
+        if let Some(jobs) = self.jobs {
+            cmd.arg(format!("--jobs={jobs}"));
+        }
+    }
+
+    /// Runs the stages that follow the build of a package: optimizing its wasm file if asked
+    /// to, and copying the result to the out dir.
+    fn finish_package(&self, name: &str, wasm: &Path) -> Result<(), Error> {
+        let Some(file_name) = wasm.file_name() else {
+            return Ok(());
+        };
+        let wasm = if self.optimize {
+            let wasm_out = wasm.with_extension("optimized.wasm");
+            let cached = optimize::optimize(wasm, &wasm_out)?;
+            eprintln!(
+                "[{name}] optimized {}{}",
+                wasm_out.display(),
+                if cached { " (cached)" } else { "" }
+            );
+            wasm_out
+        } else {
+            wasm.to_path_buf()
+        };
+        if let Some(out_dir) = &self.out_dir {
+            fs::create_dir_all(out_dir).map_err(Error::CreatingOutDir)?;
+            fs::copy(wasm, out_dir.join(file_name)).map_err(Error::CopyingWasmFile)?;
+        }
         Ok(())
     }
 
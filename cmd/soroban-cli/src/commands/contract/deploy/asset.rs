@@ -18,7 +18,8 @@ use crate::{
         txn_result::{TxnEnvelopeResult, TxnResult},
         NetworkRunnable,
     },
-    rpc::{Client, Error as SorobanRpcError},
+    metrics,
+    rpc::Error as SorobanRpcError,
     utils::{contract_id_hash_from_asset, parsing::parse_asset},
 };
 
@@ -93,17 +94,20 @@ impl NetworkRunnable for Cmd {
         let asset = parse_asset(&self.asset)?;
 
         let network = config.get_network()?;
-        let client = Client::new(&network.rpc_url)?;
-        client
-            .verify_network_passphrase(Some(&network.network_passphrase))
-            .await?;
+        let client = network.rpc_client()?;
+        metrics::phase(
+            "verify_network_passphrase",
+            client.verify_network_passphrase(Some(&network.network_passphrase)),
+        )
+        .await?;
         let key = config.key_pair()?;
 
         // Get the account sequence number
         let public_strkey =
             stellar_strkey::ed25519::PublicKey(key.verifying_key().to_bytes()).to_string();
         // TODO: use symbols for the method names (both here and in serve)
-        let account_details = client.get_account(&public_strkey).await?;
+        let account_details =
+            metrics::phase("get_account", client.get_account(&public_strkey)).await?;
         let sequence: i64 = account_details.seq_num.into();
         let network_passphrase = &network.network_passphrase;
         let contract_id = contract_id_hash_from_asset(&asset, network_passphrase)?;
@@ -118,15 +122,16 @@ impl NetworkRunnable for Cmd {
         if self.fee.build_only {
             return Ok(TxnResult::Txn(tx));
         }
-        let txn = client.simulate_and_assemble_transaction(&tx).await?;
+        let txn = metrics::phase("simulate", client.simulate_and_assemble_transaction(&tx)).await?;
         let txn = self.fee.apply_to_assembled_txn(txn).transaction().clone();
+        metrics::record_simulation(&txn);
         if self.fee.sim_only {
             return Ok(TxnResult::Txn(txn));
         }
-        let get_txn_resp = client
-            .send_transaction_polling(&self.config.sign_with_local_key(txn).await?)
-            .await?
-            .try_into()?;
+        let signed = metrics::phase("sign", self.config.sign_with_local_key(txn.clone())).await?;
+        let res = metrics::phase("send", client.send_transaction_polling(&signed)).await?;
+        metrics::record_result(&txn, &res);
+        let get_txn_resp = res.try_into()?;
         if args.map_or(true, |a| !a.no_cache) {
             data::write(get_txn_resp, &network.rpc_uri()?)?;
         }
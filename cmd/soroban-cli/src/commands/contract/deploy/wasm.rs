@@ -24,15 +24,16 @@ use crate::commands::{
 };
 use crate::{
     commands::{config, contract::install, HEADING_RPC},
-    rpc::{self, Client},
-    utils, wasm,
+    metrics, rpc, utils, wasm,
 };
 
+mod manifest;
+
 #[derive(Parser, Debug, Clone)]
 #[command(group(
     clap::ArgGroup::new("wasm_src")
         .required(true)
-        .args(&["wasm", "wasm_hash"]),
+        .args(&["wasm", "wasm_hash", "manifest"]),
 ))]
 #[group(skip)]
 pub struct Cmd {
@@ -42,6 +43,18 @@ pub struct Cmd {
     /// Hash of the already installed/deployed WASM file
     #[arg(long = "wasm-hash", conflicts_with = "wasm", group = "wasm_src")]
     pub wasm_hash: Option<String>,
+    /// TOML manifest listing several contracts to deploy
+    ///
+    /// Each `[[contract]]` table sets the `wasm` file to deploy, relative to the manifest, and
+    /// optionally an `alias` to save the contract id as and a hex `salt`. Every wasm file is
+    /// hashed up front and only those not already installed on the network are uploaded, once
+    /// each, before contracts are created.
+    #[arg(
+        long,
+        group = "wasm_src",
+        conflicts_with_all = ["salt", "alias", "build_only", "sim_only"],
+    )]
+    pub manifest: Option<std::path::PathBuf>,
     /// Custom salt 32-byte salt for the token id
     #[arg(
         long,
@@ -112,10 +125,29 @@ pub enum Error {
     InvalidAliasFormat { alias: String },
     #[error(transparent)]
     Locator(#[from] locator::Error),
+    #[error(transparent)]
+    Pipeline(#[from] contract::pipeline::Error),
+    #[error("cannot read manifest {path}: {error}")]
+    CannotReadManifest {
+        path: std::path::PathBuf,
+        error: std::io::Error,
+    },
+    #[error("invalid manifest {path}: {error}")]
+    InvalidManifest {
+        path: std::path::PathBuf,
+        error: toml::de::Error,
+    },
+    #[error("uploading {wasm} failed")]
+    UploadFailed { wasm: std::path::PathBuf },
+    #[error("{failed} of {total} contracts failed to deploy")]
+    ManifestFailed { failed: usize, total: usize },
 }
 
 impl Cmd {
     pub async fn run(&self) -> Result<(), Error> {
+        if let Some(manifest) = &self.manifest {
+            return self.run_manifest(None, manifest).await;
+        }
         let res = self.run_against_rpc_server(None, None).await?.to_envelope();
         match res {
             TxnEnvelopeResult::TxnEnvelope(tx) => println!("{}", tx.to_xdr_base64(Limits::none())?),
@@ -149,6 +181,21 @@ fn alias_validator(alias: &str) -> Result<String, Error> {
     }
 }
 
+/// Parses a hex salt, or generates a random one if none is given.
+fn parse_salt(salt: Option<&str>) -> Result<[u8; 32], Error> {
+    match salt {
+        Some(h) => soroban_spec_tools::utils::padded_hex_from_str(h, 32)
+            .map_err(|_| Error::CannotParseSalt {
+                salt: h.to_string(),
+            })?
+            .try_into()
+            .map_err(|_| Error::CannotParseSalt {
+                salt: h.to_string(),
+            }),
+        None => Ok(rand::thread_rng().gen::<[u8; 32]>()),
+    }
+}
+
 #[async_trait::async_trait]
 impl NetworkRunnable for Cmd {
     type Error = Error;
@@ -190,25 +237,22 @@ impl NetworkRunnable for Cmd {
             }
         })?);
         let network = config.get_network()?;
-        let salt: [u8; 32] = match &self.salt {
-            Some(h) => soroban_spec_tools::utils::padded_hex_from_str(h, 32)
-                .map_err(|_| Error::CannotParseSalt { salt: h.clone() })?
-                .try_into()
-                .map_err(|_| Error::CannotParseSalt { salt: h.clone() })?,
-            None => rand::thread_rng().gen::<[u8; 32]>(),
-        };
+        let salt = parse_salt(self.salt.as_deref())?;
 
-        let client = Client::new(&network.rpc_url)?;
-        client
-            .verify_network_passphrase(Some(&network.network_passphrase))
-            .await?;
+        let client = network.rpc_client()?;
+        metrics::phase(
+            "verify_network_passphrase",
+            client.verify_network_passphrase(Some(&network.network_passphrase)),
+        )
+        .await?;
         let key = config.key_pair()?;
 
         // Get the account sequence number
         let public_strkey =
             stellar_strkey::ed25519::PublicKey(key.verifying_key().to_bytes()).to_string();
 
-        let account_details = client.get_account(&public_strkey).await?;
+        let account_details =
+            metrics::phase("get_account", client.get_account(&public_strkey)).await?;
         let sequence: i64 = account_details.seq_num.into();
         let (txn, contract_id) = build_create_contract_tx(
             wasm_hash,
@@ -222,15 +266,17 @@ impl NetworkRunnable for Cmd {
             return Ok(TxnResult::Txn(txn));
         }
 
-        let txn = client.simulate_and_assemble_transaction(&txn).await?;
+        let txn =
+            metrics::phase("simulate", client.simulate_and_assemble_transaction(&txn)).await?;
         let txn = self.fee.apply_to_assembled_txn(txn).transaction().clone();
+        metrics::record_simulation(&txn);
         if self.fee.sim_only {
             return Ok(TxnResult::Txn(txn));
         }
-        let get_txn_resp = client
-            .send_transaction_polling(&config.sign_with_local_key(txn).await?)
-            .await?
-            .try_into()?;
+        let signed = metrics::phase("sign", config.sign_with_local_key(txn.clone())).await?;
+        let res = metrics::phase("send", client.send_transaction_polling(&signed)).await?;
+        metrics::record_result(&txn, &res);
+        let get_txn_resp = res.try_into()?;
         if global_args.map_or(true, |a| !a.no_cache) {
             data::write(get_txn_resp, &network.rpc_uri()?)?;
         }
@@ -0,0 +1,224 @@
+use std::{
+    collections::{HashMap, HashSet},
+    fs,
+    path::{Path, PathBuf},
+};
+
+use itertools::Itertools;
+use serde::Deserialize;
+use soroban_env_host::xdr::{Hash, LedgerKey, LedgerKeyContractCode, Limits, ReadXdr};
+use soroban_spec_tools::contract::Spec;
+
+use super::{alias_validator, build_create_contract_tx, parse_salt, Cmd, Error};
+use crate::{
+    commands::{
+        config::data,
+        contract::{
+            install::{self, build_install_contract_code_tx},
+            pipeline::Pipeline,
+        },
+        global,
+    },
+    wasm,
+};
+
+/// Maximum number of keys the RPC server accepts in a single `getLedgerEntries` request.
+const MAX_LEDGER_KEYS_PER_REQUEST: usize = 200;
+
+#[derive(Deserialize)]
+#[serde(deny_unknown_fields)]
+struct Manifest {
+    #[serde(default, rename = "contract")]
+    contracts: Vec<ManifestEntry>,
+}
+
+#[derive(Deserialize)]
+#[serde(deny_unknown_fields)]
+struct ManifestEntry {
+    wasm: PathBuf,
+    alias: Option<String>,
+    salt: Option<String>,
+}
+
+/// A wasm file used by one or more contracts of the manifest.
+struct Code {
+    wasm: PathBuf,
+    contents: wasm::Loaded,
+    spec: Spec,
+}
+
+struct Contract {
+    alias: Option<String>,
+    salt: [u8; 32],
+    hash: Hash,
+}
+
+impl Cmd {
+    pub(super) async fn run_manifest(
+        &self,
+        global_args: Option<&global::Args>,
+        path: &Path,
+    ) -> Result<(), Error> {
+        let contents = fs::read_to_string(path).map_err(|error| Error::CannotReadManifest {
+            path: path.to_path_buf(),
+            error,
+        })?;
+        let manifest: Manifest =
+            toml::from_str(&contents).map_err(|error| Error::InvalidManifest {
+                path: path.to_path_buf(),
+                error,
+            })?;
+        let base = path.parent().unwrap_or(Path::new(""));
+
+        let config = &self.config;
+        let network = config.get_network()?;
+        let client = network.rpc_client()?;
+        client
+            .verify_network_passphrase(Some(&network.network_passphrase))
+            .await?;
+
+        // Hash every wasm file up front, contracts sharing a wasm file share its upload.
+        let mut codes = HashMap::<Hash, Code>::new();
+        let mut contracts = Vec::with_capacity(manifest.contracts.len());
+        for entry in manifest.contracts {
+            let wasm = base.join(&entry.wasm);
+            let contents = wasm::Args { wasm: wasm.clone() }.load()?;
+            let hash = contents.hash();
+            if !codes.contains_key(&hash) {
+                let spec = contents
+                    .parse()
+                    .map_err(|error| install::Error::CannotParseWasm {
+                        wasm: wasm.clone(),
+                        error,
+                    })?;
+                install::check_sdk_version(
+                    &wasm,
+                    &spec,
+                    &network.network_passphrase,
+                    self.ignore_checks,
+                )?;
+                codes.insert(
+                    hash.clone(),
+                    Code {
+                        wasm,
+                        contents,
+                        spec,
+                    },
+                );
+            }
+            contracts.push(Contract {
+                alias: entry.alias.as_deref().map(alias_validator).transpose()?,
+                salt: parse_salt(entry.salt.as_deref())?,
+                hash,
+            });
+        }
+
+        // Find out which wasm is already installed with as few round trips as possible.
+        let keys = codes
+            .keys()
+            .map(|hash| LedgerKey::ContractCode(LedgerKeyContractCode { hash: hash.clone() }))
+            .collect::<Vec<_>>();
+        let mut installed = HashSet::new();
+        for keys in keys.chunks(MAX_LEDGER_KEYS_PER_REQUEST) {
+            let res = client.get_ledger_entries(keys).await?;
+            for entry in res.entries.unwrap_or_default() {
+                if let LedgerKey::ContractCode(LedgerKeyContractCode { hash }) =
+                    LedgerKey::from_xdr_base64(&entry.key, Limits::none())?
+                {
+                    if install::is_installed(&entry.xdr)? {
+                        installed.insert(hash);
+                    }
+                }
+            }
+        }
+
+        let key = config.key_pair()?;
+        let pipeline = Pipeline::new(
+            &client,
+            &key,
+            &network,
+            &self.fee,
+            global_args.map_or(false, |a| a.no_cache),
+        )
+        .await?;
+        let sequence = pipeline.sequence();
+
+        // Contracts can only be created once their wasm is on the ledger, so all uploads are
+        // confirmed before any contract creation is simulated.
+        let mut uploads = Vec::new();
+        for hash in contracts.iter().map(|c| &c.hash).unique() {
+            if !installed.contains(hash) {
+                let code = &codes[hash];
+                let (tx, _) =
+                    build_install_contract_code_tx(&code.contents, sequence, self.fee.fee, &key)?;
+                uploads.push((hash.clone(), tx));
+            }
+        }
+        let (hashes, txs): (Vec<_>, Vec<_>) = uploads.into_iter().unzip();
+        for (hash, res) in hashes.into_iter().zip(pipeline.run(txs).await) {
+            let code = &codes[&hash];
+            match res {
+                Ok(_) => {
+                    eprintln!("uploaded {} ({hash})", code.wasm.display());
+                    if !pipeline.no_cache() {
+                        data::write_spec(&hash.to_string(), &code.spec.spec)?;
+                    }
+                    installed.insert(hash);
+                }
+                Err(e) => eprintln!("error: uploading {}: {e}", code.wasm.display()),
+            }
+        }
+
+        let mut results = Vec::with_capacity(contracts.len());
+        let mut creates = Vec::new();
+        for (i, contract) in contracts.iter().enumerate() {
+            if installed.contains(&contract.hash) {
+                let (tx, contract_id) = build_create_contract_tx(
+                    contract.hash.clone(),
+                    sequence,
+                    self.fee.fee,
+                    &network.network_passphrase,
+                    contract.salt,
+                    &key,
+                )?;
+                results.push(Ok(stellar_strkey::Contract(contract_id.0).to_string()));
+                creates.push((i, tx));
+            } else {
+                results.push(Err(Error::UploadFailed {
+                    wasm: codes[&contract.hash].wasm.clone(),
+                }));
+            }
+        }
+        let (indexes, txs): (Vec<_>, Vec<_>) = creates.into_iter().unzip();
+        for (i, res) in indexes.into_iter().zip(pipeline.run(txs).await) {
+            if let Err(e) = res {
+                results[i] = Err(e.into());
+            }
+        }
+
+        let total = results.len();
+        let mut failed = 0;
+        for (contract, res) in contracts.iter().zip(results) {
+            match res {
+                Ok(contract_id) => {
+                    if let Some(alias) = &contract.alias {
+                        config.locator.save_contract_id(
+                            &network.network_passphrase,
+                            &contract_id,
+                            alias,
+                        )?;
+                    }
+                    println!("{contract_id}");
+                }
+                Err(e) => {
+                    failed += 1;
+                    eprintln!("error: {e}");
+                }
+            }
+        }
+        if failed > 0 {
+            return Err(Error::ManifestFailed { failed, total });
+        }
+        Ok(())
+    }
+}
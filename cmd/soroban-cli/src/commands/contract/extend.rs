@@ -1,25 +1,30 @@
-use std::{fmt::Debug, path::Path, str::FromStr};
+use std::{
+    fmt::Debug,
+    path::{Path, PathBuf},
+    str::FromStr,
+};
 
 use clap::{command, Parser};
 use soroban_env_host::xdr::{
     Error as XdrError, ExtendFootprintTtlOp, ExtensionPoint, LedgerEntry, LedgerEntryChange,
-    LedgerEntryData, LedgerFootprint, Limits, Memo, MuxedAccount, Operation, OperationBody,
-    Preconditions, SequenceNumber, SorobanResources, SorobanTransactionData, Transaction,
-    TransactionExt, TransactionMeta, TransactionMetaV3, TtlEntry, Uint256, WriteXdr,
+    LedgerEntryData, LedgerFootprint, LedgerKey, Limits, Memo, MuxedAccount, Operation,
+    OperationBody, Preconditions, SequenceNumber, SorobanResources, SorobanTransactionData,
+    Transaction, TransactionExt, TransactionMeta, TransactionMetaV3, TtlEntry, Uint256, WriteXdr,
 };
 
 use crate::{
     commands::{
         config::{self, data, locator},
+        contract::pipeline,
         global, network,
         txn_result::{TxnEnvelopeResult, TxnResult},
         NetworkRunnable,
     },
-    key,
-    rpc::{self, Client},
-    wasm, Pwd,
+    key, metrics, rpc, wasm, Pwd,
 };
 
+mod plan;
+
 const MAX_LEDGERS_TO_EXTEND: u32 = 535_679;
 
 #[derive(Parser, Debug, Clone)]
@@ -33,6 +38,16 @@ pub struct Cmd {
     pub ttl_ledger_only: bool,
     #[command(flatten)]
     pub key: key::Args,
+    /// File of storage keys (base64-encoded XDR) to extend, one per line, or `-` for stdin
+    ///
+    /// The TTL of every entry is fetched first, and entries that already live at least
+    /// --ledgers-to-extend ledgers are skipped. The rest are packed into as few transactions as
+    /// the network's footprint limits allow, which are then submitted as a pipeline.
+    #[arg(
+        long,
+        conflicts_with_all = ["key", "key_xdr", "wasm", "wasm_hash", "build_only", "sim_only"],
+    )]
+    pub plan: Option<PathBuf>,
     #[command(flatten)]
     pub config: config::Args,
     #[command(flatten)]
@@ -86,11 +101,20 @@ pub enum Error {
     Network(#[from] network::Error),
     #[error(transparent)]
     Locator(#[from] locator::Error),
+    #[error(transparent)]
+    Pipeline(#[from] pipeline::Error),
+    #[error("cannot find the footprint limits of the network")]
+    MissingNetworkLimits,
+    #[error("{failed} of {total} extend transactions failed")]
+    PlanFailed { failed: usize, total: usize },
 }
 
 impl Cmd {
     #[allow(clippy::too_many_lines)]
-    pub async fn run(&self) -> Result<(), Error> {
+    pub async fn run(&self, global_args: &global::Args) -> Result<(), Error> {
+        if let Some(path) = &self.plan {
+            return self.run_plan(path, global_args).await;
+        }
         let res = self.run_against_rpc_server(None, None).await?.to_envelope();
         match res {
             TxnEnvelopeResult::TxnEnvelope(tx) => println!("{}", tx.to_xdr_base64(Limits::none())?),
@@ -115,6 +139,43 @@ impl Cmd {
         }
         res
     }
+
+    fn build_tx(
+        &self,
+        keys: Vec<LedgerKey>,
+        sequence: i64,
+        key: &ed25519_dalek::SigningKey,
+        extend_to: u32,
+    ) -> Result<Transaction, Error> {
+        Ok(Transaction {
+            source_account: MuxedAccount::Ed25519(Uint256(key.verifying_key().to_bytes())),
+            fee: self.fee.fee,
+            seq_num: SequenceNumber(sequence),
+            cond: Preconditions::None,
+            memo: Memo::None,
+            operations: vec![Operation {
+                source_account: None,
+                body: OperationBody::ExtendFootprintTtl(ExtendFootprintTtlOp {
+                    ext: ExtensionPoint::V0,
+                    extend_to,
+                }),
+            }]
+            .try_into()?,
+            ext: TransactionExt::V1(SorobanTransactionData {
+                ext: ExtensionPoint::V0,
+                resources: SorobanResources {
+                    footprint: LedgerFootprint {
+                        read_only: keys.try_into()?,
+                        read_write: vec![].try_into()?,
+                    },
+                    instructions: self.fee.instructions.unwrap_or_default(),
+                    read_bytes: 0,
+                    write_bytes: 0,
+                },
+                resource_fee: 0,
+            }),
+        })
+    }
 }
 
 #[async_trait::async_trait]
@@ -136,55 +197,29 @@ impl NetworkRunnable for Cmd {
         )?;
         let keys = self.key.parse_keys(contract)?;
         let network = &config.get_network()?;
-        let client = Client::new(&network.rpc_url)?;
+        let client = network.rpc_client()?;
         let key = config.key_pair()?;
         let extend_to = self.ledgers_to_extend();
 
         // Get the account sequence number
         let public_strkey =
             stellar_strkey::ed25519::PublicKey(key.verifying_key().to_bytes()).to_string();
-        let account_details = client.get_account(&public_strkey).await?;
+        let account_details =
+            metrics::phase("get_account", client.get_account(&public_strkey)).await?;
         let sequence: i64 = account_details.seq_num.into();
 
-        let tx = Transaction {
-            source_account: MuxedAccount::Ed25519(Uint256(key.verifying_key().to_bytes())),
-            fee: self.fee.fee,
-            seq_num: SequenceNumber(sequence + 1),
-            cond: Preconditions::None,
-            memo: Memo::None,
-            operations: vec![Operation {
-                source_account: None,
-                body: OperationBody::ExtendFootprintTtl(ExtendFootprintTtlOp {
-                    ext: ExtensionPoint::V0,
-                    extend_to,
-                }),
-            }]
-            .try_into()?,
-            ext: TransactionExt::V1(SorobanTransactionData {
-                ext: ExtensionPoint::V0,
-                resources: SorobanResources {
-                    footprint: LedgerFootprint {
-                        read_only: keys.clone().try_into()?,
-                        read_write: vec![].try_into()?,
-                    },
-                    instructions: self.fee.instructions.unwrap_or_default(),
-                    read_bytes: 0,
-                    write_bytes: 0,
-                },
-                resource_fee: 0,
-            }),
-        };
+        let tx = self.build_tx(keys.clone(), sequence + 1, &key, extend_to)?;
         if self.fee.build_only {
             return Ok(TxnResult::Txn(tx));
         }
-        let tx = client
-            .simulate_and_assemble_transaction(&tx)
+        let tx = metrics::phase("simulate", client.simulate_and_assemble_transaction(&tx))
             .await?
             .transaction()
             .clone();
-        let res = client
-            .send_transaction_polling(&config.sign_with_local_key(tx).await?)
-            .await?;
+        metrics::record_simulation(&tx);
+        let signed = metrics::phase("sign", config.sign_with_local_key(tx.clone())).await?;
+        let res = metrics::phase("send", client.send_transaction_polling(&signed)).await?;
+        metrics::record_result(&tx, &res);
         if args.map_or(true, |a| !a.no_cache) {
             data::write(res.clone().try_into()?, &network.rpc_uri()?)?;
         }
@@ -0,0 +1,179 @@
+use std::path::Path;
+
+use futures_util::{stream, StreamExt, TryStreamExt};
+use soroban_env_host::xdr::{
+    ConfigSettingEntry, ConfigSettingId, LedgerEntryData, LedgerKey, LedgerKeyConfigSetting,
+    Limits, WriteXdr,
+};
+
+use super::{Cmd, Error};
+use crate::{
+    commands::{contract::pipeline::Pipeline, global},
+    key, rpc,
+};
+
+/// Maximum number of keys the RPC server accepts in a single `getLedgerEntries` request.
+const MAX_KEYS_PER_REQUEST: usize = 200;
+
+/// Number of `getLedgerEntries` requests in flight at once when fetching TTLs.
+const MAX_REQUESTS_IN_FLIGHT: usize = 4;
+
+/// The most a single transaction's footprint may read, as configured on the network.
+struct FootprintLimits {
+    entries: usize,
+    bytes: usize,
+}
+
+impl Cmd {
+    /// Extends every key listed in `path` that is not already live long enough, in as few
+    /// transactions as possible.
+    pub(super) async fn run_plan(
+        &self,
+        path: &Path,
+        global_args: &global::Args,
+    ) -> Result<(), Error> {
+        let config = &self.config;
+        let network = config.get_network()?;
+        tracing::trace!(?network);
+        let client = network.rpc_client()?;
+        let contract = config.locator.resolve_contract_id(
+            self.key.contract_id.as_ref().unwrap(),
+            &network.network_passphrase,
+        )?;
+        let mut keys = key::read_key_file(path)?
+            .map(|key| Ok(self.key.contract_data_key(&contract, key?)))
+            .collect::<Result<Vec<_>, Error>>()?;
+        keys.sort();
+        keys.dedup();
+        let extend_to = self.ledgers_to_extend();
+        let limits = footprint_limits(&client).await?;
+
+        let responses = stream::iter(keys.chunks(MAX_KEYS_PER_REQUEST))
+            .map(|keys| client.get_full_ledger_entries(keys))
+            .buffered(MAX_REQUESTS_IN_FLIGHT)
+            .try_collect::<Vec<_>>()
+            .await?;
+        let mut found = 0;
+        let mut live = 0;
+        let mut entries = Vec::new();
+        for res in responses {
+            let target = res.latest_ledger + i64::from(extend_to);
+            for entry in res.entries {
+                found += 1;
+                if i64::from(entry.live_until_ledger_seq) >= target {
+                    live += 1;
+                    continue;
+                }
+                let size = entry.key.to_xdr(Limits::none())?.len()
+                    + entry.val.to_xdr(Limits::none())?.len();
+                entries.push((entry.key, size));
+            }
+        }
+        if found < keys.len() {
+            tracing::warn!(
+                "{} entries were not found, archived entries need to be restored with `contract restore`",
+                keys.len() - found
+            );
+        }
+        let extending = entries.len();
+        eprintln!("{live} entries are already live long enough, extending {extending}");
+        let groups = pack(entries, &limits);
+        if groups.is_empty() {
+            return Ok(());
+        }
+
+        let key = config.key_pair()?;
+        let pipeline =
+            Pipeline::new(&client, &key, &network, &self.fee, global_args.no_cache).await?;
+        let sizes = groups.iter().map(Vec::len).collect::<Vec<_>>();
+        let txs = groups
+            .into_iter()
+            .map(|keys| self.build_tx(keys, pipeline.sequence(), &key, extend_to))
+            .collect::<Result<Vec<_>, Error>>()?;
+        let total = txs.len();
+        let mut failed = 0;
+        for (size, res) in sizes.into_iter().zip(pipeline.run(txs).await) {
+            match res {
+                Ok(_) => eprintln!("extended {size} entries"),
+                Err(e) => {
+                    failed += 1;
+                    eprintln!("error: extending {size} entries: {e}");
+                }
+            }
+        }
+        if failed > 0 {
+            return Err(Error::PlanFailed { failed, total });
+        }
+        println!("Extended {extending} entries in {total} transactions");
+        Ok(())
+    }
+}
+
+async fn footprint_limits(client: &rpc::Client) -> Result<FootprintLimits, Error> {
+    let key = LedgerKey::ConfigSetting(LedgerKeyConfigSetting {
+        config_setting_id: ConfigSettingId::ContractLedgerCostV0,
+    });
+    let res = client.get_full_ledger_entries(&[key]).await?;
+    match res.entries.first().map(|entry| &entry.val) {
+        Some(LedgerEntryData::ConfigSetting(ConfigSettingEntry::ContractLedgerCostV0(cost))) => {
+            Ok(FootprintLimits {
+                entries: cost.tx_max_read_ledger_entries as usize,
+                bytes: cost.tx_max_read_bytes as usize,
+            })
+        }
+        _ => Err(Error::MissingNetworkLimits),
+    }
+}
+
+/// Groups keys, in order, so that each group's entries fit in the footprint of one
+/// transaction. An entry too large to share a transaction gets one of its own.
+fn pack(entries: Vec<(LedgerKey, usize)>, limits: &FootprintLimits) -> Vec<Vec<LedgerKey>> {
+    let mut groups = Vec::new();
+    let mut group = Vec::new();
+    let mut bytes = 0;
+    for (key, size) in entries {
+        if !group.is_empty() && (group.len() >= limits.entries || bytes + size > limits.bytes) {
+            groups.push(std::mem::take(&mut group));
+            bytes = 0;
+        }
+        group.push(key);
+        bytes += size;
+    }
+    if !group.is_empty() {
+        groups.push(group);
+    }
+    groups
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use soroban_env_host::xdr::{Hash, LedgerKeyContractCode};
+
+    fn key(i: u8) -> LedgerKey {
+        LedgerKey::ContractCode(LedgerKeyContractCode {
+            hash: Hash([i; 32]),
+        })
+    }
+
+    #[test]
+    fn pack_respects_entry_and_byte_limits() {
+        let limits = FootprintLimits {
+            entries: 3,
+            bytes: 100,
+        };
+        let sizes = |groups: Vec<Vec<LedgerKey>>| groups.iter().map(Vec::len).collect::<Vec<_>>();
+        assert_eq!(
+            sizes(pack((0..7).map(|i| (key(i), 10)).collect(), &limits)),
+            [3, 3, 1]
+        );
+        assert_eq!(
+            sizes(pack(
+                vec![(key(0), 60), (key(1), 60), (key(2), 200), (key(3), 1)],
+                &limits
+            )),
+            [1, 1, 1, 1]
+        );
+        assert!(pack(vec![], &limits).is_empty());
+    }
+}
@@ -22,10 +22,7 @@ use stellar_strkey::DecodeError;
 use super::super::config::{self, locator};
 use crate::commands::network::{self, Network};
 use crate::commands::{global, NetworkRunnable};
-use crate::{
-    rpc::{self, Client},
-    Pwd,
-};
+use crate::{rpc, Pwd};
 
 #[derive(Parser, Debug, Default, Clone)]
 #[allow(clippy::struct_excessive_bools)]
@@ -144,7 +141,7 @@ impl NetworkRunnable for Cmd {
         let network = config.map_or_else(|| self.network(), |c| Ok(c.get_network()?))?;
         tracing::trace!(?network);
         let contract_id = self.contract_id()?;
-        let client = Client::new(&network.rpc_url)?;
+        let client = network.rpc_client()?;
         client
             .verify_network_passphrase(Some(&network.network_passphrase))
             .await?;
@@ -1,7 +1,16 @@
+use base64::{engine::general_purpose::STANDARD as base64, Engine as _};
 use clap::{command, Parser};
 use soroban_env_host::xdr;
 use soroban_spec_tools::contract;
-use std::{fmt::Debug, path::PathBuf};
+use std::{
+    ffi::OsStr,
+    fmt::Debug,
+    fs, io,
+    num::NonZeroUsize,
+    path::{Path, PathBuf},
+    sync::atomic::{AtomicUsize, Ordering},
+    thread,
+};
 use tracing::debug;
 
 use super::SpecOutput;
@@ -30,21 +39,89 @@ pub enum Error {
     Xdr(#[from] xdr::Error),
     #[error(transparent)]
     Spec(#[from] contract::Error),
+    #[error("reading directory {0:?}: {1}")]
+    ReadingDir(PathBuf, io::Error),
+    #[error("{failed} of {total} wasm files could not be inspected")]
+    InspectFailed { failed: usize, total: usize },
 }
 
 impl Cmd {
     pub fn run(&self) -> Result<(), Error> {
-        let wasm = self.wasm.parse()?;
+        if self.wasm.wasm.is_dir() {
+            return self.run_dir(&self.wasm.wasm);
+        }
         debug!("File: {}", self.wasm.wasm.to_string_lossy());
-        let output = match self.output {
-            SpecOutput::XdrBase64 => wasm
-                .spec_base64
-                .clone()
-                .ok_or_else(|| Error::MissingSpec(self.wasm.wasm.clone()))?,
-            SpecOutput::XdrBase64Array => wasm.spec_as_json_array()?,
-            SpecOutput::Docs => wasm.to_string(),
-        };
-        println!("{output}");
+        println!("{}", self.inspect(&self.wasm)?);
+        Ok(())
+    }
+
+    fn inspect(&self, wasm: &wasm::Args) -> Result<String, Error> {
+        let contents = wasm.load()?;
+        Ok(match self.output {
+            // The spec section is output as is, so it does not need to be decoded.
+            SpecOutput::XdrBase64 => base64.encode(
+                contract::Sections::new(&contents)?
+                    .spec
+                    .ok_or_else(|| Error::MissingSpec(wasm.wasm.clone()))?,
+            ),
+            SpecOutput::XdrBase64Array => {
+                contract::Sections::new(&contents)?.spec_as_json_array()?
+            }
+            SpecOutput::Docs => contents.parse()?.to_string(),
+        })
+    }
+
+    /// Inspects every wasm file in `dir` using all cores, printing them in file name order.
+    fn run_dir(&self, dir: &Path) -> Result<(), Error> {
+        let mut files = fs::read_dir(dir)
+            .and_then(|entries| {
+                entries
+                    .map(|entry| entry.map(|entry| entry.path()))
+                    .collect::<Result<Vec<_>, _>>()
+            })
+            .map_err(|e| Error::ReadingDir(dir.to_path_buf(), e))?;
+        files.retain(|file| file.extension() == Some(OsStr::new("wasm")) && file.is_file());
+        files.sort();
+
+        let next = AtomicUsize::new(0);
+        let workers = thread::available_parallelism()
+            .map_or(1, NonZeroUsize::get)
+            .min(files.len());
+        let files = &files;
+        let next = &next;
+        let mut results = thread::scope(|s| {
+            let workers = (0..workers)
+                .map(|_| {
+                    s.spawn(move || {
+                        let mut done = Vec::new();
+                        while let Some(file) = files.get(next.fetch_add(1, Ordering::Relaxed)) {
+                            done.push((file, self.inspect(&wasm::Args::from(file))));
+                        }
+                        done
+                    })
+                })
+                .collect::<Vec<_>>();
+            workers
+                .into_iter()
+                .flat_map(|worker| worker.join().expect("inspect worker panicked"))
+                .collect::<Vec<_>>()
+        });
+        results.sort_by(|(a, _), (b, _)| a.cmp(b));
+
+        let total = results.len();
+        let mut failed = 0;
+        for (file, res) in results {
+            match res {
+                Ok(output) => println!("File: {}\n{output}", file.display()),
+                Err(e) => {
+                    failed += 1;
+                    eprintln!("error: {}: {e}", file.display());
+                }
+            }
+        }
+        if failed > 0 {
+            return Err(Error::InspectFailed { failed, total });
+        }
         Ok(())
     }
 }
@@ -15,7 +15,8 @@ use crate::commands::network;
 use crate::commands::txn_result::{TxnEnvelopeResult, TxnResult};
 use crate::commands::{config::data, global, NetworkRunnable};
 use crate::key;
-use crate::rpc::{self, Client};
+use crate::metrics;
+use crate::rpc;
 use crate::{commands::config, utils, wasm};
 
 const CONTRACT_META_SDK_KEY: &str = "rssdkver";
@@ -92,38 +93,32 @@ impl NetworkRunnable for Cmd {
         config: Option<&config::Args>,
     ) -> Result<TxnResult<Hash>, Error> {
         let config = config.unwrap_or(&self.config);
-        let contract = self.wasm.read()?;
+        // The file is loaded once, for parsing, hashing and building the upload.
+        let contract = self.wasm.load()?;
         let network = config.get_network()?;
-        let client = Client::new(&network.rpc_url)?;
-        client
-            .verify_network_passphrase(Some(&network.network_passphrase))
-            .await?;
-        let wasm_spec = &self.wasm.parse().map_err(|e| Error::CannotParseWasm {
+        let client = network.rpc_client()?;
+        metrics::phase(
+            "verify_network_passphrase",
+            client.verify_network_passphrase(Some(&network.network_passphrase)),
+        )
+        .await?;
+        let wasm_spec = &contract.parse().map_err(|e| Error::CannotParseWasm {
             wasm: self.wasm.wasm.clone(),
             error: e,
         })?;
-        // Check Rust SDK version if using the public network.
-        if let Some(rs_sdk_ver) = get_contract_meta_sdk_version(wasm_spec) {
-            if rs_sdk_ver.contains("rc")
-                && !self.ignore_checks
-                && network.network_passphrase == PUBLIC_NETWORK_PASSPHRASE
-            {
-                return Err(Error::ContractCompiledWithReleaseCandidateSdk {
-                    wasm: self.wasm.wasm.clone(),
-                    version: rs_sdk_ver,
-                });
-            } else if rs_sdk_ver.contains("rc")
-                && network.network_passphrase == PUBLIC_NETWORK_PASSPHRASE
-            {
-                tracing::warn!("the deployed smart contract {path} was built with Soroban Rust SDK v{rs_sdk_ver}, a release candidate version not intended for use with the Stellar Public Network", path = self.wasm.wasm.display());
-            }
-        }
+        check_sdk_version(
+            &self.wasm.wasm,
+            wasm_spec,
+            &network.network_passphrase,
+            self.ignore_checks,
+        )?;
         let key = config.key_pair()?;
 
         // Get the account sequence number
         let public_strkey =
             stellar_strkey::ed25519::PublicKey(key.verifying_key().to_bytes()).to_string();
-        let account_details = client.get_account(&public_strkey).await?;
+        let account_details =
+            metrics::phase("get_account", client.get_account(&public_strkey)).await?;
         let sequence: i64 = account_details.seq_num.into();
 
         let (tx_without_preflight, hash) =
@@ -138,41 +133,31 @@ impl NetworkRunnable for Cmd {
         if !self.fee.sim_only {
             let code_key =
                 xdr::LedgerKey::ContractCode(xdr::LedgerKeyContractCode { hash: hash.clone() });
-            let contract_data = client.get_ledger_entries(&[code_key]).await?;
-            // Skip install if the contract is already installed, and the contract has an extension version that isn't V0.
-            // In protocol 21 extension V1 was added that stores additional information about a contract making execution
-            // of the contract cheaper. So if folks want to reinstall we should let them which is why the install will still
-            // go ahead if the contract has a V0 extension.
+            let contract_data =
+                metrics::phase("get_ledger_entries", client.get_ledger_entries(&[code_key]))
+                    .await?;
+            // Skip install if the contract is already installed.
             if let Some(entries) = contract_data.entries {
                 if let Some(entry_result) = entries.first() {
-                    let entry: LedgerEntryData =
-                        LedgerEntryData::from_xdr_base64(&entry_result.xdr, Limits::none())?;
-
-                    match &entry {
-                        LedgerEntryData::ContractCode(code) => {
-                            // Skip reupload if this isn't V0 because V1 extension already
-                            // exists.
-                            if code.ext.ne(&ContractCodeEntryExt::V0) {
-                                return Ok(TxnResult::Res(hash));
-                            }
-                        }
-                        _ => {
-                            tracing::warn!("Entry retrieved should be of type ContractCode");
-                        }
+                    if is_installed(&entry_result.xdr)? {
+                        return Ok(TxnResult::Res(hash));
                     }
                 }
             }
         }
-        let txn = client
-            .simulate_and_assemble_transaction(&tx_without_preflight)
-            .await?;
+        let txn = metrics::phase(
+            "simulate",
+            client.simulate_and_assemble_transaction(&tx_without_preflight),
+        )
+        .await?;
         let txn = self.fee.apply_to_assembled_txn(txn).transaction().clone();
+        metrics::record_simulation(&txn);
         if self.fee.sim_only {
             return Ok(TxnResult::Txn(txn));
         }
-        let txn_resp = client
-            .send_transaction_polling(&self.config.sign_with_local_key(txn).await?)
-            .await?;
+        let signed = metrics::phase("sign", self.config.sign_with_local_key(txn.clone())).await?;
+        let txn_resp = metrics::phase("send", client.send_transaction_polling(&signed)).await?;
+        metrics::record_result(&txn, &txn_resp);
         if args.map_or(true, |a| !a.no_cache) {
             data::write(txn_resp.clone().try_into().unwrap(), &network.rpc_uri()?)?;
         }
@@ -188,8 +173,8 @@ impl NetworkRunnable for Cmd {
                     contract_id: None,
                     key: None,
                     key_xdr: None,
-                    wasm: Some(self.wasm.wasm.clone()),
-                    wasm_hash: None,
+                    wasm: None,
+                    wasm_hash: Some(hex::encode(hash.0)),
                     durability: super::Durability::Persistent,
                 },
                 config: config.clone(),
@@ -207,6 +192,45 @@ impl NetworkRunnable for Cmd {
     }
 }
 
+/// Fails when a contract built with a release candidate of the Rust SDK is about to be installed
+/// on the public network, unless checks are ignored.
+pub(crate) fn check_sdk_version(
+    wasm: &std::path::Path,
+    wasm_spec: &soroban_spec_tools::contract::Spec,
+    network_passphrase: &str,
+    ignore_checks: bool,
+) -> Result<(), Error> {
+    if let Some(rs_sdk_ver) = get_contract_meta_sdk_version(wasm_spec) {
+        if rs_sdk_ver.contains("rc")
+            && !ignore_checks
+            && network_passphrase == PUBLIC_NETWORK_PASSPHRASE
+        {
+            return Err(Error::ContractCompiledWithReleaseCandidateSdk {
+                wasm: wasm.to_path_buf(),
+                version: rs_sdk_ver,
+            });
+        } else if rs_sdk_ver.contains("rc") && network_passphrase == PUBLIC_NETWORK_PASSPHRASE {
+            tracing::warn!("the deployed smart contract {path} was built with Soroban Rust SDK v{rs_sdk_ver}, a release candidate version not intended for use with the Stellar Public Network", path = wasm.display());
+        }
+    }
+    Ok(())
+}
+
+/// Whether a contract code ledger entry, as returned by `getLedgerEntries`, can be used as is.
+///
+/// In protocol 21 extension V1 was added that stores additional information about a contract
+/// making execution of the contract cheaper. So if folks want to reinstall we should let them
+/// which is why code with a V0 extension is not considered installed.
+pub(crate) fn is_installed(entry_xdr: &str) -> Result<bool, Error> {
+    match LedgerEntryData::from_xdr_base64(entry_xdr, Limits::none())? {
+        LedgerEntryData::ContractCode(code) => Ok(code.ext.ne(&ContractCodeEntryExt::V0)),
+        _ => {
+            tracing::warn!("Entry retrieved should be of type ContractCode");
+            Ok(false)
+        }
+    }
+}
+
 fn get_contract_meta_sdk_version(wasm_spec: &soroban_spec_tools::contract::Spec) -> Option<String> {
     let rs_sdk_version_option = if let Some(_meta) = &wasm_spec.meta_base64 {
         wasm_spec.meta.iter().find(|entry| match entry {
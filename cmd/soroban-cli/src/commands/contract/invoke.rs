@@ -12,8 +12,9 @@ use heck::ToKebabCase;
 
 use soroban_env_host::{
     xdr::{
-        self, AccountEntry, AccountEntryExt, AccountId, Hash, HostFunction, InvokeContractArgs,
-        InvokeHostFunctionOp, LedgerEntryData, Limits, Memo, MuxedAccount, Operation,
+        self, AccountEntry, AccountEntryExt, AccountId, ConfigSettingEntry, ConfigSettingId,
+        DiagnosticEvent, Hash, HostFunction, InvokeContractArgs, InvokeHostFunctionOp,
+        LedgerEntryData, LedgerKey, LedgerKeyConfigSetting, Limits, Memo, MuxedAccount, Operation,
         OperationBody, Preconditions, PublicKey, ScAddress, ScSpecEntry, ScSpecFunctionV0,
         ScSpecTypeDef, ScVal, ScVec, SequenceNumber, String32, StringM, Thresholds, Transaction,
         TransactionExt, Uint256, VecM, WriteXdr,
@@ -31,11 +32,20 @@ use crate::commands::txn_result::{TxnEnvelopeResult, TxnResult};
 use crate::commands::NetworkRunnable;
 use crate::get_spec::{self, get_remote_contract_spec};
 use crate::{
-    commands::{config::data, global, network},
-    rpc, Pwd,
+    commands::{
+        config::data::{
+            self,
+            resource_history::{self, ComputeSettings, History},
+        },
+        global, network,
+    },
+    fee, metrics, rpc, Pwd,
 };
 use soroban_spec_tools::{contract, Spec};
 
+mod batch;
+mod snapshot;
+
 #[derive(Parser, Debug, Default, Clone)]
 #[allow(clippy::struct_excessive_bools)]
 #[group(skip)]
@@ -52,6 +62,19 @@ pub struct Cmd {
     /// Function name as subcommand, then arguments for that function as `--arg-name value`
     #[arg(last = true, id = "CONTRACT_FN_AND_ARGS")]
     pub slop: Vec<OsString>,
+    /// Read invocations from a file (or stdin if `-`), one per line, each written as the function
+    /// name and arguments that would otherwise follow `--`. All invocations share a single RPC
+    /// connection and contract spec, and are submitted with locally tracked sequence numbers
+    #[arg(long, conflicts_with = "CONTRACT_FN_AND_ARGS")]
+    pub batch: Option<PathBuf>,
+    /// Maximum number of batched invocations being simulated or awaiting confirmation at once
+    #[arg(long, default_value = "4", requires = "batch")]
+    pub max_in_flight: usize,
+    /// Run view calls locally against a snapshot of the ledger entries they read, stored in this
+    /// file. The snapshot is created, or extended with missing entries, by simulating the call on
+    /// the network once. Delete the file to refresh it
+    #[arg(long, requires = "is_view", conflicts_with = "batch")]
+    pub snapshot: Option<PathBuf>,
     #[command(flatten)]
     pub config: config::Args,
     #[command(flatten)]
@@ -146,6 +169,34 @@ pub enum Error {
     Network(#[from] network::Error),
     #[error(transparent)]
     GetSpecError(#[from] get_spec::Error),
+    #[error(transparent)]
+    Pipeline(#[from] super::pipeline::Error),
+    #[error(transparent)]
+    Signer(#[from] crate::signer::Error),
+    #[error("batch line {line}: cannot parse invocation {input:?}")]
+    InvalidBatchLine { line: usize, input: String },
+    #[error("batch line {line}: missing function name")]
+    MissingBatchFunction { line: usize },
+    #[error("{failed} of {total} batched invocations failed")]
+    BatchFailed { failed: usize, total: usize },
+    #[error("reading snapshot {0:?}: {1}")]
+    CannotReadSnapshot(PathBuf, io::Error),
+    #[error("writing snapshot {0:?}: {1}")]
+    CannotWriteSnapshot(PathBuf, io::Error),
+    #[error("invalid snapshot {0:?}: {1}")]
+    InvalidSnapshot(PathBuf, serde_json::Error),
+    #[error("invalid network id in snapshot {0:?}")]
+    InvalidSnapshotNetwork(PathBuf),
+    #[error("cannot get the latest ledger to sign auth entries: {0}")]
+    SignatureExpiration(String),
+    #[error("cannot find the compute settings of the network")]
+    MissingComputeSettings,
+    #[error("simulation did not return a footprint")]
+    MissingFootprint,
+    #[error("cannot find the state archival settings of the network")]
+    MissingStateArchivalSettings,
+    #[error("cannot fetch the snapshot entries at a single ledger, requests answered at {0:?}")]
+    SnapshotLedgerMismatch(Vec<u32>),
 }
 
 impl From<Infallible> for Error {
@@ -163,29 +214,119 @@ impl Cmd {
             std::env::var("SYSTEM_TEST_VERBOSE_OUTPUT").as_deref() == Ok("true")
     }
 
-    fn build_host_function_parameters(
+    /// Parses the function call in `slop` against `spec_entries`, returning the name of the
+    /// function, the spec, the arguments to invoke it with and the keys of any identities passed
+    /// as addresses.
+    pub fn build_host_function_parameters(
         &self,
         contract_id: [u8; 32],
         spec_entries: &[ScSpecEntry],
         config: &config::Args,
     ) -> Result<(String, Spec, InvokeContractArgs, Vec<SigningKey>), Error> {
-        let spec = Spec(Some(spec_entries.to_vec()));
+        let spec = Spec::new(spec_entries.to_vec());
+        let requested = requested_function(&spec, self.slop.first())?;
+        let help = self.slop.iter().any(|arg| arg == "--help" || arg == "-h");
+        let mut cmd = self.build_contract_cmd(&spec, requested.as_deref(), help)?;
+        let mut matches_ = cmd
+            .try_get_matches_from_mut(&self.slop)
+            .unwrap_or_else(|e| e.exit());
+        let Some((function, matches_)) = &matches_.remove_subcommand() else {
+            println!("{}", cmd.render_long_help());
+            std::process::exit(1);
+        };
+        let (invoke_args, signers) =
+            self.invoke_args_from_matches(contract_id, &spec, function, matches_, config)?;
+        Ok((function.clone(), spec, invoke_args, signers))
+    }
+
+    /// Whether the first argument looks like a function name but is missing from the spec.
+    fn names_unknown_function(&self, spec_entries: &[ScSpecEntry]) -> bool {
+        let Some(arg) = self.slop.first().map(|arg| arg.to_string_lossy()) else {
+            return false;
+        };
+        !arg.starts_with('-')
+            && !spec_entries.iter().any(|entry| match entry {
+                ScSpecEntry::FunctionV0(ScSpecFunctionV0 { name, .. }) => {
+                    let name = name.to_utf8_string_lossy();
+                    name == arg || name.to_kebab_case() == arg
+                }
+                _ => false,
+            })
+    }
+
+    /// Fetches the spec of the contract. When a function is named, a cached spec only includes
+    /// that function and the types it uses.
+    async fn fetch_spec(
+        &self,
+        contract_id: &[u8; 32],
+        config: &config::Args,
+        global_args: Option<&global::Args>,
+    ) -> Result<Vec<ScSpecEntry>, Error> {
+        let function = self
+            .slop
+            .first()
+            .map(|arg| arg.to_string_lossy())
+            .filter(|arg| !arg.starts_with('-'));
+        Ok(match function {
+            Some(function) => {
+                get_spec::get_remote_function_spec(
+                    contract_id,
+                    &function,
+                    &config.locator,
+                    &config.network,
+                    global_args,
+                    Some(config),
+                )
+                .await?
+            }
+            None => {
+                get_remote_contract_spec(
+                    contract_id,
+                    &config.locator,
+                    &config.network,
+                    global_args,
+                    Some(config),
+                )
+                .await?
+            }
+        })
+    }
+
+    /// Builds the command used to parse a function call against the contract spec. When
+    /// `function` is set only that function's subcommand is built, which is all that is needed
+    /// to parse its arguments; otherwise every function is included so that help output and
+    /// suggestions cover the whole contract. The long help of functions and their arguments is
+    /// only rendered when `help` is set, as it is only shown for `--help` and `-h`.
+    fn build_contract_cmd(
+        &self,
+        spec: &Spec,
+        function: Option<&str>,
+        help: bool,
+    ) -> Result<clap::Command, Error> {
         let mut cmd = clap::Command::new(self.contract_id.clone())
             .no_binary_name(true)
             .term_width(300)
             .max_term_width(300);
 
-        for ScSpecFunctionV0 { name, .. } in spec.find_functions()? {
-            cmd = cmd.subcommand(build_custom_cmd(&name.to_utf8_string_lossy(), &spec)?);
+        if let Some(function) = function {
+            cmd = cmd.subcommand(build_custom_cmd(function, spec, help)?);
+        } else {
+            for ScSpecFunctionV0 { name, .. } in spec.find_functions()? {
+                cmd = cmd.subcommand(build_custom_cmd(&name.to_utf8_string_lossy(), spec, help)?);
+            }
         }
         cmd.build();
-        let long_help = cmd.render_long_help();
-        let mut matches_ = cmd.get_matches_from(&self.slop);
-        let Some((function, matches_)) = &matches_.remove_subcommand() else {
-            println!("{long_help}");
-            std::process::exit(1);
-        };
+        Ok(cmd)
+    }
 
+    fn invoke_args_from_matches(
+        &self,
+        contract_id: [u8; 32],
+        spec: &Spec,
+        function: &str,
+        matches_: &clap::ArgMatches,
+        config: &config::Args,
+    ) -> Result<(InvokeContractArgs, Vec<SigningKey>), Error> {
         let func = spec.find_function(function)?;
         // create parsed_args in same order as the inputs to func
         let mut signers: Vec<SigningKey> = vec![];
@@ -226,15 +367,7 @@ impl Cmd {
                             error: soroban_spec_tools::Error::Unknown,
                         })?)
                     } else {
-                        let file_contents = std::fs::read_to_string(arg_path)
-                            .map_err(|_| Error::MissingFileArg(arg_path.clone()))?;
-                        tracing::debug!(
-                            "file {arg_path:?}, has contents:\n{file_contents}\nAnd type {:#?}\n{}",
-                            i.type_,
-                            file_contents.len()
-                        );
-                        spec.from_string(&file_contents, &i.type_)
-                            .map_err(|error| Error::CannotParseArg { arg: name, error })
+                        read_arg_file(spec, name, arg_path, &i.type_)
                     }
                 } else {
                     Err(Error::MissingArgument(name))
@@ -245,7 +378,7 @@ impl Cmd {
         let contract_address_arg = ScAddress::Contract(Hash(contract_id));
         let function_symbol_arg = function
             .try_into()
-            .map_err(|()| Error::FunctionNameTooLong(function.clone()))?;
+            .map_err(|()| Error::FunctionNameTooLong(function.to_string()))?;
 
         let final_args =
             parsed_args
@@ -262,10 +395,13 @@ impl Cmd {
             args: final_args,
         };
 
-        Ok((function.clone(), spec, invoke_args, signers))
+        Ok((invoke_args, signers))
     }
 
     pub async fn run(&self, global_args: &global::Args) -> Result<(), Error> {
+        if let Some(batch) = &self.batch {
+            return self.run_batch(global_args, batch).await;
+        }
         let res = self.invoke(global_args).await?.to_envelope();
         match res {
             TxnEnvelopeResult::TxnEnvelope(tx) => println!("{}", tx.to_xdr_base64(Limits::none())?),
@@ -320,32 +456,44 @@ impl NetworkRunnable for Cmd {
             // For testing wasm arg parsing
             let _ = self.build_host_function_parameters(contract_id, spec_entries, config)?;
         }
-        let client = rpc::Client::new(&network.rpc_url)?;
+        if let Some(snapshot) = self.snapshot.as_deref().filter(|_| self.is_view()) {
+            return self
+                .invoke_with_snapshot(snapshot, contract_id, global_args, config)
+                .await;
+        }
+        let client = network.rpc_client()?;
         let account_details = if self.is_view {
             default_account_entry()
         } else {
-            client
-                .verify_network_passphrase(Some(&network.network_passphrase))
-                .await?;
+            metrics::phase(
+                "verify_network_passphrase",
+                client.verify_network_passphrase(Some(&network.network_passphrase)),
+            )
+            .await?;
             let key = config.key_pair()?;
 
             // Get the account sequence number
             let public_strkey =
                 stellar_strkey::ed25519::PublicKey(key.verifying_key().to_bytes()).to_string();
-            client.get_account(&public_strkey).await?
+            metrics::phase("get_account", client.get_account(&public_strkey)).await?
         };
         let sequence: i64 = account_details.seq_num.into();
         let AccountId(PublicKey::PublicKeyTypeEd25519(account_id)) = account_details.account_id;
 
-        let spec_entries = get_remote_contract_spec(
-            &contract_id,
-            &config.locator,
-            &config.network,
-            global_args,
-            Some(config),
+        let mut spec_entries = metrics::phase(
+            "fetch_spec",
+            self.fetch_spec(&contract_id, config, global_args),
         )
-        .await
-        .map_err(Error::from)?;
+        .await?;
+        if self.names_unknown_function(&spec_entries) {
+            // The wasm hash may be stale if the contract was upgraded since it was cached.
+            get_spec::invalidate_contract_instance(&contract_id, &network.network_passphrase)?;
+            spec_entries = metrics::phase(
+                "fetch_spec",
+                self.fetch_spec(&contract_id, config, global_args),
+            )
+            .await?;
+        }
 
         // Get the ledger footprint
         let (function, spec, host_function_params, signers) =
@@ -359,36 +507,80 @@ impl NetworkRunnable for Cmd {
         if self.fee.build_only {
             return Ok(TxnResult::Txn(tx));
         }
-        let txn = client.simulate_and_assemble_transaction(&tx).await?;
-        let txn = self.fee.apply_to_assembled_txn(txn);
-        if self.fee.sim_only {
-            return Ok(TxnResult::Txn(txn.transaction().clone()));
-        }
-        let sim_res = txn.sim_response();
-        if global_args.map_or(true, |a| !a.no_cache) {
-            data::write(sim_res.clone().into(), &network.rpc_uri()?)?;
-        }
-        let (return_value, events) = if self.is_view() {
-            // log_auth_cost_and_footprint(Some(&sim_res.transaction_data()?.resources));
-            (sim_res.results()?[0].xdr.clone(), sim_res.events()?)
+        let cache = global_args.map_or(true, |a| !a.no_cache);
+        let submitting = !self.is_view() && !self.fee.sim_only;
+        let mut history = if cache && submitting {
+            Some(History::open(
+                &network.network_passphrase,
+                &contract_id,
+                &function,
+            )?)
         } else {
-            let global::Args { no_cache, .. } = global_args.cloned().unwrap_or_default();
-            // Need to sign all auth entries
-            let mut txn = txn.transaction().clone();
-            // let auth = auth_entries(&txn);
-            // crate::log::auth(&[auth]);
-
-            if let Some(tx) = config.sign_soroban_authorizations(&txn, &signers).await? {
-                txn = tx;
+            None
+        };
+        let reused = match &history {
+            Some(history) if self.fee.instructions.is_none() => history.reusable(&tx)?,
+            _ => None,
+        };
+        let (return_value, events) = if let Some(txn) = reused {
+            tracing::debug!("submitting the transaction simulated for an identical call");
+            if let Some(history) = history.as_mut() {
+                history.record_reuse(&txn);
             }
-            // log_auth_cost_and_footprint(resources(&txn));
-            let res = client
-                .send_transaction_polling(&config.sign_with_local_key(txn).await?)
-                .await?;
-            if !no_cache {
-                data::write(res.clone().try_into()?, &network.rpc_uri()?)?;
+            self.submit(
+                &client,
+                &network,
+                txn,
+                &tx,
+                &signers,
+                config,
+                cache,
+                history.as_mut(),
+            )
+            .await?
+        } else {
+            let simulated =
+                metrics::phase("simulate", client.simulate_and_assemble_transaction(&tx)).await;
+            let txn = match simulated {
+                Ok(txn) => txn,
+                Err(e) => {
+                    get_spec::invalidate_contract_instance(
+                        &contract_id,
+                        &network.network_passphrase,
+                    )?;
+                    return Err(e.into());
+                }
+            };
+            let txn = self.fee.apply_to_assembled_txn(txn);
+            metrics::record_simulation(txn.transaction());
+            if self.fee.sim_only {
+                return Ok(TxnResult::Txn(txn.transaction().clone()));
+            }
+            let sim_res = txn.sim_response();
+            if cache {
+                data::write(sim_res.clone().into(), &network.rpc_uri()?)?;
+            }
+            if self.is_view() {
+                // log_auth_cost_and_footprint(Some(&sim_res.transaction_data()?.resources));
+                (sim_res.results()?[0].xdr.clone(), sim_res.events()?)
+            } else {
+                let mut txn = txn.transaction().clone();
+                if self.fee.instructions.is_none() {
+                    self.pad_instructions(&client, &network, &mut txn, history.as_mut(), cache)
+                        .await?;
+                }
+                self.submit(
+                    &client,
+                    &network,
+                    txn,
+                    &tx,
+                    &signers,
+                    config,
+                    cache,
+                    history.as_mut(),
+                )
+                .await?
             }
-            (res.return_value()?, res.contract_events()?)
         };
 
         crate::log::diagnostic_events(&events, tracing::Level::INFO);
@@ -396,6 +588,118 @@ impl NetworkRunnable for Cmd {
     }
 }
 
+impl Cmd {
+    /// Pads the simulated instructions of `txn`, adaptively if the function has a history.
+    async fn pad_instructions(
+        &self,
+        client: &rpc::Client,
+        network: &network::Network,
+        txn: &mut Transaction,
+        history: Option<&mut History>,
+        cache: bool,
+    ) -> Result<(), Error> {
+        let TransactionExt::V1(data) = &txn.ext else {
+            return Ok(());
+        };
+        let simulated = data.resources.instructions;
+        let settings = compute_settings(client, &network.network_passphrase, cache).await?;
+        let padded = history
+            .as_deref()
+            .map_or_else(
+                || resource_history::default_padded_instructions(simulated),
+                |history| history.padded_instructions(simulated),
+            )
+            .min(u32::try_from(settings.tx_max_instructions).unwrap_or(u32::MAX))
+            .max(simulated);
+        fee::pad_instructions(txn, padded, settings.fee_rate_per_instructions_increment);
+        if let Some(history) = history {
+            history.record_simulation(simulated, txn);
+        }
+        Ok(())
+    }
+
+    /// Signs the auth entries of `txn`, then signs and sends it, recording the outcome in the
+    /// function's history. `built` is the transaction as built before simulation.
+    #[allow(clippy::too_many_arguments)]
+    async fn submit(
+        &self,
+        client: &rpc::Client,
+        network: &network::Network,
+        txn: Transaction,
+        built: &Transaction,
+        signers: &[SigningKey],
+        config: &config::Args,
+        cache: bool,
+        history: Option<&mut History>,
+    ) -> Result<(ScVal, Vec<DiagnosticEvent>), Error> {
+        let signed = metrics::phase("sign", async {
+            // Need to sign all auth entries
+            let mut signed = txn.clone();
+            // let auth = auth_entries(&txn);
+            // crate::log::auth(&[auth]);
+
+            if let Some(tx) = config.sign_soroban_authorizations(&signed, signers).await? {
+                signed = tx;
+            }
+            config.sign_with_local_key(signed).await
+        })
+        .await?;
+        // log_auth_cost_and_footprint(resources(&txn));
+        let res = metrics::phase("send", client.send_transaction_polling(&signed)).await;
+        if let Ok(res) = &res {
+            metrics::record_result(&txn, res);
+        }
+        if let Some(history) = history {
+            let fee_charged = res
+                .as_ref()
+                .ok()
+                .and_then(|res| res.result.as_ref())
+                .map(|result| result.fee_charged);
+            history.record_result(built, &txn, fee_charged, res.is_ok())?;
+            history.save()?;
+        }
+        let res = res?;
+        if cache {
+            data::write(res.clone().try_into()?, &network.rpc_uri()?)?;
+        }
+        Ok((res.return_value()?, res.contract_events()?))
+    }
+}
+
+/// The instruction settings of the network, cached for a while as they rarely change.
+async fn compute_settings(
+    client: &rpc::Client,
+    network_passphrase: &str,
+    cache: bool,
+) -> Result<ComputeSettings, Error> {
+    if cache {
+        if let Some(settings) = resource_history::read_compute_settings(network_passphrase)? {
+            return Ok(settings);
+        }
+    }
+    let key = LedgerKey::ConfigSetting(LedgerKeyConfigSetting {
+        config_setting_id: ConfigSettingId::ContractComputeV0,
+    });
+    let res = metrics::phase(
+        "get_compute_settings",
+        client.get_full_ledger_entries(&[key]),
+    )
+    .await?;
+    let Some(LedgerEntryData::ConfigSetting(ConfigSettingEntry::ContractComputeV0(compute))) =
+        res.entries.into_iter().next().map(|entry| entry.val)
+    else {
+        return Err(Error::MissingComputeSettings);
+    };
+    let settings = ComputeSettings::new(
+        compute.tx_max_instructions,
+        compute.fee_rate_per_instructions_increment,
+    );
+    if cache {
+        resource_history::write_compute_settings(network_passphrase, &settings)?;
+    }
+    Ok(settings)
+}
+
 const DEFAULT_ACCOUNT_ID: AccountId = AccountId(PublicKey::PublicKeyTypeEd25519(Uint256([0; 32])));
 
 // fn log_auth_cost_and_footprint(resources: Option<&SorobanResources>) {
@@ -448,17 +752,38 @@ pub fn output_to_string(
 ) -> Result<TxnResult<String>, Error> {
     let mut res_str = String::new();
     if let Some(output) = spec.find_function(function)?.outputs.first() {
-        res_str = spec
-            .xdr_to_json(res, output)
-            .map_err(|e| Error::CannotPrintResult {
+        res_str = serde_json::to_string(&spec.json(res, output)).map_err(|e| {
+            Error::CannotPrintResult {
                 result: res.clone(),
-                error: e,
-            })?
-            .to_string();
+                error: e.into(),
+            }
+        })?;
     }
     Ok(TxnResult::Res(res_str))
 }
 
+/// Reads the value of an argument from the JSON file `path`, one element at a time. Files
+/// that are not JSON the streaming decoder accepts, such as bare strings, are parsed as the
+/// value of the argument would be on the command line.
+fn read_arg_file(
+    spec: &Spec,
+    arg: String,
+    path: &Path,
+    type_: &ScSpecTypeDef,
+) -> Result<ScVal, Error> {
+    let file = fs::File::open(path).map_err(|_| Error::MissingFileArg(path.to_path_buf()))?;
+    match spec.from_json_reader(io::BufReader::new(file), type_) {
+        Ok(val) => Ok(val),
+        Err(e) => {
+            tracing::debug!("parsing {path:?} as a whole, it could not be streamed: {e}");
+            let contents =
+                fs::read_to_string(path).map_err(|_| Error::MissingFileArg(path.to_path_buf()))?;
+            spec.from_string(&contents, type_)
+                .map_err(|error| Error::CannotParseArg { arg, error })
+        }
+    }
+}
+
 fn build_invoke_contract_tx(
     parameters: InvokeContractArgs,
     sequence: i64,
@@ -483,7 +808,19 @@ fn build_invoke_contract_tx(
     })
 }
 
-fn build_custom_cmd(name: &str, spec: &Spec) -> Result<clap::Command, Error> {
+/// Returns the name of the contract function `arg` refers to, either by its name or by its
+/// kebab case alias, or `None` if `arg` is not a function of the contract (e.g. `--help`).
+fn requested_function(spec: &Spec, arg: Option<&OsString>) -> Result<Option<String>, Error> {
+    let Some(arg) = arg.and_then(|arg| arg.to_str()) else {
+        return Ok(None);
+    };
+    Ok(spec
+        .find_functions()?
+        .map(|ScSpecFunctionV0 { name, .. }| name.to_utf8_string_lossy())
+        .find(|name| name == arg || name.to_kebab_case() == arg))
+}
+
+fn build_custom_cmd(name: &str, spec: &Spec, help: bool) -> Result<clap::Command, Error> {
     let func = spec
         .find_function(name)
         .map_err(|_| Error::FunctionNotFoundInContractSpec(name.to_string()))?;
@@ -494,8 +831,7 @@ fn build_custom_cmd(name: &str, spec: &Spec) -> Result<clap::Command, Error> {
         .iter()
         .map(|i| (i.name.to_utf8_string().unwrap(), i.type_.clone()))
         .collect::<HashMap<String, ScSpecTypeDef>>();
-    let name: &'static str = Box::leak(name.to_string().into_boxed_str());
-    let mut cmd = clap::Command::new(name)
+    let mut cmd = clap::Command::new(name.to_string())
         .no_binary_name(true)
         .term_width(300)
         .max_term_width(300);
@@ -503,10 +839,11 @@ fn build_custom_cmd(name: &str, spec: &Spec) -> Result<clap::Command, Error> {
     if kebab_name != name {
         cmd = cmd.alias(kebab_name);
     }
-    let doc: &'static str = Box::leak(func.doc.to_utf8_string_lossy().into_boxed_str());
-    let long_doc: &'static str = Box::leak(arg_file_help(doc).into_boxed_str());
-
-    cmd = cmd.about(Some(doc)).long_about(long_doc);
+    let doc = func.doc.to_utf8_string_lossy();
+    if help {
+        cmd = cmd.long_about(arg_file_help(&doc));
+    }
+    cmd = cmd.about(doc);
     for (name, type_) in inputs_map {
         let mut arg = clap::Arg::new(name);
         let file_arg_name = fmt_arg_file_name(name);
@@ -515,8 +852,12 @@ fn build_custom_cmd(name: &str, spec: &Spec) -> Result<clap::Command, Error> {
             .long(name)
             .alias(name.to_kebab_case())
             .num_args(1)
-            .value_parser(clap::builder::NonEmptyStringValueParser::new())
-            .long_help(spec.doc(name, type_)?);
+            .value_parser(clap::builder::NonEmptyStringValueParser::new());
+        if help {
+            if let Some(doc) = spec.doc(name, type_)? {
+                arg = arg.long_help(doc);
+            }
+        }
 
         file_arg = file_arg
             .long(&file_arg_name)
@@ -527,7 +868,6 @@ fn build_custom_cmd(name: &str, spec: &Spec) -> Result<clap::Command, Error> {
             .conflicts_with(name);
 
         if let Some(value_name) = spec.arg_value_name(type_, 0) {
-            let value_name: &'static str = Box::leak(value_name.into_boxed_str());
             arg = arg.value_name(value_name);
         }
 
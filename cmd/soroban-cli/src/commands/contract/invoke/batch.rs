@@ -0,0 +1,389 @@
+use std::{
+    collections::{hash_map::Entry, HashMap},
+    ffi::OsString,
+    fs,
+    io::{self, Read},
+    path::Path,
+    sync::Mutex,
+    time::{Duration, Instant},
+};
+
+use ed25519_dalek::SigningKey;
+use futures_util::{stream, StreamExt};
+use soroban_env_host::xdr::{
+    AccountId, Hash, InvokeContractArgs, Limits, PublicKey, Transaction, WriteXdr,
+};
+use soroban_rpc::Assembled;
+use soroban_spec_tools::Spec;
+
+use super::{
+    build_invoke_contract_tx, output_to_string, requested_function, Cmd, Error, DEFAULT_ACCOUNT_ID,
+};
+use crate::{
+    commands::{
+        contract::pipeline::Pipeline,
+        global,
+        network::Network,
+        txn_result::{TxnEnvelopeResult, TxnResult},
+    },
+    get_spec::{self, get_remote_contract_spec},
+    signer,
+};
+
+/// How long a fetched latest ledger is trusted when computing the expiration ledger of auth
+/// entry signatures. Signatures are valid for 60 ledgers (~5 min), so refreshing every minute
+/// keeps every entry comfortably within its window.
+const LATEST_LEDGER_REFRESH: Duration = Duration::from_secs(60);
+
+/// A single line of a batch file, parsed against the contract spec.
+struct Invocation {
+    line: usize,
+    function: String,
+    args: InvokeContractArgs,
+    signers: Vec<SigningKey>,
+}
+
+/// A simulated invocation, with its auth entries signed if it has any.
+struct Signed {
+    assembled: Assembled,
+    auth_signed: Option<Transaction>,
+}
+
+impl From<Assembled> for Signed {
+    fn from(assembled: Assembled) -> Self {
+        Signed {
+            assembled,
+            auth_signed: None,
+        }
+    }
+}
+
+enum Submitted {
+    /// The result is known without waiting on the network, e.g. view calls and `--sim-only`.
+    Done(String),
+    Sent {
+        function: String,
+        hash: Hash,
+    },
+}
+
+/// State shared by every invocation in a batch: one parsed spec, and the pipeline that
+/// simulates and submits them from the source account.
+struct Batch<'a> {
+    cmd: &'a Cmd,
+    pipeline: Pipeline<'a>,
+    spec: Spec,
+    network: &'a Network,
+    latest_ledger: Mutex<Option<(Instant, u32)>>,
+}
+
+impl Cmd {
+    pub(super) async fn run_batch(
+        &self,
+        global_args: &global::Args,
+        path: &Path,
+    ) -> Result<(), Error> {
+        let config = &self.config;
+        let network = config.get_network()?;
+        tracing::trace!(?network);
+        let contract_id = config
+            .locator
+            .resolve_contract_id(&self.contract_id, &network.network_passphrase)?
+            .0;
+        let client = network.rpc_client()?;
+
+        let spec = Spec::new(
+            get_remote_contract_spec(
+                &contract_id,
+                &config.locator,
+                &config.network,
+                Some(global_args),
+                Some(config),
+            )
+            .await?,
+        );
+        // Parse every line before anything is submitted, so that a typo on the last line does
+        // not leave the batch half applied.
+        // Commands are built per function on first use and reused by later lines calling it.
+        let mut cmds = HashMap::<Option<String>, clap::Command>::new();
+        let invocations = read_batch(path)?
+            .into_iter()
+            .map(|(line, slop)| {
+                let requested = requested_function(&spec, slop.first())?;
+                let cmd = match cmds.entry(requested) {
+                    Entry::Occupied(e) => e.into_mut(),
+                    Entry::Vacant(e) => {
+                        let cmd = self.build_contract_cmd(&spec, e.key().as_deref(), false)?;
+                        e.insert(cmd)
+                    }
+                };
+                let mut matches_ = cmd.try_get_matches_from_mut(slop)?;
+                let Some((function, matches_)) = matches_.remove_subcommand() else {
+                    return Err(Error::MissingBatchFunction { line });
+                };
+                let (args, signers) = self.invoke_args_from_matches(
+                    contract_id,
+                    &spec,
+                    &function,
+                    &matches_,
+                    config,
+                )?;
+                Ok(Invocation {
+                    line,
+                    function,
+                    args,
+                    signers,
+                })
+            })
+            .collect::<Result<Vec<_>, Error>>()?;
+        let total = invocations.len();
+
+        let key;
+        let pipeline = if self.is_view() {
+            let AccountId(PublicKey::PublicKeyTypeEd25519(source_account)) = DEFAULT_ACCOUNT_ID;
+            Pipeline::read_only(
+                &client,
+                source_account,
+                &network,
+                &self.fee,
+                global_args.no_cache,
+            )?
+        } else {
+            client
+                .verify_network_passphrase(Some(&network.network_passphrase))
+                .await?;
+            key = config.key_pair()?;
+            Pipeline::new(&client, &key, &network, &self.fee, global_args.no_cache).await?
+        };
+
+        if self.fee.build_only {
+            for (i, Invocation { args, .. }) in invocations.into_iter().enumerate() {
+                let offset = i64::try_from(i).unwrap_or(i64::MAX);
+                let tx = build_invoke_contract_tx(
+                    args,
+                    pipeline.sequence() + offset,
+                    self.fee.fee,
+                    pipeline.source_account().clone(),
+                )?;
+                println!("{}", envelope_xdr(TxnResult::Txn(tx))?);
+            }
+            return Ok(());
+        }
+
+        let batch = Batch {
+            cmd: self,
+            pipeline,
+            spec,
+            network: &network,
+            latest_ledger: Mutex::new(None),
+        };
+        let max_in_flight = self.max_in_flight.max(1);
+
+        // Simulations and confirmations run concurrently, while submission happens one at a
+        // time in line order so sequence numbers are handed out without gaps. Auth entries do
+        // not cover the sequence number, so those of every simulation ready at once are signed
+        // together ahead of submission.
+        let results = stream::iter(invocations)
+            .map(|invocation| batch.simulate(invocation))
+            .buffered(max_in_flight)
+            .ready_chunks(max_in_flight)
+            .then(|simulated| batch.sign_auths(simulated))
+            .flat_map(stream::iter)
+            .then(|(invocation, signed)| batch.submit(invocation, signed))
+            .map(|(line, submitted)| batch.confirm(line, submitted))
+            .buffered(max_in_flight);
+        let mut results = std::pin::pin!(results);
+
+        let mut failed = 0;
+        while let Some((line, res)) = results.next().await {
+            match res {
+                Ok(output) => println!("{output}"),
+                Err(e) => {
+                    failed += 1;
+                    eprintln!("error: line {line}: {e}");
+                }
+            }
+        }
+        if failed > 0 {
+            // A failure may be caused by a contract upgraded since its wasm hash was cached.
+            get_spec::invalidate_contract_instance(&contract_id, &network.network_passphrase)?;
+            return Err(Error::BatchFailed { failed, total });
+        }
+        Ok(())
+    }
+}
+
+impl Batch<'_> {
+    async fn simulate(&self, invocation: Invocation) -> (Invocation, Result<Assembled, Error>) {
+        let res = async {
+            // The sequence number is replaced at submission time, simulation does not depend on
+            // it.
+            let tx = build_invoke_contract_tx(
+                invocation.args.clone(),
+                self.pipeline.sequence(),
+                self.cmd.fee.fee,
+                self.pipeline.source_account().clone(),
+            )?;
+            Ok(self.pipeline.assemble(tx).await?)
+        }
+        .await;
+        (invocation, res)
+    }
+
+    /// Signs the auth entries of every simulated invocation in `simulated` in one go.
+    async fn sign_auths(
+        &self,
+        simulated: Vec<(Invocation, Result<Assembled, Error>)>,
+    ) -> Vec<(Invocation, Result<Signed, Error>)> {
+        let Some(source_key) = self.pipeline.key().filter(|_| !self.cmd.fee.sim_only) else {
+            return simulated
+                .into_iter()
+                .map(|(invocation, assembled)| (invocation, assembled.map(Signed::from)))
+                .collect();
+        };
+        let signature_expiration_ledger = match self.signature_expiration_ledger().await {
+            Ok(ledger) => ledger,
+            Err(e) => {
+                let e = e.to_string();
+                return simulated
+                    .into_iter()
+                    .map(|(invocation, _)| (invocation, Err(Error::SignatureExpiration(e.clone()))))
+                    .collect();
+            }
+        };
+        let mut signed = {
+            let signers = simulated
+                .iter()
+                .map(|(invocation, _)| signer::Signers::new(source_key, &invocation.signers))
+                .collect::<Vec<_>>();
+            signer::sign_soroban_authorizations_batch(
+                simulated
+                    .iter()
+                    .zip(&signers)
+                    .filter_map(|((_, assembled), signers)| {
+                        Some((assembled.as_ref().ok()?.transaction(), signers))
+                    }),
+                signature_expiration_ledger,
+                &self.network.network_passphrase,
+            )
+        }
+        .into_iter();
+        simulated
+            .into_iter()
+            .map(|(invocation, assembled)| {
+                let res = assembled.and_then(|assembled| {
+                    let auth_signed = signed.next().unwrap_or(Ok(None))?;
+                    Ok(Signed {
+                        assembled,
+                        auth_signed,
+                    })
+                });
+                (invocation, res)
+            })
+            .collect()
+    }
+
+    async fn submit(
+        &self,
+        invocation: Invocation,
+        signed: Result<Signed, Error>,
+    ) -> (usize, Result<Submitted, Error>) {
+        let Invocation { line, function, .. } = invocation;
+        let res = async {
+            let Signed {
+                assembled,
+                auth_signed,
+            } = signed?;
+            if self.cmd.fee.sim_only {
+                return Ok(Submitted::Done(envelope_xdr(TxnResult::Txn(
+                    assembled.transaction().clone(),
+                ))?));
+            }
+            if self.pipeline.key().is_none() {
+                let sim_res = assembled.sim_response();
+                let (return_value, events) = (sim_res.results()?[0].xdr.clone(), sim_res.events()?);
+                crate::log::diagnostic_events(&events, tracing::Level::INFO);
+                return Ok(Submitted::Done(
+                    output_to_string(&self.spec, &return_value, &function)?
+                        .into_result()
+                        .unwrap_or_default(),
+                ));
+            }
+
+            let txn = auth_signed.unwrap_or_else(|| assembled.transaction().clone());
+            let hash = self.pipeline.submit(txn).await?;
+            Ok(Submitted::Sent { function, hash })
+        }
+        .await;
+        (line, res)
+    }
+
+    async fn confirm(
+        &self,
+        line: usize,
+        submitted: Result<Submitted, Error>,
+    ) -> (usize, Result<String, Error>) {
+        let res = async {
+            let (function, hash) = match submitted? {
+                Submitted::Done(output) => return Ok(output),
+                Submitted::Sent { function, hash } => (function, hash),
+            };
+            let res = self.pipeline.confirm(&hash).await?;
+            let events = res.contract_events()?;
+            crate::log::diagnostic_events(&events, tracing::Level::INFO);
+            Ok(
+                output_to_string(&self.spec, &res.return_value()?, &function)?
+                    .into_result()
+                    .unwrap_or_default(),
+            )
+        }
+        .await;
+        (line, res)
+    }
+
+    async fn signature_expiration_ledger(&self) -> Result<u32, Error> {
+        let cached = *self.latest_ledger.lock().unwrap();
+        let latest_ledger = match cached {
+            Some((fetched_at, ledger)) if fetched_at.elapsed() < LATEST_LEDGER_REFRESH => ledger,
+            _ => {
+                let ledger = self.pipeline.client().get_latest_ledger().await?.sequence;
+                *self.latest_ledger.lock().unwrap() = Some((Instant::now(), ledger));
+                ledger
+            }
+        };
+        Ok(latest_ledger + 60) // ~ 5 min
+    }
+}
+
+fn envelope_xdr(res: TxnResult<String>) -> Result<String, Error> {
+    Ok(match res.to_envelope() {
+        TxnEnvelopeResult::TxnEnvelope(tx) => tx.to_xdr_base64(Limits::none())?,
+        TxnEnvelopeResult::Res(output) => output,
+    })
+}
+
+/// Reads a batch file, or stdin if the path is `-`, returning each invocation with its 1-based
+/// line number. Blank lines and lines starting with `#` are skipped.
+fn read_batch(path: &Path) -> Result<Vec<(usize, Vec<OsString>)>, Error> {
+    let contents = if path == Path::new("-") {
+        let mut contents = String::new();
+        io::stdin().read_to_string(&mut contents)?;
+        contents
+    } else {
+        fs::read_to_string(path)
+            .map_err(|e| Error::CannotReadContractFile(path.to_path_buf(), e))?
+    };
+    contents
+        .lines()
+        .enumerate()
+        .map(|(i, input)| (i + 1, input.trim()))
+        .filter(|(_, input)| !input.is_empty() && !input.starts_with('#'))
+        .map(|(line, input)| {
+            let slop = shlex::split(input).ok_or_else(|| Error::InvalidBatchLine {
+                line,
+                input: input.to_string(),
+            })?;
+            Ok((line, slop.into_iter().map(OsString::from).collect()))
+        })
+        .collect()
+}
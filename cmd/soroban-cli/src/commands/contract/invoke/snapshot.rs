@@ -0,0 +1,408 @@
+use std::{
+    collections::BTreeMap,
+    fs, io,
+    path::Path,
+    rc::Rc,
+    time::{SystemTime, UNIX_EPOCH},
+};
+
+use jsonrpsee_core::{client::ClientT, params::ObjectParams};
+use jsonrpsee_http_client::HttpClientBuilder;
+use serde::{Deserialize, Serialize};
+use serde_json::json;
+use sha2::{Digest, Sha256};
+use soroban_env_host::{
+    budget::Budget,
+    storage::{AccessType, Footprint, Storage, StorageMap},
+    xdr::{
+        ConfigSettingEntry, ConfigSettingId, ContractCodeEntry, ContractDataDurability,
+        ContractDataEntry, ContractExecutable, Hash, HostFunction, InvokeContractArgs, LedgerEntry,
+        LedgerEntryData, LedgerEntryExt, LedgerHeader, LedgerHeaderHistoryEntry, LedgerKey,
+        LedgerKeyConfigSetting, LedgerKeyContractCode, LedgerKeyContractData, Limits, ReadXdr,
+        ScAddress, ScContractInstance, ScErrorType, ScSpecEntry, ScVal, SorobanTransactionData,
+        TransactionExt, Uint256, WriteXdr,
+    },
+    DiagnosticLevel, Host, HostError, LedgerInfo,
+};
+
+use super::{build_invoke_contract_tx, output_to_string, Cmd, Error, DEFAULT_ACCOUNT_ID};
+use crate::{
+    commands::{config, global, network::Network, txn_result::TxnResult},
+    get_spec::get_remote_contract_spec,
+    rpc,
+};
+
+/// The ledger entries needed by a contract's view calls, as fetched from the network at one
+/// point in time.
+///
+/// Keys the network had no entry for are kept too, so that calls reading them can still run
+/// against the snapshot.
+#[derive(Serialize, Deserialize)]
+struct SnapshotFile {
+    protocol_version: u32,
+    sequence_number: u32,
+    timestamp: u64,
+    network_id: String,
+    base_reserve: u32,
+    min_temp_entry_ttl: u32,
+    min_persistent_entry_ttl: u32,
+    max_entry_ttl: u32,
+    /// Base64 XDR ledger keys, each with its base64 XDR entry and live until ledger if it had
+    /// one.
+    entries: Vec<(String, Option<(String, Option<u32>)>)>,
+}
+
+type Entries = BTreeMap<LedgerKey, Option<(LedgerEntry, Option<u32>)>>;
+
+struct Snapshot {
+    ledger_info: LedgerInfo,
+    entries: Entries,
+}
+
+impl Snapshot {
+    fn read(path: &Path) -> Result<Option<Self>, Error> {
+        let contents = match fs::read(path) {
+            Ok(contents) => contents,
+            Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(None),
+            Err(e) => return Err(Error::CannotReadSnapshot(path.to_path_buf(), e)),
+        };
+        let file: SnapshotFile = serde_json::from_slice(&contents)
+            .map_err(|e| Error::InvalidSnapshot(path.to_path_buf(), e))?;
+        let entries = file
+            .entries
+            .iter()
+            .map(|(key, entry)| {
+                let key = LedgerKey::from_xdr_base64(key, Limits::none())?;
+                let entry = entry
+                    .as_ref()
+                    .map(|(entry, live_until)| {
+                        Ok::<_, Error>((
+                            LedgerEntry::from_xdr_base64(entry, Limits::none())?,
+                            *live_until,
+                        ))
+                    })
+                    .transpose()?;
+                Ok((key, entry))
+            })
+            .collect::<Result<_, Error>>()?;
+        let network_id = hex::decode(&file.network_id)
+            .ok()
+            .and_then(|id| id.try_into().ok())
+            .ok_or_else(|| Error::InvalidSnapshotNetwork(path.to_path_buf()))?;
+        Ok(Some(Snapshot {
+            ledger_info: LedgerInfo {
+                protocol_version: file.protocol_version,
+                sequence_number: file.sequence_number,
+                timestamp: file.timestamp,
+                network_id,
+                base_reserve: file.base_reserve,
+                min_temp_entry_ttl: file.min_temp_entry_ttl,
+                min_persistent_entry_ttl: file.min_persistent_entry_ttl,
+                max_entry_ttl: file.max_entry_ttl,
+            },
+            entries,
+        }))
+    }
+
+    fn write(&self, path: &Path) -> Result<(), Error> {
+        let info = &self.ledger_info;
+        let file = SnapshotFile {
+            protocol_version: info.protocol_version,
+            sequence_number: info.sequence_number,
+            timestamp: info.timestamp,
+            network_id: hex::encode(info.network_id),
+            base_reserve: info.base_reserve,
+            min_temp_entry_ttl: info.min_temp_entry_ttl,
+            min_persistent_entry_ttl: info.min_persistent_entry_ttl,
+            max_entry_ttl: info.max_entry_ttl,
+            entries: self
+                .entries
+                .iter()
+                .map(|(key, entry)| {
+                    let entry = entry
+                        .as_ref()
+                        .map(|(entry, live_until)| {
+                            Ok::<_, Error>((entry.to_xdr_base64(Limits::none())?, *live_until))
+                        })
+                        .transpose()?;
+                    Ok((key.to_xdr_base64(Limits::none())?, entry))
+                })
+                .collect::<Result<_, Error>>()?,
+        };
+        let error = |e| Error::CannotWriteSnapshot(path.to_path_buf(), e);
+        let dir = match path.parent() {
+            Some(dir) if !dir.as_os_str().is_empty() => dir,
+            _ => Path::new("."),
+        };
+        let mut tmp = tempfile::NamedTempFile::new_in(dir).map_err(error)?;
+        serde_json::to_writer(&mut tmp, &file).map_err(|e| error(e.into()))?;
+        tmp.persist(path).map_err(|e| error(e.error))?;
+        Ok(())
+    }
+
+    /// The spec of the contract, if its instance and code are in the snapshot.
+    fn contract_spec(&self, contract_id: &[u8; 32]) -> Option<Vec<ScSpecEntry>> {
+        let instance = LedgerKey::ContractData(LedgerKeyContractData {
+            contract: ScAddress::Contract(Hash(*contract_id)),
+            key: ScVal::LedgerKeyContractInstance,
+            durability: ContractDataDurability::Persistent,
+        });
+        let Some(Some((entry, _))) = self.entries.get(&instance) else {
+            return None;
+        };
+        let LedgerEntryData::ContractData(ContractDataEntry {
+            val:
+                ScVal::ContractInstance(ScContractInstance {
+                    executable: ContractExecutable::Wasm(hash),
+                    ..
+                }),
+            ..
+        }) = &entry.data
+        else {
+            return None;
+        };
+        let code = LedgerKey::ContractCode(LedgerKeyContractCode { hash: hash.clone() });
+        let Some(Some((entry, _))) = self.entries.get(&code) else {
+            return None;
+        };
+        let LedgerEntryData::ContractCode(ContractCodeEntry { code, .. }) = &entry.data else {
+            return None;
+        };
+        soroban_spec::read::from_wasm(code).ok()
+    }
+
+    /// Runs `args` in a host whose storage holds only the snapshot's entries.
+    fn invoke(&self, args: InvokeContractArgs) -> Result<ScVal, HostError> {
+        let budget = Budget::default();
+        let mut footprint = Footprint::default();
+        let mut map = Vec::with_capacity(self.entries.len());
+        for (key, entry) in &self.entries {
+            let key = Rc::new(key.clone());
+            footprint.record_access(&key, AccessType::ReadOnly, &budget)?;
+            map.push((
+                key,
+                entry
+                    .as_ref()
+                    .map(|(entry, live_until)| (Rc::new(entry.clone()), *live_until)),
+            ));
+        }
+        let storage = Storage::with_enforcing_footprint_and_map(
+            footprint,
+            StorageMap::from_map(map, &budget)?,
+        );
+        let host = Host::with_storage_and_budget(storage, budget);
+        host.set_source_account(DEFAULT_ACCOUNT_ID)?;
+        host.set_ledger_info(self.ledger_info.clone())?;
+        host.set_base_prng_seed([0; 32])?;
+        host.set_diagnostic_level(DiagnosticLevel::Debug)?;
+        let value = host.invoke_function(HostFunction::InvokeContract(args))?;
+        let (_, events) = host.try_finish()?;
+        crate::log::diagnostic_events(&events.0, tracing::Level::INFO);
+        Ok(value)
+    }
+}
+
+impl Cmd {
+    /// Runs a view call against the snapshot at `path`. The call is simulated on the network
+    /// instead when the snapshot does not exist yet or lacks entries the call reads, and the
+    /// entries the simulation reports reading are then added to the snapshot.
+    pub(super) async fn invoke_with_snapshot(
+        &self,
+        path: &Path,
+        contract_id: [u8; 32],
+        global_args: Option<&global::Args>,
+        config: &config::Args,
+    ) -> Result<TxnResult<String>, Error> {
+        let snapshot = Snapshot::read(path)?;
+        let spec_entries = match snapshot
+            .as_ref()
+            .and_then(|s| s.contract_spec(&contract_id))
+        {
+            Some(spec_entries) => spec_entries,
+            None => {
+                get_remote_contract_spec(
+                    &contract_id,
+                    &config.locator,
+                    &config.network,
+                    global_args,
+                    Some(config),
+                )
+                .await?
+            }
+        };
+        let (function, spec, args, _) =
+            self.build_host_function_parameters(contract_id, &spec_entries, config)?;
+
+        if let Some(snapshot) = &snapshot {
+            match snapshot.invoke(args.clone()) {
+                Ok(value) => return output_to_string(&spec, &value, &function),
+                // Storage errors come from reading keys outside of the snapshot.
+                Err(e) if e.error.is_type(ScErrorType::Storage) => {
+                    tracing::debug!("snapshot is missing entries, simulating on the network: {e}");
+                }
+                Err(e) => return Err(e.into()),
+            }
+        }
+
+        let network = config.get_network()?;
+        let client = network.rpc_client()?;
+        let tx = build_invoke_contract_tx(args, 1, self.fee.fee, Uint256([0; 32]))?;
+        let txn = client.simulate_and_assemble_transaction(&tx).await?;
+        let TransactionExt::V1(SorobanTransactionData { resources, .. }) = &txn.transaction().ext
+        else {
+            return Err(Error::MissingFootprint);
+        };
+        let mut keys = resources.footprint.read_only.to_vec();
+        keys.extend(resources.footprint.read_write.iter().cloned());
+        let snapshot = fetch_snapshot(&client, snapshot, keys, &network).await?;
+        snapshot.write(path)?;
+
+        let sim_res = txn.sim_response();
+        let (return_value, events) = (sim_res.results()?[0].xdr.clone(), sim_res.events()?);
+        crate::log::diagnostic_events(&events, tracing::Level::INFO);
+        output_to_string(&spec, &return_value, &function)
+    }
+}
+
+/// Most keys a single `getLedgerEntries` request may ask for.
+const MAX_KEYS_PER_REQUEST: usize = 200;
+
+/// Times the entries of a snapshot are fetched before giving up on getting all of them at the
+/// same ledger. A ledger closes every few seconds, far slower than the requests are made.
+const MAX_FETCH_ATTEMPTS: usize = 5;
+
+/// The base reserve of the public networks, used when the RPC server cannot return the header of
+/// the snapshot's ledger.
+const DEFAULT_BASE_RESERVE: u32 = 5_000_000;
+
+/// Adds the entries of `keys` to `snapshot`, or to a new snapshot if there is none yet.
+///
+/// The entries already in the snapshot are fetched again along with the new ones, all at the same
+/// ledger, and the ledger info is read from that ledger, so that every entry of the snapshot is
+/// from the ledger it describes.
+async fn fetch_snapshot(
+    client: &rpc::Client,
+    snapshot: Option<Snapshot>,
+    keys: Vec<LedgerKey>,
+    network: &Network,
+) -> Result<Snapshot, Error> {
+    let archival = LedgerKey::ConfigSetting(LedgerKeyConfigSetting {
+        config_setting_id: ConfigSettingId::StateArchival,
+    });
+    let previous_base_reserve = snapshot.as_ref().map(|s| s.ledger_info.base_reserve);
+    let mut entries: Entries = snapshot
+        .map(|s| s.entries.into_keys().map(|key| (key, None)).collect())
+        .unwrap_or_default();
+    entries.extend(keys.into_iter().map(|key| (key, None)));
+
+    let mut requested = vec![archival.clone()];
+    requested.extend(entries.keys().cloned());
+    let (latest_ledger, fetched) = fetch_at_one_ledger(client, &requested).await?;
+    let mut archival_settings = None;
+    for entry in fetched {
+        if entry.key == archival {
+            archival_settings = Some(entry.val);
+            continue;
+        }
+        let ledger_entry = LedgerEntry {
+            last_modified_ledger_seq: entry.last_modified_ledger,
+            data: entry.val,
+            ext: LedgerEntryExt::V0,
+        };
+        entries.insert(
+            entry.key,
+            Some((ledger_entry, Some(entry.live_until_ledger_seq))),
+        );
+    }
+    let Some(LedgerEntryData::ConfigSetting(ConfigSettingEntry::StateArchival(archival))) =
+        archival_settings
+    else {
+        return Err(Error::MissingStateArchivalSettings);
+    };
+
+    let (protocol_version, timestamp, base_reserve) =
+        match ledger_header(&network.rpc_url, latest_ledger).await {
+            Ok(header) => (
+                header.ledger_version,
+                header.scp_value.close_time.0,
+                header.base_reserve,
+            ),
+            Err(e) => {
+                tracing::debug!("cannot read the header of ledger {latest_ledger}: {e}");
+                let latest = client.get_latest_ledger().await?;
+                let now = SystemTime::now()
+                    .duration_since(UNIX_EPOCH)
+                    .map_or(0, |d| d.as_secs());
+                let base_reserve = previous_base_reserve.unwrap_or(DEFAULT_BASE_RESERVE);
+                (latest.protocol_version, now, base_reserve)
+            }
+        };
+    Ok(Snapshot {
+        ledger_info: LedgerInfo {
+            protocol_version,
+            sequence_number: latest_ledger,
+            timestamp,
+            network_id: Sha256::digest(network.network_passphrase.as_bytes()).into(),
+            base_reserve,
+            min_temp_entry_ttl: archival.min_temporary_ttl,
+            min_persistent_entry_ttl: archival.min_persistent_ttl,
+            max_entry_ttl: archival.max_entry_ttl,
+        },
+        entries,
+    })
+}
+
+/// The entries of `keys` and the ledger they were fetched at. Keys that do not fit in one request
+/// are fetched in several, which are made again until they all answer at the same ledger.
+async fn fetch_at_one_ledger(
+    client: &rpc::Client,
+    keys: &[LedgerKey],
+) -> Result<(u32, Vec<rpc::FullLedgerEntry>), Error> {
+    let mut ledgers = Vec::new();
+    for _ in 0..MAX_FETCH_ATTEMPTS {
+        ledgers.clear();
+        let mut entries = Vec::new();
+        for chunk in keys.chunks(MAX_KEYS_PER_REQUEST) {
+            let res = client.get_full_ledger_entries(chunk).await?;
+            ledgers.push(u32::try_from(res.latest_ledger).unwrap_or_default());
+            entries.extend(res.entries);
+        }
+        if ledgers.windows(2).all(|w| w[0] == w[1]) {
+            return Ok((ledgers.first().copied().unwrap_or_default(), entries));
+        }
+        tracing::debug!("snapshot entries fetched across ledgers {ledgers:?}, fetching again");
+    }
+    Err(Error::SnapshotLedgerMismatch(ledgers))
+}
+
+#[derive(Deserialize)]
+struct Ledgers {
+    ledgers: Vec<LedgerSummary>,
+}
+
+#[derive(Deserialize)]
+#[serde(rename_all = "camelCase")]
+struct LedgerSummary {
+    sequence: u32,
+    header_xdr: String,
+}
+
+/// The header of ledger `sequence`, read with `getLedgers`, which is not served by RPC servers
+/// before protocol 22 nor for ledgers past their retention window.
+async fn ledger_header(
+    rpc_url: &str,
+    sequence: u32,
+) -> Result<LedgerHeader, Box<dyn std::error::Error + Send + Sync>> {
+    let client = HttpClientBuilder::default().build(rpc_url)?;
+    let mut params = ObjectParams::new();
+    params.insert("startLedger", sequence)?;
+    params.insert("pagination", json!({ "limit": 1 }))?;
+    let res: Ledgers = client.request("getLedgers", params).await?;
+    let ledger = res
+        .ledgers
+        .into_iter()
+        .find(|ledger| ledger.sequence == sequence)
+        .ok_or("ledger not returned")?;
+    let entry = LedgerHeaderHistoryEntry::from_xdr_base64(&ledger.header_xdr, Limits::none())?;
+    Ok(entry.header)
+}
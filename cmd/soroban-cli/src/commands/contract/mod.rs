@@ -10,6 +10,7 @@ pub mod inspect;
 pub mod install;
 pub mod invoke;
 pub mod optimize;
+pub mod pipeline;
 pub mod read;
 pub mod restore;
 
@@ -45,6 +46,8 @@ pub enum Cmd {
     Init(init::Cmd),
 
     /// Inspect a WASM file listing contract functions, meta, etc
+    ///
+    /// If --wasm is a directory, every .wasm file in it is inspected, in parallel.
     Inspect(inspect::Cmd),
 
     /// Install a WASM file to the ledger without creating a contract instance
@@ -123,7 +126,7 @@ impl Cmd {
             Cmd::Asset(asset) => asset.run().await?,
             Cmd::Bindings(bindings) => bindings.run().await?,
             Cmd::Build(build) => build.run()?,
-            Cmd::Extend(extend) => extend.run().await?,
+            Cmd::Extend(extend) => extend.run(global_args).await?,
             Cmd::Deploy(deploy) => deploy.run().await?,
             Cmd::Id(id) => id.run()?,
             Cmd::Init(init) => init.run()?,
@@ -133,7 +136,7 @@ impl Cmd {
             Cmd::Optimize(optimize) => optimize.run()?,
             Cmd::Fetch(fetch) => fetch.run().await?,
             Cmd::Read(read) => read.run().await?,
-            Cmd::Restore(restore) => restore.run().await?,
+            Cmd::Restore(restore) => restore.run(global_args).await?,
         }
         Ok(())
     }
@@ -1,8 +1,12 @@
 use clap::{arg, command, Parser};
-use std::fmt::Debug;
+#[cfg(feature = "opt")]
+use sha2::{Digest, Sha256};
+use std::{fmt::Debug, path::Path};
 #[cfg(feature = "opt")]
 use wasm_opt::{Feature, OptimizationError, OptimizationOptions};
 
+#[cfg(feature = "opt")]
+use crate::commands::config::data;
 use crate::wasm;
 
 #[derive(Parser, Debug, Clone)]
@@ -22,6 +26,12 @@ pub enum Error {
     #[cfg(feature = "opt")]
     #[error("optimization error: {0}")]
     OptimizationError(OptimizationError),
+    #[cfg(feature = "opt")]
+    #[error(transparent)]
+    Data(#[from] data::Error),
+    #[cfg(feature = "opt")]
+    #[error("caching optimized wasm: {0}")]
+    Cache(std::io::Error),
     #[cfg(not(feature = "opt"))]
     #[error("Must install with \"opt\" feature, e.g. `cargo install --locked soroban-cli --features opt")]
     Install,
@@ -49,31 +59,78 @@ impl Cmd {
             wasm_out
         });
 
-        let mut options = OptimizationOptions::new_optimize_for_size_aggressively();
-        options.converge = true;
-
-        // Explicitly set to MVP + sign-ext + mutable-globals, which happens to
-        // also be the default featureset, but just to be extra clear we set it
-        // explicitly.
-        //
-        // Formerly Soroban supported only the MVP feature set, but Rust 1.70 as
-        // well as Clang generate code with sign-ext + mutable-globals enabled,
-        // so Soroban has taken a change to support them also.
-        options.mvp_features_only();
-        options.enable_feature(Feature::MutableGlobals);
-        options.enable_feature(Feature::SignExt);
-
-        options
-            .run(&self.wasm.wasm, &wasm_out)
-            .map_err(Error::OptimizationError)?;
+        let cached = optimize(&self.wasm.wasm, &wasm_out)?;
 
         let wasm_out_size = wasm::len(&wasm_out)?;
         println!(
-            "Optimized: {} ({} bytes)",
+            "Optimized: {} ({} bytes){}",
             wasm_out.to_string_lossy(),
-            wasm_out_size
+            wasm_out_size,
+            if cached { " (cached)" } else { "" }
         );
 
         Ok(())
     }
 }
+
+/// Optimizes `wasm` into `wasm_out`, returning whether the output was reused from an earlier
+/// optimization of a byte-identical input.
+#[cfg(not(feature = "opt"))]
+pub fn optimize(_wasm: &Path, _wasm_out: &Path) -> Result<bool, Error> {
+    Err(Error::Install)
+}
+
+/// Optimizes `wasm` into `wasm_out`, returning whether the output was reused from an earlier
+/// optimization of a byte-identical input.
+#[cfg(feature = "opt")]
+pub fn optimize(wasm: &Path, wasm_out: &Path) -> Result<bool, Error> {
+    let contents = wasm::Args {
+        wasm: wasm.to_path_buf(),
+    }
+    .read()?;
+    // Both the version of wasm-opt and the options it runs with are fixed by the build of the
+    // CLI, so its version and revision identify the optimizer, and output cached by another one
+    // is never reused.
+    let key = hex::encode(
+        Sha256::new()
+            .chain_update(env!("CARGO_PKG_VERSION"))
+            .chain_update(env!("GIT_REVISION"))
+            .chain_update(&contents)
+            .finalize(),
+    );
+    let cached = data::optimized_wasm_dir()?.join(key).with_extension("wasm");
+    if cached.exists() {
+        std::fs::copy(&cached, wasm_out).map_err(Error::Cache)?;
+        return Ok(true);
+    }
+
+    options()
+        .run(wasm, wasm_out)
+        .map_err(Error::OptimizationError)?;
+
+    // Write the cache entry under a temporary name first, so that a concurrent or interrupted
+    // build never sees a partial file.
+    let dir = cached.parent().unwrap_or_else(|| Path::new("."));
+    let tmp = tempfile::NamedTempFile::new_in(dir).map_err(Error::Cache)?;
+    std::fs::copy(wasm_out, tmp.path()).map_err(Error::Cache)?;
+    tmp.persist(&cached).map_err(|e| Error::Cache(e.error))?;
+    Ok(false)
+}
+
+#[cfg(feature = "opt")]
+fn options() -> OptimizationOptions {
+    let mut options = OptimizationOptions::new_optimize_for_size_aggressively();
+    options.converge = true;
+
+    // Explicitly set to MVP + sign-ext + mutable-globals, which happens to
+    // also be the default featureset, but just to be extra clear we set it
+    // explicitly.
+    //
+    // Formerly Soroban supported only the MVP feature set, but Rust 1.70 as
+    // well as Clang generate code with sign-ext + mutable-globals enabled,
+    // so Soroban has taken a change to support them also.
+    options.mvp_features_only();
+    options.enable_feature(Feature::MutableGlobals);
+    options.enable_feature(Feature::SignExt);
+    options
+}
@@ -0,0 +1,168 @@
+use std::sync::atomic::{AtomicI64, Ordering};
+
+use ed25519_dalek::SigningKey;
+use futures_util::{stream, StreamExt};
+use soroban_env_host::xdr::{self, Hash, SequenceNumber, Transaction, Uint256};
+use soroban_rpc::Assembled;
+
+use crate::{
+    commands::{
+        config::data,
+        network::{self, Network},
+    },
+    fee, rpc, signer,
+};
+
+/// Number of transactions being simulated, or awaiting confirmation, at once.
+const MAX_IN_FLIGHT: usize = 10;
+
+#[derive(thiserror::Error, Debug)]
+pub enum Error {
+    #[error(transparent)]
+    Rpc(#[from] rpc::Error),
+    #[error(transparent)]
+    Signer(#[from] signer::Error),
+    #[error("xdr processing error: {0}")]
+    Xdr(#[from] xdr::Error),
+    #[error(transparent)]
+    Data(#[from] data::Error),
+    #[error(transparent)]
+    Network(#[from] network::Error),
+    #[error("cannot submit transactions without a source key")]
+    ReadOnly,
+}
+
+/// Submits transactions from a single source account, handing out sequence numbers locally
+/// instead of refetching the account for every transaction.
+pub struct Pipeline<'a> {
+    client: &'a rpc::Client,
+    key: Option<&'a SigningKey>,
+    source_account: Uint256,
+    network_passphrase: &'a str,
+    fee: &'a fee::Args,
+    rpc_uri: http::Uri,
+    sequence: i64,
+    next_sequence: AtomicI64,
+    no_cache: bool,
+}
+
+impl<'a> Pipeline<'a> {
+    pub async fn new(
+        client: &'a rpc::Client,
+        key: &'a SigningKey,
+        network: &'a Network,
+        fee: &'a fee::Args,
+        no_cache: bool,
+    ) -> Result<Pipeline<'a>, Error> {
+        let public_strkey =
+            stellar_strkey::ed25519::PublicKey(key.verifying_key().to_bytes()).to_string();
+        let account_details = client.get_account(&public_strkey).await?;
+        let sequence: i64 = account_details.seq_num.into();
+        Ok(Self {
+            client,
+            key: Some(key),
+            source_account: Uint256(key.verifying_key().to_bytes()),
+            network_passphrase: &network.network_passphrase,
+            fee,
+            rpc_uri: network.rpc_uri()?,
+            sequence,
+            next_sequence: AtomicI64::new(sequence),
+            no_cache,
+        })
+    }
+
+    /// A pipeline that only simulates transactions from `source_account`, e.g. view calls that
+    /// need no account on the network.
+    pub fn read_only(
+        client: &'a rpc::Client,
+        source_account: Uint256,
+        network: &'a Network,
+        fee: &'a fee::Args,
+        no_cache: bool,
+    ) -> Result<Pipeline<'a>, Error> {
+        Ok(Self {
+            client,
+            key: None,
+            source_account,
+            network_passphrase: &network.network_passphrase,
+            fee,
+            rpc_uri: network.rpc_uri()?,
+            sequence: 0,
+            next_sequence: AtomicI64::new(0),
+            no_cache,
+        })
+    }
+
+    pub fn client(&self) -> &rpc::Client {
+        self.client
+    }
+
+    /// The key transactions are signed with, `None` for a read only pipeline.
+    pub fn key(&self) -> Option<&SigningKey> {
+        self.key
+    }
+
+    pub fn source_account(&self) -> &Uint256 {
+        &self.source_account
+    }
+
+    /// The sequence number to build transactions with. It is replaced when they are submitted.
+    pub fn sequence(&self) -> i64 {
+        self.sequence + 1
+    }
+
+    pub fn no_cache(&self) -> bool {
+        self.no_cache
+    }
+
+    /// Simulates, signs, submits and confirms `txs`, returning their results in order.
+    ///
+    /// Simulations and confirmations run concurrently, while signing and submission happen one
+    /// at a time so sequence numbers are handed out without gaps.
+    pub async fn run(
+        &self,
+        txs: Vec<Transaction>,
+    ) -> Vec<Result<rpc::GetTransactionResponse, Error>> {
+        stream::iter(txs)
+            .map(|tx| async { Ok(self.assemble(tx).await?.transaction().clone()) })
+            .buffered(MAX_IN_FLIGHT)
+            .then(|tx: Result<Transaction, Error>| async { self.submit(tx?).await })
+            .map(|hash| async { self.confirm(&hash?).await })
+            .buffered(MAX_IN_FLIGHT)
+            .collect()
+            .await
+    }
+
+    /// Simulates `tx` and applies the fee arguments to the assembled transaction, recording the
+    /// simulation in the action log.
+    pub async fn assemble(&self, tx: Transaction) -> Result<Assembled, Error> {
+        let txn = self.client.simulate_and_assemble_transaction(&tx).await?;
+        let txn = self.fee.apply_to_assembled_txn(txn);
+        if !self.no_cache {
+            data::write(txn.sim_response().clone().into(), &self.rpc_uri)?;
+        }
+        Ok(txn)
+    }
+
+    /// Signs `tx` with the next sequence number and sends it. Calls must not overlap, so that
+    /// sequence numbers are handed out without gaps.
+    pub async fn submit(&self, mut tx: Transaction) -> Result<Hash, Error> {
+        let key = self.key.ok_or(Error::ReadOnly)?;
+        let sequence = self.next_sequence.load(Ordering::SeqCst) + 1;
+        tx.seq_num = SequenceNumber(sequence);
+        let envelope = signer::sign_tx(key, &tx, self.network_passphrase)?;
+        let hash = self.client.send_transaction(&envelope).await?;
+        // Only a transaction accepted by the server consumes its sequence number.
+        self.next_sequence.store(sequence, Ordering::SeqCst);
+        Ok(hash)
+    }
+
+    /// Waits for the transaction `hash` to be applied, recording it in the action log.
+    pub async fn confirm(&self, hash: &Hash) -> Result<rpc::GetTransactionResponse, Error> {
+        let res = self.client.get_transaction_polling(hash, None).await?;
+        if !self.no_cache {
+            data::write(res.clone().try_into()?, &self.rpc_uri)?;
+        }
+        Ok(res)
+    }
+}
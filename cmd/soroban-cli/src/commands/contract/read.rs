@@ -1,9 +1,11 @@
 use std::{
     fmt::Debug,
-    io::{self, stdout},
+    io::{self, stdout, Write},
+    path::{Path, PathBuf},
 };
 
 use clap::{command, Parser, ValueEnum};
+use futures_util::{stream, StreamExt};
 use soroban_env_host::{
     xdr::{
         ContractDataEntry, Error as XdrError, LedgerEntryData, LedgerKey, LedgerKeyContractData,
@@ -18,7 +20,7 @@ use crate::{
         global, NetworkRunnable,
     },
     key,
-    rpc::{self, Client, FullLedgerEntries, FullLedgerEntry},
+    rpc::{self, FullLedgerEntries, FullLedgerEntry},
 };
 
 #[derive(Parser, Debug, Clone)]
@@ -29,10 +31,25 @@ pub struct Cmd {
     pub output: Output,
     #[command(flatten)]
     pub key: key::Args,
+    /// File of storage keys (base64-encoded XDR) to read, one per line, or `-` for stdin
+    ///
+    /// Keys are requested in batches as the file is read, and entries are written out as each
+    /// batch arrives, so the file can be arbitrarily long.
+    #[arg(
+        long,
+        conflicts_with_all = ["key", "key_xdr", "wasm", "wasm_hash"],
+    )]
+    pub key_file: Option<PathBuf>,
     #[command(flatten)]
     config: config::Args,
 }
 
+/// Maximum number of keys the RPC server accepts in a single `getLedgerEntries` request.
+const MAX_KEYS_PER_REQUEST: usize = 200;
+
+/// Number of `getLedgerEntries` requests in flight at once when reading a `--key-file`.
+const MAX_REQUESTS_IN_FLIGHT: usize = 4;
+
 #[derive(Clone, Copy, Debug, Eq, Hash, PartialEq, ValueEnum)]
 pub enum Output {
     /// String
@@ -95,6 +112,9 @@ pub enum Error {
 
 impl Cmd {
     pub async fn run(&self) -> Result<(), Error> {
+        if let Some(path) = &self.key_file {
+            return self.run_key_file(path).await;
+        }
         let entries = self.run_against_rpc_server(None, None).await?;
         self.output_entries(&entries)
     }
@@ -105,12 +125,69 @@ impl Cmd {
         }
         tracing::trace!("{entries:#?}");
         let mut out = csv::Writer::from_writer(stdout());
+        self.write_entries(&mut out, &entries.entries)?;
+        out.flush()
+            .map_err(|e| Error::CannotPrintFlush { error: e })?;
+        Ok(())
+    }
+
+    /// Reads the entries of every key in `path`, a few batches at a time, writing each batch
+    /// out in order as soon as it arrives.
+    async fn run_key_file(&self, path: &Path) -> Result<(), Error> {
+        let network = self.config.get_network()?;
+        tracing::trace!(?network);
+        let client = network.rpc_client()?;
+        let contract = self.config.locator.resolve_contract_id(
+            self.key.contract_id.as_ref().unwrap(),
+            &network.network_passphrase,
+        )?;
+
+        let mut keys = key::read_key_file(path)?;
+        let batches = std::iter::from_fn(|| {
+            let batch = keys
+                .by_ref()
+                .take(MAX_KEYS_PER_REQUEST)
+                .map(|key| Ok(self.key.contract_data_key(&contract, key?)))
+                .collect::<Result<Vec<_>, Error>>();
+            match batch {
+                Ok(batch) if batch.is_empty() => None,
+                batch => Some(batch),
+            }
+        });
+
+        let client = &client;
+        let mut responses = std::pin::pin!(stream::iter(batches)
+            .map(
+                |keys| async move { Ok::<_, Error>(client.get_full_ledger_entries(&keys?).await?) }
+            )
+            .buffered(MAX_REQUESTS_IN_FLIGHT));
+
+        let mut out = csv::Writer::from_writer(stdout());
+        let mut found = 0;
+        while let Some(entries) = responses.next().await {
+            let entries = entries?;
+            found += entries.entries.len();
+            self.write_entries(&mut out, &entries.entries)?;
+            out.flush()
+                .map_err(|e| Error::CannotPrintFlush { error: e })?;
+        }
+        if found == 0 {
+            return Err(Error::NoContractDataEntryFoundForContractID);
+        }
+        Ok(())
+    }
+
+    fn write_entries<W: Write>(
+        &self,
+        out: &mut csv::Writer<W>,
+        entries: &[FullLedgerEntry],
+    ) -> Result<(), Error> {
         for FullLedgerEntry {
             key,
             val,
             live_until_ledger_seq,
             last_modified_ledger,
-        } in &entries.entries
+        } in entries
         {
             let (
                 LedgerKey::ContractData(LedgerKeyContractData { key, .. }),
@@ -168,8 +245,6 @@ impl Cmd {
             out.write_record(output)
                 .map_err(|e| Error::CannotPrintAsCsv { error: e })?;
         }
-        out.flush()
-            .map_err(|e| Error::CannotPrintFlush { error: e })?;
         Ok(())
     }
 }
@@ -187,7 +262,7 @@ impl NetworkRunnable for Cmd {
         let config = config.unwrap_or(&self.config);
         let network = config.get_network()?;
         tracing::trace!(?network);
-        let client = Client::new(&network.rpc_url)?;
+        let client = network.rpc_client()?;
         let contract = config.locator.resolve_contract_id(
             self.key.contract_id.as_ref().unwrap(),
             &network.network_passphrase,
@@ -17,9 +17,7 @@ use crate::{
         txn_result::{TxnEnvelopeResult, TxnResult},
         NetworkRunnable,
     },
-    key,
-    rpc::{self, Client},
-    wasm, Pwd,
+    key, metrics, rpc, wasm, Pwd,
 };
 
 #[derive(Parser, Debug, Clone)]
@@ -93,7 +91,7 @@ pub enum Error {
 
 impl Cmd {
     #[allow(clippy::too_many_lines)]
-    pub async fn run(&self) -> Result<(), Error> {
+    pub async fn run(&self, global_args: &global::Args) -> Result<(), Error> {
         let res = self.run_against_rpc_server(None, None).await?.to_envelope();
         let expiration_ledger_seq = match res {
             TxnEnvelopeResult::TxnEnvelope(tx) => {
@@ -106,11 +104,12 @@ impl Cmd {
             extend::Cmd {
                 key: self.key.clone(),
                 ledgers_to_extend,
+                plan: None,
                 config: self.config.clone(),
                 fee: self.fee.clone(),
                 ttl_ledger_only: false,
             }
-            .run()
+            .run(global_args)
             .await?;
         } else {
             println!("New ttl ledger: {expiration_ledger_seq}");
@@ -138,13 +137,14 @@ impl NetworkRunnable for Cmd {
             &network.network_passphrase,
         )?;
         let entry_keys = self.key.parse_keys(contract)?;
-        let client = Client::new(&network.rpc_url)?;
+        let client = network.rpc_client()?;
         let key = config.key_pair()?;
 
         // Get the account sequence number
         let public_strkey =
             stellar_strkey::ed25519::PublicKey(key.verifying_key().to_bytes()).to_string();
-        let account_details = client.get_account(&public_strkey).await?;
+        let account_details =
+            metrics::phase("get_account", client.get_account(&public_strkey)).await?;
         let sequence: i64 = account_details.seq_num.into();
 
         let tx = Transaction {
@@ -177,9 +177,9 @@ impl NetworkRunnable for Cmd {
         if self.fee.build_only {
             return Ok(TxnResult::Txn(tx));
         }
-        let res = client
-            .send_transaction_polling(&config.sign_with_local_key(tx).await?)
-            .await?;
+        let signed = metrics::phase("sign", config.sign_with_local_key(tx.clone())).await?;
+        let res = metrics::phase("send", client.send_transaction_polling(&signed)).await?;
+        metrics::record_result(&tx, &res);
         if args.map_or(true, |a| !a.no_cache) {
             data::write(res.clone().try_into()?, &network.rpc_uri()?)?;
         }
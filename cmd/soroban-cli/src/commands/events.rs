@@ -1,5 +1,9 @@
 use clap::{arg, command, Parser};
-use std::io;
+use std::{
+    io::{self, Write},
+    path::PathBuf,
+    sync::Arc,
+};
 
 use soroban_env_host::xdr::{self, Limits, ReadXdr};
 
@@ -9,18 +13,30 @@ use super::{
 };
 use crate::rpc;
 
+mod backfill;
+mod filters;
+mod follow;
+
 #[derive(Parser, Debug, Clone)]
 #[group(skip)]
 pub struct Cmd {
     /// The first ledger sequence number in the range to pull events
     /// https://developers.stellar.org/docs/encyclopedia/ledger-headers#ledger-sequence
-    #[arg(long, conflicts_with = "cursor", required_unless_present = "cursor")]
+    #[arg(
+        long,
+        conflicts_with = "cursor",
+        required_unless_present_any = ["cursor", "checkpoint"]
+    )]
     start_ledger: Option<u32>,
+    /// The last ledger sequence number in the range to pull events. All events from
+    /// `--start-ledger` up to and including this ledger are printed, regardless of `--count`.
+    #[arg(long, requires = "start_ledger", conflicts_with = "follow")]
+    end_ledger: Option<u32>,
     /// The cursor corresponding to the start of the event range.
     #[arg(
         long,
         conflicts_with = "start_ledger",
-        required_unless_present = "start_ledger"
+        required_unless_present_any = ["start_ledger", "checkpoint"]
     )]
     cursor: Option<String>,
     /// Output formatting options for event stream
@@ -29,13 +45,26 @@ pub struct Cmd {
     /// The maximum number of events to display (defer to the server-defined limit).
     #[arg(short, long, default_value = "10")]
     count: usize,
+    /// Keep polling for new events once the latest ledger is reached, printing them as they
+    /// arrive, with `--count` as the page size. With `--output json` each event is printed as a
+    /// single line of JSON.
+    #[arg(long)]
+    follow: bool,
+    /// File the position in the event stream is saved to after each page of events. If the
+    /// file exists, following resumes from it instead of `--start-ledger` or `--cursor`.
+    #[arg(long, requires = "follow")]
+    checkpoint: Option<PathBuf>,
+    /// Number of ledger windows of the `--start-ledger` to `--end-ledger` range to fetch
+    /// concurrently. Events are printed in order regardless.
+    #[arg(long, default_value = "4", requires = "end_ledger")]
+    parallel: usize,
     /// A set of (up to 5) contract IDs to filter events on. This parameter can
     /// be passed multiple times, e.g. `--id C123.. --id C456..`, or passed with
     /// multiple parameters, e.g. `--id C123 C456`.
     ///
-    /// Though the specification supports multiple filter objects (i.e.
-    /// combinations of type, IDs, and topics), only one set can be specified on
-    /// the command-line today, though that set can have multiple IDs/topics.
+    /// Only one filter object (i.e. combination of type, IDs, and topics) can
+    /// be specified on the command-line, though it can have multiple
+    /// IDs/topics. Use `--filters` to specify more.
     #[arg(
         long = "id",
         num_args = 1..=6,
@@ -55,7 +84,8 @@ pub struct Cmd {
     ///     --topic "AAAABQAAAAdDT1VOVEVSAA==" --topic '*,*'
     ///
     /// Note that all of these topic filters are combined with the contract IDs
-    /// into a single filter (i.e. combination of type, IDs, and topics).
+    /// into a single filter (i.e. combination of type, IDs, and topics). Use
+    /// `--filters` to watch several filters at once.
     #[arg(
         long = "topic",
         num_args = 1..=5,
@@ -70,6 +100,24 @@ pub struct Cmd {
         help_heading = "FILTERS"
     )]
     event_type: rpc::EventType,
+    /// A JSON file with a list of filter groups to watch, instead of `--id`,
+    /// `--topic` and `--type`.
+    ///
+    /// Each group is an object with an optional `name`, a `type` (`all`,
+    /// `contract` or `system`), and lists of contract `ids` and `topics` in the
+    /// same format as `--id` and `--topic`, of any length, e.g.
+    ///
+    ///     [{"name": "swaps", "type": "contract", "ids": ["C123..", "C456.."]}]
+    ///
+    /// Groups are packed into as few requests as the server allows, each event
+    /// is printed once, one per line, along with the names of the groups it
+    /// matched.
+    #[arg(
+        long,
+        conflicts_with_all = ["contract_ids", "topic_filters"],
+        help_heading = "FILTERS"
+    )]
+    filters: Option<PathBuf>,
     #[command(flatten)]
     locator: locator::Args,
     #[command(flatten)]
@@ -108,6 +156,20 @@ pub enum Error {
     MissingStartLedgerAndCursor,
     #[error("missing target")]
     MissingTarget,
+    #[error("cannot parse filter file {path}: {error}")]
+    InvalidFilterFile {
+        path: PathBuf,
+        error: serde_json::Error,
+    },
+    #[error("filter file {path} has no filter groups")]
+    EmptyFilterFile { path: PathBuf },
+    #[error(transparent)]
+    JsonRpc(#[from] jsonrpsee_core::Error),
+    #[error("cannot read checkpoint {path}: {error}")]
+    InvalidCheckpoint {
+        path: PathBuf,
+        error: serde_json::Error,
+    },
     #[error(transparent)]
     Rpc(#[from] rpc::Error),
     #[error(transparent)]
@@ -138,25 +200,26 @@ pub enum OutputFormat {
 
 impl Cmd {
     pub async fn run(&mut self) -> Result<(), Error> {
-        // Validate that topics are made up of segments.
         for topic in &self.topic_filters {
-            for (i, segment) in topic.split(',').enumerate() {
-                if i > 4 {
-                    return Err(Error::InvalidTopicFilter {
-                        topic: topic.to_string(),
-                    });
-                }
+            validate_topic(topic)?;
+        }
 
-                if segment != "*" {
-                    if let Err(e) = xdr::ScVal::from_xdr_base64(segment, Limits::none()) {
-                        return Err(Error::InvalidSegment {
-                            topic: topic.to_string(),
-                            segment: segment.to_string(),
-                            error: e,
-                        });
-                    }
-                }
+        if self.follow {
+            return self.run_follow().await;
+        }
+        if let (Some(start), Some(end)) = (self.start_ledger, self.end_ledger) {
+            return self.run_backfill(start, end).await;
+        }
+        if self.filters.is_some() {
+            let source = self.connect().await?;
+            let page = self.page(&source, self.start()?).await?;
+            let mut out = io::BufWriter::new(io::stdout());
+            for event in &page.events {
+                self.write_event(&mut out, &source, event)?;
             }
+            writeln!(out, "Latest Ledger: {}", page.latest_ledger)?;
+            out.flush()?;
+            return Ok(());
         }
 
         let response = self.run_against_rpc_server(None, None).await?;
@@ -195,6 +258,147 @@ impl Cmd {
         };
         Ok(start)
     }
+
+    fn write_event(
+        &self,
+        out: &mut impl io::Write,
+        source: &Source,
+        event: &rpc::Event,
+    ) -> Result<(), Error> {
+        let groups = match source {
+            Source::Args { .. } => None,
+            Source::Groups(groups) => Some(groups.matching(event)),
+        };
+        match self.output {
+            OutputFormat::Json => {
+                let invalid_json = |error| Error::InvalidJson {
+                    debug: format!("{event:#?}"),
+                    error,
+                };
+                if let Some(groups) = groups {
+                    let mut value = serde_json::to_value(event).map_err(invalid_json)?;
+                    if let Some(value) = value.as_object_mut() {
+                        value.insert("filters".to_string(), groups.into());
+                    }
+                    serde_json::to_writer(&mut *out, &value).map_err(invalid_json)?;
+                } else {
+                    serde_json::to_writer(&mut *out, event).map_err(invalid_json)?;
+                }
+                writeln!(out)?;
+            }
+            OutputFormat::Plain => {
+                if let Some(groups) = groups {
+                    writeln!(out, "Filters: {}", groups.join(", "))?;
+                }
+                writeln!(out, "{event}")?;
+            }
+            OutputFormat::Pretty => {
+                if let Some(groups) = groups {
+                    writeln!(out, "Filters: {}", groups.join(", "))?;
+                }
+                // Pretty printing writes to the terminal directly.
+                out.flush()?;
+                event.pretty_print()?;
+            }
+        }
+        Ok(())
+    }
+
+    /// Connects to the RPC server of the network, returning where to fetch events from.
+    async fn connect(&self) -> Result<Source, Error> {
+        let network = self.network.get(&self.locator)?;
+        let client = network.rpc_client()?;
+        client
+            .verify_network_passphrase(Some(&network.network_passphrase))
+            .await?;
+        if let Some(path) = &self.filters {
+            return Ok(Source::Groups(self.load_filters(path, &network)?));
+        }
+        let contract_ids = self.resolve_contract_ids(&network)?;
+        Ok(Source::Args {
+            client,
+            contract_ids,
+        })
+    }
+
+    /// Fetches the next page of up to `--count` events from `start`.
+    async fn page(&self, source: &Source, start: rpc::EventStart) -> Result<Page, Error> {
+        match source {
+            Source::Args {
+                client,
+                contract_ids,
+            } => {
+                let response = client
+                    .get_events(
+                        start,
+                        Some(self.event_type),
+                        contract_ids,
+                        &self.topic_filters,
+                        Some(self.count),
+                    )
+                    .await?;
+                Ok(Page {
+                    more: response.events.len() >= self.count,
+                    events: response.events,
+                    latest_ledger: response.latest_ledger,
+                })
+            }
+            Source::Groups(groups) => groups.page(start, self.count).await,
+        }
+    }
+
+    fn resolve_contract_ids(&self, network: &network::Network) -> Result<Vec<String>, Error> {
+        self.contract_ids
+            .iter()
+            .map(|id| {
+                Ok(self
+                    .locator
+                    .resolve_contract_id(id, &network.network_passphrase)?
+                    .to_string())
+            })
+            .collect()
+    }
+}
+
+/// Where events are fetched from.
+enum Source {
+    /// The single filter given by `--id`, `--topic` and `--type`.
+    Args {
+        client: Arc<rpc::Client>,
+        contract_ids: Vec<String>,
+    },
+    /// The filter groups of a `--filters` file.
+    Groups(filters::Groups),
+}
+
+/// A page of events, in order.
+struct Page {
+    events: Vec<rpc::Event>,
+    latest_ledger: u32,
+    /// Whether more events may follow the last one without waiting for new ledgers.
+    more: bool,
+}
+
+/// Validates that a topic filter is made up of 1-4 segments.
+fn validate_topic(topic: &str) -> Result<(), Error> {
+    for (i, segment) in topic.split(',').enumerate() {
+        if i > 4 {
+            return Err(Error::InvalidTopicFilter {
+                topic: topic.to_string(),
+            });
+        }
+
+        if segment != "*" {
+            if let Err(e) = xdr::ScVal::from_xdr_base64(segment, Limits::none()) {
+                return Err(Error::InvalidSegment {
+                    topic: topic.to_string(),
+                    segment: segment.to_string(),
+                    error: e,
+                });
+            }
+        }
+    }
+    Ok(())
 }
 
 #[async_trait::async_trait]
@@ -214,21 +418,12 @@ impl NetworkRunnable for Cmd {
             self.network.get(&self.locator)
         }?;
 
-        let client = rpc::Client::new(&network.rpc_url)?;
+        let client = network.rpc_client()?;
         client
             .verify_network_passphrase(Some(&network.network_passphrase))
             .await?;
 
-        let contract_ids: Vec<String> = self
-            .contract_ids
-            .iter()
-            .map(|id| {
-                Ok(self
-                    .locator
-                    .resolve_contract_id(id, &network.network_passphrase)?
-                    .to_string())
-            })
-            .collect::<Result<Vec<_>, Error>>()?;
+        let contract_ids = self.resolve_contract_ids(&network)?;
 
         Ok(client
             .get_events(
@@ -0,0 +1,100 @@
+use std::{
+    io::{self, BufWriter, Write},
+    ops::RangeInclusive,
+};
+
+use futures_util::{stream, StreamExt};
+
+use super::{Cmd, Error, Source};
+use crate::rpc;
+
+/// Number of windows the range is split into per concurrent request, so that a window dense
+/// with events does not leave the other requests idle for long.
+const WINDOWS_PER_REQUEST: u32 = 4;
+
+impl Cmd {
+    /// Fetches every event from `start` to `end`, splitting the range into ledger windows that
+    /// are fetched concurrently. Windows are disjoint and printed in range order, so events come
+    /// out in the same order as a sequential walk.
+    pub(super) async fn run_backfill(&self, start: u32, end: u32) -> Result<(), Error> {
+        let source = self.connect().await?;
+        let parallel = u32::try_from(self.parallel.max(1)).unwrap_or(u32::MAX);
+        let results = stream::iter(windows(
+            start..=end,
+            parallel.saturating_mul(WINDOWS_PER_REQUEST),
+        ))
+        .map(|window| self.fetch_window(&source, window))
+        .buffered(self.parallel.max(1));
+        let mut results = std::pin::pin!(results);
+
+        let mut out = BufWriter::new(io::stdout());
+        while let Some(events) = results.next().await {
+            for event in &events? {
+                self.write_event(&mut out, &source, event)?;
+            }
+            out.flush()?;
+        }
+        Ok(())
+    }
+
+    async fn fetch_window(
+        &self,
+        source: &Source,
+        window: RangeInclusive<u32>,
+    ) -> Result<Vec<rpc::Event>, Error> {
+        let mut events = Vec::new();
+        let mut start = rpc::EventStart::Ledger(*window.start());
+        loop {
+            let page = self.page(source, start).await?;
+            let mut past_end = false;
+            for event in page.events {
+                if event.ledger > *window.end() {
+                    past_end = true;
+                    break;
+                }
+                events.push(event);
+            }
+            match events.last() {
+                Some(last) if page.more && !past_end => {
+                    start = rpc::EventStart::Cursor(last.id.clone());
+                }
+                _ => return Ok(events),
+            }
+        }
+    }
+}
+
+/// Splits `range` into at most `count` contiguous windows of about the same number of ledgers.
+fn windows(range: RangeInclusive<u32>, count: u32) -> Vec<RangeInclusive<u32>> {
+    let (start, end) = (u64::from(*range.start()), u64::from(*range.end()));
+    if start > end {
+        return Vec::new();
+    }
+    let len = end - start + 1;
+    let size = len.div_ceil(u64::from(count.max(1)));
+    (start..=end)
+        .step_by(usize::try_from(size).unwrap_or(usize::MAX))
+        .map(|first| {
+            let last = (first + size - 1).min(end);
+            // Both bounds are within the original u32 range.
+            u32::try_from(first).unwrap()..=u32::try_from(last).unwrap()
+        })
+        .collect()
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn windows_cover_range_in_order() {
+        assert_eq!(windows(10..=19, 4), [10..=12, 13..=15, 16..=18, 19..=19]);
+        assert_eq!(windows(5..=6, 8), [5..=5, 6..=6]);
+        assert_eq!(windows(7..=7, 0), [7..=7]);
+        assert!(windows(8..=7, 4).is_empty());
+        assert_eq!(
+            windows(u32::MAX - 1..=u32::MAX, 1),
+            [u32::MAX - 1..=u32::MAX]
+        );
+    }
+}
@@ -0,0 +1,287 @@
+use std::path::Path;
+
+use futures_util::future::try_join_all;
+use jsonrpsee_core::{client::ClientT, params::ObjectParams};
+use jsonrpsee_http_client::{HttpClient, HttpClientBuilder};
+use serde::Deserialize;
+use serde_json::{json, Value};
+
+use super::{validate_topic, Cmd, Error, Page};
+use crate::{commands::network, rpc};
+
+/// Limits the RPC server puts on a single `getEvents` request.
+const MAX_FILTERS_PER_REQUEST: usize = 5;
+const MAX_CONTRACT_IDS_PER_FILTER: usize = 5;
+const MAX_TOPICS_PER_FILTER: usize = 5;
+
+/// A filter group as written in a `--filters` file.
+#[derive(Deserialize)]
+#[serde(rename_all = "snake_case", deny_unknown_fields)]
+struct GroupEntry {
+    name: Option<String>,
+    #[serde(default, rename = "type")]
+    event_type: GroupType,
+    #[serde(default)]
+    ids: Vec<String>,
+    #[serde(default)]
+    topics: Vec<String>,
+}
+
+#[derive(Deserialize, Default, Clone, Copy, Debug, PartialEq, Eq)]
+#[serde(rename_all = "snake_case")]
+enum GroupType {
+    #[default]
+    All,
+    Contract,
+    System,
+}
+
+struct Group {
+    name: String,
+    event_type: GroupType,
+    contract_ids: Vec<String>,
+    topics: Vec<Vec<String>>,
+}
+
+impl Group {
+    fn matches(&self, event: &rpc::Event) -> bool {
+        let type_matches = match self.event_type {
+            GroupType::All => true,
+            GroupType::Contract => event.event_type == "contract",
+            GroupType::System => event.event_type == "system",
+        };
+        type_matches
+            && (self.contract_ids.is_empty() || self.contract_ids.contains(&event.contract_id))
+            && (self.topics.is_empty()
+                || self.topics.iter().any(|topic| {
+                    topic.len() == event.topic.len()
+                        && topic
+                            .iter()
+                            .zip(&event.topic)
+                            .all(|(segment, value)| segment == "*" || segment == value)
+                }))
+    }
+
+    /// The filters selecting this group's events, split to fit the per filter limits.
+    fn filters(&self) -> Vec<Value> {
+        let ids = chunks_or_empty(&self.contract_ids, MAX_CONTRACT_IDS_PER_FILTER);
+        let topics = chunks_or_empty(&self.topics, MAX_TOPICS_PER_FILTER);
+        let mut filters = Vec::with_capacity(ids.len() * topics.len());
+        for ids in &ids {
+            for topics in &topics {
+                let mut filter = json!({});
+                match self.event_type {
+                    GroupType::All => {}
+                    GroupType::Contract => filter["type"] = json!("contract"),
+                    GroupType::System => filter["type"] = json!("system"),
+                }
+                if !ids.is_empty() {
+                    filter["contractIds"] = json!(ids);
+                }
+                if !topics.is_empty() {
+                    filter["topics"] = json!(topics);
+                }
+                filters.push(filter);
+            }
+        }
+        filters
+    }
+}
+
+/// Splits `items` into chunks of at most `size`, with a single empty chunk if there are none.
+fn chunks_or_empty<T>(items: &[T], size: usize) -> Vec<&[T]> {
+    if items.is_empty() {
+        vec![&[]]
+    } else {
+        items.chunks(size).collect()
+    }
+}
+
+/// The filter groups of a `--filters` file, packed into as few `getEvents` requests as the
+/// server allows.
+pub(super) struct Groups {
+    client: HttpClient,
+    groups: Vec<Group>,
+    requests: Vec<Vec<Value>>,
+}
+
+impl Groups {
+    fn new(rpc_url: &str, groups: Vec<Group>) -> Result<Self, Error> {
+        let mut filters: Vec<Value> = Vec::new();
+        for filter in groups.iter().flat_map(Group::filters) {
+            // Overlapping groups may select the same events, only ask for them once.
+            if !filters.contains(&filter) {
+                filters.push(filter);
+            }
+        }
+        let requests = filters
+            .chunks(MAX_FILTERS_PER_REQUEST)
+            .map(<[Value]>::to_vec)
+            .collect();
+        Ok(Self {
+            client: HttpClientBuilder::default().build(rpc_url)?,
+            groups,
+            requests,
+        })
+    }
+
+    /// Names of the groups `event` belongs to.
+    pub(super) fn matching(&self, event: &rpc::Event) -> Vec<&str> {
+        self.groups
+            .iter()
+            .filter(|group| group.matches(event))
+            .map(|group| group.name.as_str())
+            .collect()
+    }
+
+    /// Fetches the next page of up to `limit` events matching any group.
+    pub(super) async fn page(&self, start: rpc::EventStart, limit: usize) -> Result<Page, Error> {
+        let responses = try_join_all(
+            self.requests
+                .iter()
+                .map(|filters| self.get_events(&start, filters, limit)),
+        )
+        .await?;
+
+        let mut latest_ledger = u32::MAX;
+        let mut more = false;
+        // A full page may stop short of events that another request already returned, so the
+        // merged page may only extend to the earliest last event among the full pages.
+        let mut bound: Option<String> = None;
+        let mut events = Vec::new();
+        for response in responses {
+            latest_ledger = latest_ledger.min(response.latest_ledger);
+            if response.events.len() >= limit {
+                more = true;
+                if let Some(last) = response.events.last() {
+                    if bound.as_ref().map_or(true, |bound| last.id < *bound) {
+                        bound = Some(last.id.clone());
+                    }
+                }
+            }
+            events.extend(response.events);
+        }
+        events.sort_by(|a, b| a.id.cmp(&b.id));
+        events.dedup_by(|a, b| a.id == b.id);
+        if let Some(bound) = bound {
+            events.retain(|event| event.id <= bound);
+        }
+        more |= events.len() > limit;
+        events.truncate(limit);
+        Ok(Page {
+            events,
+            latest_ledger,
+            more,
+        })
+    }
+
+    async fn get_events(
+        &self,
+        start: &rpc::EventStart,
+        filters: &[Value],
+        limit: usize,
+    ) -> Result<rpc::GetEventsResponse, Error> {
+        let mut params = ObjectParams::new();
+        match start {
+            rpc::EventStart::Ledger(ledger) => {
+                params.insert("startLedger", ledger)?;
+                params.insert("pagination", json!({ "limit": limit }))?;
+            }
+            rpc::EventStart::Cursor(cursor) => {
+                params.insert("pagination", json!({ "cursor": cursor, "limit": limit }))?;
+            }
+        }
+        params.insert("filters", filters)?;
+        Ok(self.client.request("getEvents", params).await?)
+    }
+}
+
+impl Cmd {
+    pub(super) fn load_filters(
+        &self,
+        path: &Path,
+        network: &network::Network,
+    ) -> Result<Groups, Error> {
+        let contents = std::fs::read_to_string(path).map_err(|e| Error::CannotReadFile {
+            path: path.display().to_string(),
+            error: e.to_string(),
+        })?;
+        let entries: Vec<GroupEntry> =
+            serde_json::from_str(&contents).map_err(|error| Error::InvalidFilterFile {
+                path: path.to_path_buf(),
+                error,
+            })?;
+        // Without a group there would be nothing to ask the server for, nor a ledger to follow.
+        if entries.is_empty() {
+            return Err(Error::EmptyFilterFile {
+                path: path.to_path_buf(),
+            });
+        }
+        let groups = entries
+            .into_iter()
+            .enumerate()
+            .map(|(i, entry)| {
+                for topic in &entry.topics {
+                    validate_topic(topic)?;
+                }
+                let contract_ids = entry
+                    .ids
+                    .iter()
+                    .map(|id| {
+                        Ok(self
+                            .locator
+                            .resolve_contract_id(id, &network.network_passphrase)?
+                            .to_string())
+                    })
+                    .collect::<Result<_, Error>>()?;
+                Ok(Group {
+                    name: entry.name.unwrap_or_else(|| i.to_string()),
+                    event_type: entry.event_type,
+                    contract_ids,
+                    topics: entry
+                        .topics
+                        .iter()
+                        .map(|topic| topic.split(',').map(String::from).collect())
+                        .collect(),
+                })
+            })
+            .collect::<Result<Vec<_>, Error>>()?;
+        Groups::new(&network.rpc_url, groups)
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    fn group(ids: usize, topics: usize) -> Group {
+        Group {
+            name: "g".to_string(),
+            event_type: GroupType::Contract,
+            contract_ids: (0..ids).map(|i| format!("C{i}")).collect(),
+            topics: (0..topics)
+                .map(|i| vec![format!("T{i}"), "*".to_string()])
+                .collect(),
+        }
+    }
+
+    #[test]
+    fn groups_are_split_to_fit_filter_limits() {
+        assert_eq!(group(0, 0).filters(), [json!({ "type": "contract" })]);
+        assert_eq!(group(12, 1).filters().len(), 3);
+        assert_eq!(group(6, 6).filters().len(), 4);
+    }
+
+    #[test]
+    fn overlapping_groups_are_packed_once() {
+        let groups = Groups::new(
+            "http://localhost:8000",
+            vec![group(5, 1), group(5, 1), group(30, 0)],
+        )
+        .unwrap();
+        // One filter for the duplicated groups and six for the 30 IDs.
+        assert_eq!(groups.requests.len(), 2);
+        assert_eq!(groups.requests[0].len(), 5);
+        assert_eq!(groups.requests[1].len(), 2);
+    }
+}
@@ -0,0 +1,98 @@
+use std::{
+    io::{self, BufWriter, Write},
+    path::Path,
+    time::Duration,
+};
+
+use serde::{Deserialize, Serialize};
+
+use super::{Cmd, Error};
+use crate::rpc;
+
+/// How long to wait before polling again once there are no more events to fetch, roughly the
+/// time it takes for a new ledger to close.
+const POLL_INTERVAL: Duration = Duration::from_secs(5);
+
+/// Position in the event stream that following resumes from.
+#[derive(Serialize, Deserialize, Debug, Clone, PartialEq, Eq)]
+#[serde(rename_all = "snake_case")]
+enum Position {
+    StartLedger(u32),
+    Cursor(String),
+}
+
+impl Position {
+    fn to_start(&self) -> rpc::EventStart {
+        match self {
+            Position::StartLedger(ledger) => rpc::EventStart::Ledger(*ledger),
+            Position::Cursor(cursor) => rpc::EventStart::Cursor(cursor.clone()),
+        }
+    }
+}
+
+impl Cmd {
+    pub(super) async fn run_follow(&self) -> Result<(), Error> {
+        let source = self.connect().await?;
+
+        let checkpoint = self
+            .checkpoint
+            .as_deref()
+            .map(read_checkpoint)
+            .transpose()?;
+        let mut position = match (checkpoint.flatten(), self.start_ledger, &self.cursor) {
+            (Some(position), _, _) => position,
+            (None, Some(ledger), _) => Position::StartLedger(ledger),
+            (None, _, Some(cursor)) => Position::Cursor(cursor.clone()),
+            (None, None, None) => return Err(Error::MissingStartLedgerAndCursor),
+        };
+
+        let mut out = BufWriter::new(io::stdout());
+        loop {
+            let page = self.page(&source, position.to_start()).await?;
+            for event in &page.events {
+                self.write_event(&mut out, &source, event)?;
+            }
+            out.flush()?;
+
+            position = match (page.events.last(), position) {
+                (Some(event), _) => Position::Cursor(event.id.clone()),
+                // Nothing matched up to the latest ledger, so there is no need to scan those
+                // ledgers again.
+                (None, Position::StartLedger(_)) => Position::StartLedger(page.latest_ledger),
+                (None, cursor @ Position::Cursor(_)) => cursor,
+            };
+            if let Some(path) = &self.checkpoint {
+                write_checkpoint(path, &position)?;
+            }
+            if !page.more {
+                tokio::time::sleep(POLL_INTERVAL).await;
+            }
+        }
+    }
+}
+
+fn read_checkpoint(path: &Path) -> Result<Option<Position>, Error> {
+    let contents = match std::fs::read_to_string(path) {
+        Ok(contents) => contents,
+        Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(None),
+        Err(e) => return Err(e.into()),
+    };
+    serde_json::from_str(&contents)
+        .map(Some)
+        .map_err(|error| Error::InvalidCheckpoint {
+            path: path.to_path_buf(),
+            error,
+        })
+}
+
+/// Replaces the checkpoint atomically, so that an interrupted write never loses the position.
+fn write_checkpoint(path: &Path, position: &Position) -> Result<(), Error> {
+    let dir = match path.parent() {
+        Some(dir) if !dir.as_os_str().is_empty() => dir,
+        _ => Path::new("."),
+    };
+    let mut tmp = tempfile::NamedTempFile::new_in(dir)?;
+    serde_json::to_writer(&mut tmp, position)?;
+    tmp.persist(path).map_err(|e| e.error)?;
+    Ok(())
+}
@@ -2,6 +2,7 @@ use clap::arg;
 use std::path::PathBuf;
 
 use super::config;
+use crate::metrics;
 
 #[derive(Debug, clap::Args, Clone, Default)]
 #[group(skip)]
@@ -33,6 +34,10 @@ pub struct Args {
     /// Do not cache your simulations and transactions
     #[arg(long, env = "STELLAR_NO_CACHE")]
     pub no_cache: bool,
+
+    /// Print how long each phase of network commands took, and the resources of the transactions they sent, to stderr when the command finishes
+    #[arg(long, value_enum)]
+    pub metrics: Option<metrics::Format>,
 }
 
 #[derive(thiserror::Error, Debug)]
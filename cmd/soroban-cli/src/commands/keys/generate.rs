@@ -1,12 +1,29 @@
 use clap::{arg, command};
+use ed25519_dalek::SigningKey;
+use soroban_env_host::xdr::{
+    self, AccountEntry, AccountEntryExt, AccountEntryExtensionV1Ext, AccountId, CreateAccountOp,
+    LedgerKey, LedgerKeyAccount, Memo, MuxedAccount, Operation, OperationBody, Preconditions,
+    PublicKey, SequenceNumber, Transaction, TransactionExt, Uint256, VecM,
+};
 
-use crate::commands::network;
+use crate::{
+    commands::network::{self, Network},
+    rpc, signer,
+};
 
 use super::super::config::{
     locator,
     secret::{self, Secret},
 };
 
+/// Most operations a transaction can have.
+const MAX_OPS_PER_TX: usize = 100;
+/// Fee of each create account operation, in stroops.
+const BASE_FEE: usize = 100;
+/// Reserve in stroops the network requires an account to keep for itself and for each of its
+/// subentries, which RPC servers do not report.
+const BASE_RESERVE: i64 = 5_000_000;
+
 #[derive(thiserror::Error, Debug)]
 pub enum Error {
     #[error(transparent)]
@@ -15,6 +32,20 @@ pub enum Error {
     Secret(#[from] secret::Error),
     #[error(transparent)]
     Network(#[from] network::Error),
+    #[error(transparent)]
+    Rpc(#[from] rpc::Error),
+    #[error(transparent)]
+    Signer(#[from] signer::Error),
+    #[error(transparent)]
+    Xdr(#[from] xdr::Error),
+    #[error("creating {count} accounts needs {needed} stroops, but the first account can only spend {available} above its minimum balance; lower --count or --starting-balance")]
+    InsufficientBalance {
+        count: usize,
+        needed: i64,
+        available: i64,
+    },
+    #[error("--starting-balance times --count is too large")]
+    StartingBalanceTooLarge,
 }
 
 #[derive(Debug, clap::Parser, Clone)]
@@ -46,6 +77,14 @@ pub struct Cmd {
     #[arg(long, short = 'd', conflicts_with = "seed")]
     pub default_seed: bool,
 
+    /// Number of accounts to generate, at hd paths 0 to COUNT - 1 of the one seed phrase stored for the identity, picked with `--hd-path`. Unless `--no-fund`, the first is funded by friendbot and creates the others that do not exist yet, up to 100 per transaction. Friendbot funds the first with 10,000 XLM, so thousands of accounts need a lower `--starting-balance`
+    #[arg(long, default_value = "1", conflicts_with_all = ["as_secret", "hd_path"])]
+    pub count: usize,
+
+    /// Balance in stroops each account after the first is created with, when generating more than one. The first account pays for all of them and keeps its own minimum balance, so lower this to generate thousands of accounts
+    #[arg(long, default_value = "100000000")]
+    pub starting_balance: i64,
+
     #[command(flatten)]
     pub network: network::Args,
 }
@@ -64,8 +103,10 @@ impl Cmd {
         };
         self.config_locator.write_identity(&self.name, &secret)?;
         if !self.no_fund {
-            let addr = secret.public_key(self.hd_path)?;
             let network = self.network.get(&self.config_locator)?;
+            let addr = secret.public_key(self.hd_path)?;
+            // Friendbot refuses to fund an account twice, so generating the same identity again
+            // only warns.
             network
                 .fund_address(&addr)
                 .await
@@ -73,7 +114,178 @@ impl Cmd {
                     tracing::warn!("fund_address failed: {e}");
                 })
                 .unwrap_or_default();
+            if self.count > 1 {
+                let accounts = secret.public_keys(1..self.count)?;
+                create_accounts(
+                    &network,
+                    &secret.key_pair(None)?,
+                    &accounts,
+                    self.starting_balance,
+                )
+                .await?;
+            }
         }
         Ok(())
     }
 }
+
+/// Creates the `accounts` that do not exist yet with `starting_balance` each, funded by
+/// `funder`, in as few transactions as possible. The transactions are sent one after another, as
+/// an account can only have one in the queue of the network at a time.
+async fn create_accounts(
+    network: &Network,
+    funder: &SigningKey,
+    accounts: &[stellar_strkey::ed25519::PublicKey],
+    starting_balance: i64,
+) -> Result<(), Error> {
+    let client = network.rpc_client()?;
+    let source = funder.verifying_key().to_bytes();
+    let mut missing = Vec::with_capacity(accounts.len());
+    for batch in accounts.chunks(MAX_OPS_PER_TX) {
+        let existing = client
+            .get_full_ledger_entries(&batch.iter().map(account_key).collect::<Vec<_>>())
+            .await?
+            .entries
+            .into_iter()
+            .map(|entry| entry.key)
+            .collect::<Vec<_>>();
+        missing.extend(
+            batch
+                .iter()
+                .filter(|account| !existing.contains(&account_key(account))),
+        );
+    }
+    if missing.is_empty() {
+        return Ok(());
+    }
+
+    let funder_account = client
+        .get_account(&stellar_strkey::ed25519::PublicKey(source).to_string())
+        .await?;
+    let needed = i64::try_from(missing.len())
+        .ok()
+        .and_then(|n| n.checked_mul(starting_balance))
+        .and_then(|n| n.checked_add(i64::try_from(BASE_FEE * missing.len()).ok()?))
+        .ok_or(Error::StartingBalanceTooLarge)?;
+    let available = spendable_balance(&funder_account);
+    if needed > available {
+        return Err(Error::InsufficientBalance {
+            count: missing.len(),
+            needed,
+            available,
+        });
+    }
+
+    let mut sequence = funder_account.seq_num.0;
+    let mut created = 0;
+    for batch in missing.chunks(MAX_OPS_PER_TX) {
+        sequence += 1;
+        let tx = create_accounts_tx(source, sequence, batch, starting_balance)?;
+        let envelope = signer::sign_tx(funder, &tx, &network.network_passphrase)?;
+        client.send_transaction_polling(&envelope).await?;
+        created += batch.len();
+        tracing::info!("created {created} of {} accounts", missing.len());
+    }
+    Ok(())
+}
+
+/// The balance `account` can send, above the minimum balance of two base reserves plus one for
+/// each subentry it has and entry it sponsors, less the lumens it offers to sell.
+fn spendable_balance(account: &AccountEntry) -> i64 {
+    let (selling, sponsoring, sponsored) = match &account.ext {
+        AccountEntryExt::V0 => (0, 0, 0),
+        AccountEntryExt::V1(v1) => match &v1.ext {
+            AccountEntryExtensionV1Ext::V0 => (v1.liabilities.selling, 0, 0),
+            AccountEntryExtensionV1Ext::V2(v2) => {
+                (v1.liabilities.selling, v2.num_sponsoring, v2.num_sponsored)
+            }
+        },
+    };
+    let reserves =
+        2 + i64::from(account.num_sub_entries) + i64::from(sponsoring) - i64::from(sponsored);
+    account.balance - reserves * BASE_RESERVE - selling
+}
+
+fn account_key(account: &stellar_strkey::ed25519::PublicKey) -> LedgerKey {
+    LedgerKey::Account(LedgerKeyAccount {
+        account_id: account_id(account),
+    })
+}
+
+fn account_id(account: &stellar_strkey::ed25519::PublicKey) -> AccountId {
+    AccountId(PublicKey::PublicKeyTypeEd25519(Uint256(account.0)))
+}
+
+/// The transaction of `source` creating every account of `batch`.
+fn create_accounts_tx(
+    source: [u8; 32],
+    sequence: i64,
+    batch: &[stellar_strkey::ed25519::PublicKey],
+    starting_balance: i64,
+) -> Result<Transaction, Error> {
+    let operations = batch
+        .iter()
+        .map(|account| Operation {
+            source_account: None,
+            body: OperationBody::CreateAccount(CreateAccountOp {
+                destination: account_id(account),
+                starting_balance,
+            }),
+        })
+        .collect::<Vec<_>>();
+    Ok(Transaction {
+        source_account: MuxedAccount::Ed25519(Uint256(source)),
+        fee: u32::try_from(BASE_FEE * batch.len()).unwrap_or(u32::MAX),
+        seq_num: SequenceNumber(sequence),
+        cond: Preconditions::None,
+        memo: Memo::None,
+        operations: VecM::try_from(operations)?,
+        ext: TransactionExt::V0,
+    })
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn create_accounts_tx_has_an_operation_and_fee_per_account() {
+        let accounts = |count: usize| {
+            (0..count)
+                .map(|i| stellar_strkey::ed25519::PublicKey([u8::try_from(i % 256).unwrap(); 32]))
+                .collect::<Vec<_>>()
+        };
+        let batch = accounts(MAX_OPS_PER_TX);
+        let tx = create_accounts_tx([1; 32], 7, &batch, 10).unwrap();
+        assert_eq!(tx.seq_num, SequenceNumber(7));
+        assert_eq!(tx.fee, 100 * 100);
+        assert_eq!(tx.operations.len(), MAX_OPS_PER_TX);
+        let OperationBody::CreateAccount(op) = &tx.operations[3].body else {
+            panic!("expected a create account operation");
+        };
+        assert_eq!(op.destination, account_id(&batch[3]));
+        assert_eq!(op.starting_balance, 10);
+
+        // A transaction cannot have more operations than that.
+        assert!(create_accounts_tx([1; 32], 7, &accounts(MAX_OPS_PER_TX + 1), 10).is_err());
+    }
+
+    #[test]
+    fn spendable_balance_keeps_the_minimum_balance() {
+        let mut account = AccountEntry {
+            account_id: account_id(&stellar_strkey::ed25519::PublicKey([1; 32])),
+            balance: 100_000_000_000,
+            seq_num: SequenceNumber(1),
+            num_sub_entries: 0,
+            inflation_dest: None,
+            flags: 0,
+            home_domain: xdr::String32::default(),
+            thresholds: xdr::Thresholds([1, 0, 0, 0]),
+            signers: VecM::default(),
+            ext: AccountEntryExt::V0,
+        };
+        assert_eq!(spendable_balance(&account), 100_000_000_000 - 10_000_000);
+        account.num_sub_entries = 3;
+        assert_eq!(spendable_balance(&account), 100_000_000_000 - 25_000_000);
+    }
+}
@@ -1,7 +1,7 @@
-use std::str::FromStr;
+use std::{ffi::OsString, str::FromStr};
 
 use async_trait::async_trait;
-use clap::{command, error::ErrorKind, CommandFactory, FromArgMatches, Parser};
+use clap::{command, error::ErrorKind, Args, CommandFactory, FromArgMatches, Parser, Subcommand};
 
 pub mod cache;
 pub mod completion;
@@ -63,9 +63,35 @@ pub struct Root {
     pub cmd: Cmd,
 }
 
+/// Names of the subcommands of [`Root`], so they can be looked up without building the command
+/// tree.
+pub const SUBCOMMANDS: [&str; 9] = [
+    "completion",
+    "contract",
+    "events",
+    "keys",
+    "xdr",
+    "network",
+    "version",
+    "tx",
+    "cache",
+];
+
 impl Root {
     pub fn new() -> Result<Self, Error> {
-        Self::try_parse().map_err(|e| {
+        let args = std::env::args_os().collect::<Vec<_>>();
+        let name = subcommand_name(&args);
+        if let Some(root) = name.and_then(|name| Self::try_parse_lazy(name, &args)) {
+            return Ok(root);
+        }
+        // A name that is not a subcommand is most likely a plugin, which is run without building
+        // the command tree.
+        if name.is_some_and(|name| !SUBCOMMANDS.contains(&name))
+            && !args.iter().any(|s| s == "--list")
+        {
+            plugin::run()?;
+        }
+        Self::try_parse_from(&args).map_err(|e| {
             if std::env::args().any(|s| s == "--list") {
                 let plugins = plugin::list().unwrap_or_default();
                 if plugins.is_empty() {
@@ -85,6 +111,20 @@ impl Root {
         })
     }
 
+    /// Parses `args` with a command tree holding only the subcommand `name`, which is much
+    /// cheaper to build than the whole tree. `None` if that fails in any way, including for
+    /// `--help`, so that the whole tree is used for help and errors.
+    fn try_parse_lazy(name: &str, args: &[OsString]) -> Option<Self> {
+        let root = clap::Command::new("stellar")
+            .disable_help_subcommand(true)
+            .subcommand_required(true)
+            .subcommand(Cmd::command_for(name)?);
+        let mut matches = global::Args::augment_args(root)
+            .try_get_matches_from(args)
+            .ok()?;
+        Self::from_arg_matches_mut(&mut matches).ok()
+    }
+
     pub fn from_arg_matches<I, T>(itr: I) -> Result<Self, clap::Error>
     where
         I: IntoIterator<Item = T>,
@@ -116,6 +156,37 @@ impl FromStr for Root {
     }
 }
 
+/// The subcommand named in `args`, the first argument that is neither a global option nor the
+/// value of one.
+fn subcommand_name(args: &[OsString]) -> Option<&str> {
+    let globals = global::Args::augment_args(clap::Command::new("stellar"));
+    let takes_value = |arg: &clap::Arg| arg.get_action().takes_values();
+    let mut args = args.iter().skip(1);
+    while let Some(arg) = args.next() {
+        let arg = arg.to_str()?;
+        let Some(option) = arg.strip_prefix('-') else {
+            return Some(arg);
+        };
+        let value_follows = if let Some(long) = option.strip_prefix('-') {
+            globals
+                .get_arguments()
+                .any(|a| a.get_long() == Some(long) && takes_value(a))
+        } else {
+            // In a group of short options, as in `-qf <FILTER_LOGS>`, only the last one can take
+            // the next argument as its value.
+            option.chars().last().is_some_and(|c| {
+                globals
+                    .get_arguments()
+                    .any(|a| a.get_short() == Some(c) && takes_value(a))
+            })
+        };
+        if value_follows {
+            args.next();
+        }
+    }
+    None
+}
+
 #[derive(Parser, Debug)]
 pub enum Cmd {
     /// Print shell completion code for the specified shell.
@@ -144,6 +215,30 @@ pub enum Cmd {
     Cache(cache::Cmd),
 }
 
+impl Cmd {
+    /// The command of the subcommand `name` alone, without its help text, which is only needed
+    /// to parse it.
+    fn command_for(name: &str) -> Option<clap::Command> {
+        let subcommands = |cmd: clap::Command| cmd.subcommand_required(true);
+        Some(match name {
+            "completion" => completion::Cmd::augment_args(clap::Command::new("completion")),
+            "contract" => subcommands(contract::Cmd::augment_subcommands(clap::Command::new(
+                "contract",
+            ))),
+            "events" => events::Cmd::augment_args(clap::Command::new("events")),
+            "keys" => subcommands(keys::Cmd::augment_subcommands(clap::Command::new("keys"))),
+            "xdr" => stellar_xdr::cli::Root::augment_args(clap::Command::new("xdr")),
+            "network" => subcommands(network::Cmd::augment_subcommands(clap::Command::new(
+                "network",
+            ))),
+            "version" => version::Cmd::augment_args(clap::Command::new("version")),
+            "tx" => subcommands(tx::Cmd::augment_subcommands(clap::Command::new("tx"))),
+            "cache" => subcommands(cache::Cmd::augment_subcommands(clap::Command::new("cache"))),
+            _ => return None,
+        })
+    }
+}
+
 #[derive(thiserror::Error, Debug)]
 pub enum Error {
     // TODO: stop using Debug for displaying errors
@@ -178,3 +273,102 @@ pub trait NetworkRunnable {
         config: Option<&config::Args>,
     ) -> Result<Self::Result, Self::Error>;
 }
+
+#[cfg(test)]
+mod test {
+    use std::time::{Duration, Instant};
+
+    use super::*;
+
+    fn args(s: &str) -> Vec<OsString> {
+        s.split_whitespace().map(OsString::from).collect()
+    }
+
+    #[test]
+    fn subcommands_match_cmd() {
+        let names = Root::command()
+            .get_subcommands()
+            .map(|c| c.get_name().to_string())
+            .collect::<Vec<_>>();
+        assert_eq!(names, SUBCOMMANDS);
+        for name in SUBCOMMANDS {
+            assert!(Cmd::command_for(name).is_some(), "{name}");
+        }
+    }
+
+    #[test]
+    fn finds_subcommand_name() {
+        assert_eq!(subcommand_name(&args("stellar keys ls")), Some("keys"));
+        assert_eq!(
+            subcommand_name(&args("stellar -q --config-dir keys -f x network ls")),
+            Some("network")
+        );
+        assert_eq!(
+            subcommand_name(&args("stellar -qf x --config-dir=. tx send")),
+            Some("tx")
+        );
+        assert_eq!(subcommand_name(&args("stellar --list")), None);
+    }
+
+    #[test]
+    fn lazy_parse_matches_full_parse() {
+        for s in [
+            "stellar keys address alice",
+            "stellar -q network ls",
+            "stellar version",
+            "stellar -f soroban_cli=trace contract id asset --asset native",
+            "stellar contract invoke --id CA3D5KRYM6CB7OWQ6TWYRR3Z4T7GNZLKERYNZGGA5SOAOPIFY6YQGAXE -- hello --to world",
+        ] {
+            let args = args(s);
+            let name = subcommand_name(&args).unwrap();
+            let lazy = Root::try_parse_lazy(name, &args).expect(s);
+            let full = Root::try_parse_from(&args).unwrap();
+            assert_eq!(format!("{lazy:?}"), format!("{full:?}"), "{s}");
+        }
+        // Help and errors are left to the whole command tree.
+        for s in [
+            "stellar keys --help",
+            "stellar keys address --unknown",
+            "stellar keys",
+        ] {
+            let args = args(s);
+            assert!(Root::try_parse_lazy("keys", &args).is_none(), "{s}");
+        }
+    }
+
+    /// Median of the time taken by `runs` calls of `f`.
+    fn median_time(runs: usize, mut f: impl FnMut()) -> Duration {
+        let mut times = (0..runs)
+            .map(|_| {
+                let start = Instant::now();
+                f();
+                start.elapsed()
+            })
+            .collect::<Vec<_>>();
+        times.sort();
+        times[runs / 2]
+    }
+
+    /// Startup is mostly parsing for commands that do little work. Timing lazy parsing against
+    /// a full parse on the same machine, rather than against a fixed budget, catches a command
+    /// falling back to the whole tree on any machine and build profile.
+    #[test]
+    fn startup_commands_parse_lazily() {
+        const RUNS: usize = 11;
+        for s in ["stellar version", "stellar network ls", "stellar keys ls"] {
+            let args = args(s);
+            let name = subcommand_name(&args).expect(s);
+            assert!(Root::try_parse_lazy(name, &args).is_some(), "{s}");
+            let lazy = median_time(RUNS, || {
+                Root::try_parse_lazy(name, &args).unwrap();
+            });
+            let full = median_time(RUNS, || {
+                Root::try_parse_from(&args).unwrap();
+            });
+            assert!(
+                lazy * 3 <= full,
+                "`{s}` took {lazy:?} to parse lazily, more than a third of the {full:?} of a full parse"
+            );
+        }
+    }
+}
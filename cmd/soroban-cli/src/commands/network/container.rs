@@ -1,5 +1,6 @@
 pub(crate) mod logs;
 mod shared;
+pub(crate) mod snapshot;
 pub(crate) mod start;
 pub(crate) mod stop;
 
@@ -21,6 +22,8 @@ pub enum Cmd {
     /// By default, when starting a testnet container, without any optional arguments, it will run the equivalent of the following docker command:
     /// docker run --rm -p 8000:8000 --name stellar stellar/quickstart:testing --testnet --enable-soroban-rpc
     Start(start::Cmd),
+    /// Save the state of a running network container, to restore with `network container start --snapshot <NAME>`
+    Snapshot(snapshot::Cmd),
     /// Stop a network started with `network container start`. For example, if you ran `network container start local`, you can use `network container stop local` to stop it.
     Stop(stop::Cmd),
 }
@@ -33,6 +36,9 @@ pub enum Error {
     #[error(transparent)]
     Start(#[from] start::Error),
 
+    #[error(transparent)]
+    Snapshot(#[from] snapshot::Error),
+
     #[error(transparent)]
     Stop(#[from] stop::Error),
 }
@@ -42,6 +48,7 @@ impl Cmd {
         match &self {
             Cmd::Logs(cmd) => cmd.run().await?,
             Cmd::Start(cmd) => cmd.run().await?,
+            Cmd::Snapshot(cmd) => cmd.run().await?,
             Cmd::Stop(cmd) => cmd.run().await?,
         }
         Ok(())
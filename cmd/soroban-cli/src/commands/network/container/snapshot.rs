@@ -0,0 +1,157 @@
+use std::{
+    io,
+    path::{Path, PathBuf},
+};
+
+use bollard::{container::DownloadFromContainerOptions, Docker};
+use futures_util::TryStreamExt;
+use serde::{Deserialize, Serialize};
+use tokio::io::{AsyncReadExt, AsyncWriteExt};
+
+use crate::commands::{
+    config::data,
+    network::container::shared::{
+        connect_to_docker, Error as ConnectionError, Network, DOCKER_HOST_HELP,
+    },
+};
+
+/// Where the quickstart image keeps the state of its node, RPC server and databases.
+pub const STATE_DIR: &str = "/opt/stellar";
+
+/// Archives hold `STATE_DIR` itself, so they are restored into its parent.
+pub const STATE_DIR_PARENT: &str = "/opt";
+
+/// Size of the chunks an archive is read from disk in while it is uploaded.
+const UPLOAD_CHUNK_SIZE: usize = 1024 * 1024;
+
+#[derive(thiserror::Error, Debug)]
+pub enum Error {
+    #[error("⛔ ️Failed to connect to docker: {0}")]
+    ConnectionError(#[from] ConnectionError),
+
+    #[error("⛔ ️Failed to snapshot container: {0}")]
+    BollardErr(#[from] bollard::errors::Error),
+
+    #[error(transparent)]
+    Data(#[from] data::Error),
+
+    #[error(transparent)]
+    Io(#[from] io::Error),
+
+    #[error(transparent)]
+    Json(#[from] serde_json::Error),
+
+    #[error("⛔ ️Snapshot {name} of {network} not found, save one with `stellar network container snapshot {network} --name {name}`")]
+    NotFound { network: Network, name: String },
+}
+
+#[derive(Debug, clap::Parser, Clone)]
+pub struct Cmd {
+    /// Network of the container to snapshot
+    pub network: Network,
+
+    /// Name to save the snapshot as, to restore it with `network container start --snapshot <NAME>`
+    #[arg(long, default_value = "default")]
+    pub name: String,
+
+    #[arg(short = 'd', long, help = DOCKER_HOST_HELP, env = "DOCKER_HOST")]
+    pub docker_host: Option<String>,
+}
+
+/// What a snapshot was taken from, saved next to the archive of the state.
+#[derive(Serialize, Deserialize, Debug)]
+pub struct Snapshot {
+    /// The image of the container, whose node and RPC server wrote the state.
+    pub image: String,
+}
+
+impl Cmd {
+    pub async fn run(&self) -> Result<(), Error> {
+        let container_name = format!("stellar-{}", self.network);
+        let docker = connect_to_docker(&self.docker_host).await?;
+        let image = docker
+            .inspect_container(&container_name, None)
+            .await?
+            .config
+            .and_then(|config| config.image)
+            .unwrap_or_default();
+        println!(
+            "ℹ️  Saving snapshot {} of container: {container_name}",
+            self.name
+        );
+        let (archive, meta) = paths(&self.network, &self.name)?;
+        // Paused so that the databases are copied as of a single point in time.
+        docker.pause_container(&container_name).await?;
+        let res = download(&docker, &container_name, &archive).await;
+        docker.unpause_container(&container_name).await?;
+        res?;
+        std::fs::write(meta, serde_json::to_vec(&Snapshot { image })?)?;
+        println!("✅ Snapshot saved: {}", archive.display());
+        Ok(())
+    }
+}
+
+/// Downloads the state of the container to `path`, replacing any earlier snapshot only once the
+/// download is complete.
+async fn download(docker: &Docker, container_name: &str, path: &Path) -> Result<(), Error> {
+    let partial = path.with_extension("tar.partial");
+    let mut file = tokio::fs::File::create(&partial).await?;
+    let mut archive = docker.download_from_container(
+        container_name,
+        Some(DownloadFromContainerOptions { path: STATE_DIR }),
+    );
+    while let Some(chunk) = archive.try_next().await? {
+        file.write_all(&chunk).await?;
+    }
+    file.sync_all().await?;
+    tokio::fs::rename(&partial, path).await?;
+    Ok(())
+}
+
+/// The archive of the snapshot `name` of `network`, and what it was taken from.
+fn paths(network: &Network, name: &str) -> Result<(PathBuf, PathBuf), Error> {
+    let dir = data::snapshot_dir()?;
+    Ok((
+        dir.join(format!("{network}-{name}.tar")),
+        dir.join(format!("{network}-{name}.json")),
+    ))
+}
+
+/// Opens the snapshot `name` of `network`: the archive of the state, streamed from disk as the
+/// body is read, and what it was taken from.
+pub async fn read(network: &Network, name: &str) -> Result<(hyper::Body, Snapshot), Error> {
+    let (archive, meta) = paths(network, name)?;
+    let meta = match tokio::fs::read(meta).await {
+        Ok(meta) => meta,
+        Err(e) if e.kind() == io::ErrorKind::NotFound => {
+            return Err(Error::NotFound {
+                network: network.clone(),
+                name: name.to_string(),
+            })
+        }
+        Err(e) => return Err(e.into()),
+    };
+    let meta = serde_json::from_slice(&meta)?;
+    let mut file = tokio::fs::File::open(archive).await?;
+    let (mut sender, body) = hyper::Body::channel();
+    tokio::spawn(async move {
+        let mut chunk = vec![0; UPLOAD_CHUNK_SIZE];
+        loop {
+            match file.read(&mut chunk).await {
+                Ok(0) => break,
+                Ok(n) => {
+                    let data = hyper::body::Bytes::copy_from_slice(&chunk[..n]);
+                    if sender.send_data(data).await.is_err() {
+                        break;
+                    }
+                }
+                Err(e) => {
+                    tracing::error!("reading snapshot: {e}");
+                    sender.abort();
+                    break;
+                }
+            }
+        }
+    });
+    Ok((body, meta))
+}
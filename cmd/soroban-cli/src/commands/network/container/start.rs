@@ -1,19 +1,29 @@
-use std::collections::HashMap;
+use std::{
+    collections::HashMap,
+    time::{Duration, Instant},
+};
 
 use bollard::{
-    container::{Config, CreateContainerOptions, StartContainerOptions},
+    container::{Config, CreateContainerOptions, StartContainerOptions, UploadToContainerOptions},
     image::CreateImageOptions,
     service::{HostConfig, PortBinding},
 };
 use futures_util::TryStreamExt;
 
-use crate::commands::network::container::shared::{
-    connect_to_docker, Error as ConnectionError, Network, DOCKER_HOST_HELP,
+use crate::commands::network::container::{
+    shared::{connect_to_docker, Error as ConnectionError, Network, DOCKER_HOST_HELP},
+    snapshot,
 };
 
 const DEFAULT_PORT_MAPPING: &str = "8000:8000";
 const DOCKER_IMAGE: &str = "docker.io/stellar/quickstart";
 
+/// Port of the container serving RPC, and friendbot for the local network.
+const CONTAINER_PORT: &str = "8000";
+
+/// How often the readiness of the network is checked while waiting for it.
+const READY_POLL_INTERVAL: Duration = Duration::from_secs(1);
+
 #[derive(thiserror::Error, Debug)]
 pub enum Error {
     #[error("⛔ ️Failed to connect to docker: {0}")]
@@ -21,6 +31,12 @@ pub enum Error {
 
     #[error("⛔ ️Failed to create container: {0}")]
     BollardErr(#[from] bollard::errors::Error),
+
+    #[error(transparent)]
+    Snapshot(#[from] snapshot::Error),
+
+    #[error("⛔ ️Network was not ready after {timeout} seconds, see its logs with `stellar network container logs {network}`")]
+    NotReady { network: Network, timeout: u64 },
 }
 
 #[derive(Debug, clap::Parser, Clone)]
@@ -46,6 +62,18 @@ pub struct Cmd {
     /// Optional argument to specify the protocol version for the local network only
     #[arg(short = 'v', long)]
     pub protocol_version: Option<String>,
+
+    /// Restore the state saved with `network container snapshot --name <SNAPSHOT>`, instead of starting a new chain
+    #[arg(long)]
+    pub snapshot: Option<String>,
+
+    /// Wait until the RPC server reports it is healthy, and friendbot answers for the local network
+    #[arg(long)]
+    pub wait: bool,
+
+    /// Seconds to wait for the network to be ready with `--wait`
+    #[arg(long, default_value = "300", requires = "wait")]
+    pub wait_timeout: u64,
 }
 
 impl Cmd {
@@ -58,7 +86,21 @@ impl Cmd {
 async fn run_docker_command(cmd: &Cmd) -> Result<(), Error> {
     let docker = connect_to_docker(&cmd.docker_host).await?;
 
-    let image = get_image_name(cmd);
+    let snapshot = match &cmd.snapshot {
+        Some(name) => Some(snapshot::read(&cmd.network, name).await?),
+        None => None,
+    };
+    let mut image = get_image_name(cmd);
+    if let Some((_, snapshot)) = &snapshot {
+        // The state can only be read by the node and RPC server that wrote it.
+        if snapshot.image != image {
+            println!(
+                "ℹ️  Using the image the snapshot was taken from: {}",
+                snapshot.image
+            );
+            image = snapshot.image.clone();
+        }
+    }
     docker
         .create_image(
             Some(CreateImageOptions {
@@ -98,6 +140,19 @@ async fn run_docker_command(cmd: &Cmd) -> Result<(), Error> {
         )
         .await?;
 
+    if let Some((archive, _)) = snapshot {
+        docker
+            .upload_to_container(
+                &create_container_response.id,
+                Some(UploadToContainerOptions {
+                    path: snapshot::STATE_DIR_PARENT,
+                    ..Default::default()
+                }),
+                archive,
+            )
+            .await?;
+    }
+
     docker
         .start_container(
             &create_container_response.id,
@@ -116,9 +171,87 @@ async fn run_docker_command(cmd: &Cmd) -> Result<(), Error> {
     );
 
     println!("{stop_message}");
+    if cmd.wait {
+        wait_until_ready(cmd).await?;
+        println!("✅ Network ready: {}", &cmd.network);
+    }
     Ok(())
 }
 
+/// Waits until the RPC server of the container reports it is healthy and, for the local network,
+/// friendbot answers, checking every `READY_POLL_INTERVAL` up to `cmd.wait_timeout` seconds.
+async fn wait_until_ready(cmd: &Cmd) -> Result<(), Error> {
+    let base = format!(
+        "http://{}:{}",
+        published_host(cmd.docker_host.as_deref()),
+        get_host_port(cmd)
+    );
+    let rpc_url = format!("{base}/soroban/rpc");
+    let friendbot_url = format!("{base}/friendbot");
+    let deadline = Instant::now() + Duration::from_secs(cmd.wait_timeout);
+    let client = hyper::Client::new();
+    println!("ℹ️  Waiting for the network to be ready");
+    loop {
+        let ready = rpc_is_healthy(&client, &rpc_url).await
+            && (cmd.network != Network::Local || friendbot_answers(&client, &friendbot_url).await);
+        if ready {
+            return Ok(());
+        }
+        if Instant::now() >= deadline {
+            return Err(Error::NotReady {
+                network: cmd.network.clone(),
+                timeout: cmd.wait_timeout,
+            });
+        }
+        tokio::time::sleep(READY_POLL_INTERVAL).await;
+    }
+}
+
+/// The host the ports of containers are published on: the one docker is reached at over the
+/// network, or this machine when it is reached through a socket.
+fn published_host(docker_host: Option<&str>) -> String {
+    docker_host
+        .and_then(|host| host.parse::<http::Uri>().ok())
+        .filter(|uri| matches!(uri.scheme_str(), Some("tcp" | "http" | "https")))
+        .and_then(|uri| uri.host().map(str::to_string))
+        .unwrap_or_else(|| "localhost".to_string())
+}
+
+async fn rpc_is_healthy(client: &hyper::Client<hyper::client::HttpConnector>, url: &str) -> bool {
+    let Ok(request) = hyper::Request::post(url)
+        .header("content-type", "application/json")
+        .body(hyper::Body::from(
+            r#"{"jsonrpc":"2.0","id":1,"method":"getHealth"}"#,
+        ))
+    else {
+        return false;
+    };
+    let Ok(response) = client.request(request).await else {
+        return false;
+    };
+    let Ok(body) = hyper::body::to_bytes(response.into_body()).await else {
+        return false;
+    };
+    serde_json::from_slice::<serde_json::Value>(&body).is_ok_and(|health| {
+        tracing::debug!("{health}");
+        health["result"]["status"] == "healthy"
+    })
+}
+
+/// Friendbot answers requests without an address with a client error once it is up.
+async fn friendbot_answers(
+    client: &hyper::Client<hyper::client::HttpConnector>,
+    url: &str,
+) -> bool {
+    let Ok(uri) = url.parse() else {
+        return false;
+    };
+    client
+        .get(uri)
+        .await
+        .is_ok_and(|response| !response.status().is_server_error())
+}
+
 fn get_container_args(cmd: &Cmd) -> Vec<String> {
     [
         format!("--{}", cmd.network),
@@ -168,6 +301,17 @@ fn get_port_mapping(cmd: &Cmd) -> HashMap<String, Option<Vec<PortBinding>>> {
     port_mapping_hash
 }
 
+/// The host port mapped to the port of the container serving RPC.
+fn get_host_port(cmd: &Cmd) -> &str {
+    cmd.ports_mapping
+        .iter()
+        .find_map(|mapping| match mapping.split_once(':') {
+            Some((host_port, CONTAINER_PORT)) => Some(host_port),
+            _ => None,
+        })
+        .unwrap_or(CONTAINER_PORT)
+}
+
 fn get_protocol_version_arg(cmd: &Cmd) -> String {
     if cmd.network == Network::Local && cmd.protocol_version.is_some() {
         let version = cmd.protocol_version.as_ref().unwrap();
@@ -185,3 +329,26 @@ fn get_limits_arg(cmd: &Cmd) -> String {
         String::new()
     }
 }
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn ports_are_published_on_the_docker_host() {
+        assert_eq!(published_host(None), "localhost");
+        assert_eq!(
+            published_host(Some("unix:///var/run/docker.sock")),
+            "localhost"
+        );
+        assert_eq!(
+            published_host(Some("npipe:////./pipe/docker_engine")),
+            "localhost"
+        );
+        assert_eq!(published_host(Some("tcp://10.0.0.5:2375")), "10.0.0.5");
+        assert_eq!(
+            published_host(Some("https://docker.example.com:2376")),
+            "docker.example.com"
+        );
+    }
+}
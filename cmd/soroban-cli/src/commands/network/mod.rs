@@ -1,4 +1,8 @@
-use std::str::FromStr;
+use std::{
+    fmt,
+    str::FromStr,
+    sync::{Arc, Mutex, PoisonError},
+};
 
 use clap::{arg, Parser};
 use serde::{Deserialize, Serialize};
@@ -143,13 +147,19 @@ pub struct Args {
         help_heading = HEADING_RPC,
     )]
     pub network: Option<String>,
+    /// Client shared by every network resolved from these arguments.
+    #[arg(skip)]
+    pub client: SharedClient,
 }
 
 impl Args {
     pub fn get(&self, locator: &locator::Args) -> Result<Network, Error> {
         if let Some(name) = self.network.as_deref() {
             if let Ok(network) = locator.read_network(name) {
-                return Ok(network);
+                return Ok(Network {
+                    client: self.client.clone(),
+                    ..network
+                });
             }
         }
         if let (Some(rpc_url), Some(network_passphrase)) =
@@ -158,6 +168,7 @@ impl Args {
             Ok(Network {
                 rpc_url,
                 network_passphrase,
+                client: self.client.clone(),
             })
         } else {
             Err(Error::Network)
@@ -182,9 +193,38 @@ pub struct Network {
             help_heading = HEADING_RPC,
         )]
     pub network_passphrase: String,
+    #[arg(skip)]
+    #[serde(skip)]
+    client: SharedClient,
+}
+
+/// The RPC client of one command, created on first use and shared by the networks it resolves
+/// so that connections to the server are reused. It is not shared across commands, as its
+/// connections must not outlive the async runtime they were opened on.
+#[derive(Clone, Default)]
+pub struct SharedClient(Arc<Mutex<Option<(String, Arc<Client>)>>>);
+
+impl fmt::Debug for SharedClient {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str("SharedClient")
+    }
 }
 
 impl Network {
+    /// Returns the RPC client for this network, created on first use and shared with the other
+    /// networks resolved from the same arguments.
+    pub fn rpc_client(&self) -> Result<Arc<Client>, rpc::Error> {
+        let mut shared = self.client.0.lock().unwrap_or_else(PoisonError::into_inner);
+        if let Some((rpc_url, client)) = shared.as_ref() {
+            if *rpc_url == self.rpc_url {
+                return Ok(client.clone());
+            }
+        }
+        let client = Arc::new(Client::new(&self.rpc_url)?);
+        *shared = Some((self.rpc_url.clone(), client.clone()));
+        Ok(client)
+    }
+
     pub async fn helper_url(&self, addr: &str) -> Result<http::Uri, Error> {
         use http::Uri;
         tracing::debug!("address {addr:?}");
@@ -199,7 +239,7 @@ impl Network {
                 .path_and_query(format!("/friendbot?addr={addr}"))
                 .build()?)
         } else {
-            let client = Client::new(&self.rpc_url)?;
+            let client = self.rpc_client()?;
             let network = client.get_network().await?;
             tracing::debug!("network {network:?}");
             let uri = client.friendbot_url().await?;
@@ -252,6 +292,7 @@ impl Network {
         Network {
             rpc_url: "https://rpc-futurenet.stellar.org:443".to_owned(),
             network_passphrase: "Test SDF Future Network ; October 2022".to_owned(),
+            client: SharedClient::default(),
         }
     }
 }
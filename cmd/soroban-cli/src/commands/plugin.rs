@@ -1,9 +1,8 @@
 use std::process::Command;
 
-use clap::CommandFactory;
 use which::which;
 
-use crate::{utils, Root};
+use crate::{commands::SUBCOMMANDS, utils};
 
 #[derive(thiserror::Error, Debug)]
 pub enum Error {
@@ -36,8 +35,7 @@ pub fn run() -> Result<(), Error> {
         (name, args)
     };
 
-    if Root::command().get_subcommands().any(|c| {
-        let sc_name = c.get_name();
+    if SUBCOMMANDS.iter().any(|sc_name| {
         sc_name.starts_with(&name)
             || (name.len() >= MIN_LENGTH && strsim::jaro(sc_name, &name) >= SUBCOMMAND_TOLERANCE)
     }) {
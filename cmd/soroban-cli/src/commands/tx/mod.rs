@@ -2,13 +2,19 @@ use clap::Parser;
 
 use super::global;
 
+pub mod send;
 pub mod simulate;
+pub mod wait;
 pub mod xdr;
 
 #[derive(Debug, Parser)]
 pub enum Cmd {
-    /// Simulate a transaction envelope from stdin
+    /// Simulate transaction envelopes from stdin
     Simulate(simulate::Cmd),
+    /// Send signed transaction envelopes from stdin
+    Send(send::Cmd),
+    /// Wait for sent transactions to be applied
+    Wait(wait::Cmd),
 }
 
 #[derive(thiserror::Error, Debug)]
@@ -16,12 +22,20 @@ pub enum Error {
     /// An error during the simulation
     #[error(transparent)]
     Simulate(#[from] simulate::Error),
+    /// An error sending the transactions
+    #[error(transparent)]
+    Send(#[from] send::Error),
+    /// An error waiting for the transactions
+    #[error(transparent)]
+    Wait(#[from] wait::Error),
 }
 
 impl Cmd {
     pub async fn run(&self, global_args: &global::Args) -> Result<(), Error> {
         match self {
             Cmd::Simulate(cmd) => cmd.run(global_args).await?,
+            Cmd::Send(cmd) => cmd.run(global_args).await?,
+            Cmd::Wait(cmd) => cmd.run(global_args).await?,
         };
         Ok(())
     }
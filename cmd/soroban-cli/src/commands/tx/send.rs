@@ -0,0 +1,74 @@
+use futures_util::StreamExt;
+
+use crate::{
+    commands::{
+        config::{self, data},
+        global,
+    },
+    rpc,
+};
+
+use super::wait;
+
+#[derive(thiserror::Error, Debug)]
+pub enum Error {
+    #[error(transparent)]
+    XdrArgs(#[from] super::xdr::Error),
+    #[error(transparent)]
+    Config(#[from] config::Error),
+    #[error(transparent)]
+    Network(#[from] super::super::network::Error),
+    #[error(transparent)]
+    Data(#[from] data::Error),
+    #[error(transparent)]
+    Rpc(#[from] rpc::Error),
+    #[error(transparent)]
+    Wait(#[from] wait::Error),
+}
+
+/// Command to send signed transaction envelopes via rpc, one per line of stdin, waiting for them
+/// to be applied
+/// e.g. `cat file.txt | soroban tx send`
+#[derive(Debug, clap::Parser, Clone, Default)]
+#[group(skip)]
+pub struct Cmd {
+    /// Print the hash of each transaction once the server accepts it, without waiting for it to be applied. The hashes are recorded as pending, for `tx wait` to confirm
+    #[arg(long = "async")]
+    pub is_async: bool,
+
+    #[command(flatten)]
+    pub wait: wait::Args,
+
+    #[command(flatten)]
+    pub config: config::Args,
+}
+
+impl Cmd {
+    pub async fn run(&self, global_args: &global::Args) -> Result<(), Error> {
+        let network = self.config.get_network()?;
+        let client = network.rpc_client()?;
+        let rpc_uri = network.rpc_uri()?;
+        let mut tx_envs = std::pin::pin!(super::xdr::tx_envelopes_from_stdin());
+        let mut hashes = Vec::new();
+        // Sent one after another, as transactions of the same account are only accepted in the
+        // order of their sequence numbers.
+        while let Some(tx_env) = tx_envs.next().await {
+            let hash = client.send_transaction(&tx_env?).await?;
+            if self.is_async {
+                let hash = hex::encode(hash.0);
+                println!("{hash}");
+                if !global_args.no_cache {
+                    data::write(data::Action::Pending { hash }, &rpc_uri)?;
+                }
+            } else {
+                hashes.push(hash);
+            }
+        }
+        if !self.is_async {
+            self.wait
+                .wait_and_print(&client, &network, hashes, global_args)
+                .await?;
+        }
+        Ok(())
+    }
+}
@@ -1,8 +1,7 @@
 use crate::xdr::{self, TransactionEnvelope, WriteXdr};
-use async_trait::async_trait;
-use soroban_rpc::Assembled;
+use futures_util::StreamExt;
 
-use crate::commands::{config, global, NetworkRunnable};
+use crate::commands::{config::data, global};
 
 #[derive(thiserror::Error, Debug)]
 pub enum Error {
@@ -14,9 +13,17 @@ pub enum Error {
     Rpc(#[from] crate::rpc::Error),
     #[error(transparent)]
     Xdr(#[from] xdr::Error),
+    #[error(transparent)]
+    Network(#[from] super::super::network::Error),
+    #[error(transparent)]
+    Data(#[from] data::Error),
 }
 
-/// Command to simulate a transaction envelope via rpc
+/// Number of transactions being simulated at once.
+const MAX_SIMULATIONS_IN_FLIGHT: usize = 10;
+
+/// Command to simulate transaction envelopes via rpc, one per line of stdin, printing the
+/// assembled envelopes in the same order
 /// e.g. `cat file.txt | soroban tx simulate`
 #[derive(Debug, clap::Parser, Clone, Default)]
 #[group(skip)]
@@ -27,29 +34,29 @@ pub struct Cmd {
 
 impl Cmd {
     pub async fn run(&self, global_args: &global::Args) -> Result<(), Error> {
-        let res = self
-            .run_against_rpc_server(Some(global_args), Some(&self.config))
-            .await?;
-        let tx_env: TransactionEnvelope = res.transaction().clone().into();
-        println!("{}", tx_env.to_xdr_base64(xdr::Limits::none())?);
+        let network = self.config.get_network()?;
+        let client = network.rpc_client()?;
+        let rpc_uri = network.rpc_uri()?;
+        let client = &client;
+        let mut assembled = std::pin::pin!(super::xdr::tx_envelopes_from_stdin()
+            .map(|tx_env| async move {
+                let tx = super::xdr::unwrap_envelope_v1(tx_env?)?;
+                Ok::<_, Error>(client.simulate_and_assemble_transaction(&tx).await?)
+            })
+            .buffered(MAX_SIMULATIONS_IN_FLIGHT));
+        let mut simulated = 0;
+        while let Some(res) = assembled.next().await {
+            let res = res?;
+            if !global_args.no_cache {
+                data::write(res.sim_response().clone().into(), &rpc_uri)?;
+            }
+            let tx_env: TransactionEnvelope = res.transaction().clone().into();
+            println!("{}", tx_env.to_xdr_base64(xdr::Limits::none())?);
+            simulated += 1;
+        }
+        if simulated == 0 {
+            return Err(super::xdr::Error::StdinDecode.into());
+        }
         Ok(())
     }
 }
-
-#[async_trait]
-impl NetworkRunnable for Cmd {
-    type Error = Error;
-
-    type Result = Assembled;
-    async fn run_against_rpc_server(
-        &self,
-        _: Option<&global::Args>,
-        config: Option<&config::Args>,
-    ) -> Result<Self::Result, Self::Error> {
-        let config = config.unwrap_or(&self.config);
-        let network = config.get_network()?;
-        let client = crate::rpc::Client::new(&network.rpc_url)?;
-        let tx = super::xdr::unwrap_envelope_v1(super::xdr::tx_envelope_from_stdin()?)?;
-        Ok(client.simulate_and_assemble_transaction(&tx).await?)
-    }
-}
@@ -0,0 +1,276 @@
+use std::time::{Duration, Instant};
+
+use futures_util::{stream, StreamExt};
+
+use crate::{
+    commands::{
+        config::{self, data},
+        global,
+    },
+    rpc::{self, GetTransactionResponseRaw},
+    xdr::Hash,
+};
+
+#[derive(thiserror::Error, Debug)]
+pub enum Error {
+    #[error(transparent)]
+    Config(#[from] config::Error),
+    #[error(transparent)]
+    Network(#[from] super::super::network::Error),
+    #[error(transparent)]
+    Data(#[from] data::Error),
+    #[error(transparent)]
+    Rpc(#[from] rpc::Error),
+    #[error("invalid transaction hash {0}")]
+    InvalidHash(String),
+    #[error("{failed} of {total} transactions failed")]
+    Failed { failed: usize, total: usize },
+    #[error("{pending} of {total} transactions are still pending")]
+    TimedOut { pending: usize, total: usize },
+}
+
+/// Ledgers close about this often, used until the close time of the network has been observed.
+const DEFAULT_CLOSE_TIME: Duration = Duration::from_secs(5);
+
+/// Shortest wait between two rounds of status queries.
+const MIN_POLL_INTERVAL: Duration = Duration::from_millis(250);
+
+/// How long after a ledger is expected to close its transactions are queried, leaving time for
+/// the RPC server to ingest it.
+const INGEST_MARGIN: Duration = Duration::from_millis(250);
+
+/// Status queries sent at once.
+const MAX_QUERIES_IN_FLIGHT: usize = 16;
+
+#[derive(Debug, clap::Args, Clone, Default)]
+#[group(skip)]
+pub struct Args {
+    /// Seconds to wait for transactions to be applied
+    #[arg(long, default_value = "30")]
+    pub timeout: u64,
+}
+
+/// Wait for transactions to be applied, printing the hash and status of each
+#[derive(Debug, clap::Parser, Clone, Default)]
+#[group(skip)]
+pub struct Cmd {
+    /// Hex encoded hashes of the transactions. Default: the transactions sent with `tx send --async` that are still pending
+    pub hashes: Vec<String>,
+
+    #[command(flatten)]
+    pub wait: Args,
+
+    #[command(flatten)]
+    pub config: config::Args,
+}
+
+impl Cmd {
+    pub async fn run(&self, global_args: &global::Args) -> Result<(), Error> {
+        let network = self.config.get_network()?;
+        let hashes = if self.hashes.is_empty() {
+            data::pending_hashes(&network.rpc_uri()?)?
+        } else {
+            self.hashes.clone()
+        };
+        let hashes = hashes
+            .iter()
+            .map(|hash| parse_hash(hash))
+            .collect::<Result<Vec<_>, _>>()?;
+        self.wait
+            .wait_and_print(&network.rpc_client()?, &network, hashes, global_args)
+            .await
+    }
+}
+
+impl Args {
+    /// Waits for the transactions `hashes`, printing the hash and status of each once known,
+    /// and records them in the action log unless caching is off.
+    pub async fn wait_and_print(
+        &self,
+        client: &rpc::Client,
+        network: &super::super::network::Network,
+        hashes: Vec<Hash>,
+        global_args: &global::Args,
+    ) -> Result<(), Error> {
+        let total = hashes.len();
+        let rpc_uri = network.rpc_uri()?;
+        let mut failed = 0;
+        let mut cache_error = None;
+        let pending = wait_all(
+            client,
+            hashes,
+            Duration::from_secs(self.timeout),
+            |hash, response| {
+                let hash = hex::encode(hash.0);
+                println!("{hash} {}", response.status);
+                if response.status != "SUCCESS" {
+                    failed += 1;
+                }
+                if !global_args.no_cache && cache_error.is_none() {
+                    let action = data::Action::Send {
+                        response,
+                        hash: Some(hash),
+                    };
+                    cache_error = data::write(action, &rpc_uri).err();
+                }
+            },
+        )
+        .await;
+        for hash in &pending {
+            println!("{} PENDING", hex::encode(hash.0));
+        }
+        if let Some(e) = cache_error {
+            return Err(e.into());
+        }
+        if !pending.is_empty() {
+            return Err(Error::TimedOut {
+                pending: pending.len(),
+                total,
+            });
+        }
+        if failed > 0 {
+            return Err(Error::Failed { failed, total });
+        }
+        Ok(())
+    }
+}
+
+pub fn parse_hash(hash: &str) -> Result<Hash, Error> {
+    hex::decode(hash)
+        .ok()
+        .and_then(|bytes| bytes.try_into().ok())
+        .map(Hash)
+        .ok_or_else(|| Error::InvalidHash(hash.to_string()))
+}
+
+/// Waits for every transaction in `hashes` to be applied, calling `done` with each as soon as
+/// its outcome is known, until `timeout`. Returns the transactions still pending.
+///
+/// Transactions are only applied when a ledger closes, so after the first round their statuses
+/// are only queried again once the latest ledger has moved on. Rounds are timed to shortly
+/// after the next ledger is expected to close, going by the close times seen so far.
+pub async fn wait_all(
+    client: &rpc::Client,
+    mut hashes: Vec<Hash>,
+    timeout: Duration,
+    mut done: impl FnMut(&Hash, GetTransactionResponseRaw),
+) -> Vec<Hash> {
+    let deadline = Instant::now() + timeout;
+    let mut clock = LedgerClock::default();
+    let mut queried_at = None;
+    while !hashes.is_empty() {
+        match client.get_latest_ledger().await {
+            Ok(latest) => clock.observe(latest.sequence),
+            Err(e) => tracing::warn!("cannot get the latest ledger: {e}"),
+        }
+        if queried_at.is_none() || queried_at != clock.sequence() {
+            queried_at = clock.sequence();
+            let statuses = stream::iter(&hashes)
+                .map(|hash| async move { (hash.clone(), client.get_transaction(hash).await) })
+                .buffer_unordered(MAX_QUERIES_IN_FLIGHT)
+                .collect::<Vec<_>>()
+                .await;
+            for (hash, status) in statuses {
+                match status {
+                    Ok(response) if response.status != "NOT_FOUND" => {
+                        hashes.retain(|h| *h != hash);
+                        done(&hash, response);
+                    }
+                    Ok(_) => {}
+                    // Left pending and queried again, the server may only be briefly unavailable.
+                    Err(e) => tracing::warn!("cannot get transaction {}: {e}", hex::encode(hash.0)),
+                }
+            }
+        }
+        let now = Instant::now();
+        if hashes.is_empty() || now >= deadline {
+            break;
+        }
+        tokio::time::sleep(clock.next_poll().min(deadline - now)).await;
+    }
+    hashes
+}
+
+/// Estimates when ledgers close from the changes of the latest ledger.
+#[derive(Default)]
+struct LedgerClock {
+    latest: Option<u32>,
+    /// The first and the latest change of the latest ledger seen, with when they were seen.
+    first_change: Option<(Instant, u32)>,
+    last_change: Option<(Instant, u32)>,
+    /// Rounds in a row the latest ledger did not change.
+    unchanged: u32,
+}
+
+impl LedgerClock {
+    fn observe(&mut self, sequence: u32) {
+        match self.latest {
+            Some(latest) if latest >= sequence => self.unchanged += 1,
+            Some(_) => {
+                let change = (Instant::now(), sequence);
+                self.first_change.get_or_insert(change);
+                self.last_change = Some(change);
+                self.unchanged = 0;
+                self.latest = Some(sequence);
+            }
+            None => self.latest = Some(sequence),
+        }
+    }
+
+    fn sequence(&self) -> Option<u32> {
+        self.latest
+    }
+
+    /// Average time between the ledger changes seen, or the usual close time before there are
+    /// two.
+    fn close_time(&self) -> Duration {
+        match (self.first_change, self.last_change) {
+            (Some((first_at, first)), Some((last_at, last))) if last > first => {
+                ((last_at - first_at) / (last - first))
+                    .clamp(MIN_POLL_INTERVAL, DEFAULT_CLOSE_TIME * 2)
+            }
+            _ => DEFAULT_CLOSE_TIME,
+        }
+    }
+
+    /// How long to wait before the next round: until shortly after the next ledger is expected
+    /// to close or, when that is unknown or overdue, a backoff growing up to the close time.
+    fn next_poll(&self) -> Duration {
+        let close_time = self.close_time();
+        let expected = self
+            .last_change
+            .map(|(at, _)| at + close_time + INGEST_MARGIN)
+            .and_then(|expected| expected.checked_duration_since(Instant::now()));
+        expected
+            .unwrap_or_else(|| MIN_POLL_INTERVAL * 2u32.pow(self.unchanged.min(8)))
+            .clamp(MIN_POLL_INTERVAL, close_time + INGEST_MARGIN)
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn polls_after_expected_close() {
+        let mut clock = LedgerClock::default();
+        assert_eq!(clock.close_time(), DEFAULT_CLOSE_TIME);
+        clock.observe(10);
+        assert_eq!(clock.next_poll(), MIN_POLL_INTERVAL);
+        clock.observe(10);
+        clock.observe(10);
+        assert_eq!(clock.next_poll(), MIN_POLL_INTERVAL * 4);
+
+        // Right after a change, the next round waits for the next close.
+        clock.observe(11);
+        assert!(clock.next_poll() > DEFAULT_CLOSE_TIME);
+        assert_eq!(clock.sequence(), Some(11));
+    }
+
+    #[test]
+    fn parses_hashes() {
+        let hash = "ab".repeat(32);
+        assert_eq!(parse_hash(&hash).unwrap(), Hash([0xab; 32]));
+        assert!(parse_hash("abcd").is_err());
+    }
+}
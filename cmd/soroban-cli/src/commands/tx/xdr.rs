@@ -1,10 +1,9 @@
-use std::{
-    io::{stdin, Read},
-    path::PathBuf,
-};
+use std::path::PathBuf;
 
+use futures_util::{stream, Stream};
 use soroban_env_host::xdr::ReadXdr;
 use soroban_sdk::xdr::{Limits, Transaction, TransactionEnvelope, TransactionV1Envelope};
+use tokio::io::{AsyncBufReadExt, BufReader, Lines, Stdin};
 
 #[derive(Debug, thiserror::Error)]
 pub enum Error {
@@ -20,15 +19,28 @@ pub enum Error {
     OnlyTransactionV1Supported,
 }
 
-pub fn tx_envelope_from_stdin() -> Result<TransactionEnvelope, Error> {
-    from_stdin()
-}
-pub fn from_stdin<T: ReadXdr>() -> Result<T, Error> {
-    let mut buf = String::new();
-    let _ = stdin()
-        .read_to_string(&mut buf)
-        .map_err(|_| Error::StdinDecode)?;
-    T::from_xdr_base64(buf.trim(), Limits::none()).map_err(|_| Error::StdinDecode)
+/// Transaction envelopes read from stdin as they arrive, one base64 encoded envelope per line.
+/// Blank lines are skipped, and the stream ends after the first error.
+pub fn tx_envelopes_from_stdin() -> impl Stream<Item = Result<TransactionEnvelope, Error>> {
+    let lines = BufReader::new(tokio::io::stdin()).lines();
+    stream::unfold(
+        Some(lines),
+        |lines: Option<Lines<BufReader<Stdin>>>| async move {
+            let mut lines = lines?;
+            let line = loop {
+                match lines.next_line().await {
+                    Ok(Some(line)) if line.trim().is_empty() => {}
+                    Ok(Some(line)) => break line,
+                    Ok(None) => return None,
+                    Err(_) => return Some((Err(Error::StdinDecode), None)),
+                }
+            };
+            match TransactionEnvelope::from_xdr_base64(line.trim(), Limits::none()) {
+                Ok(tx_env) => Some((Ok(tx_env), Some(lines))),
+                Err(_) => Some((Err(Error::StdinDecode), None)),
+            }
+        },
+    )
 }
 
 pub fn unwrap_envelope_v1(tx_env: TransactionEnvelope) -> Result<Transaction, Error> {
@@ -26,26 +26,47 @@ pub struct Args {
 }
 
 impl Args {
+    /// Applies `--instructions`, if given. Otherwise the simulated instructions are kept, as
+    /// padding them also needs the resource fee raised, see [`pad_instructions`].
     pub fn apply_to_assembled_txn(&self, txn: Assembled) -> Assembled {
         if let Some(instructions) = self.instructions {
             txn.set_max_instructions(instructions)
         } else {
-            add_padding_to_instructions(txn)
+            txn
         }
     }
 }
 
-pub fn add_padding_to_instructions(txn: Assembled) -> Assembled {
+/// Instructions are charged per increment of this many, at the network's
+/// `fee_rate_per_instructions_increment`.
+const INSTRUCTIONS_INCREMENT: i64 = 10_000;
+
+/// Raises the instructions `tx` may use to `instructions`, adding what the extra instructions
+/// cost at `fee_rate` to its resource fee and to its fee. Does nothing if `tx` already has as
+/// many instructions.
+pub fn pad_instructions(tx: &mut xdr::Transaction, instructions: u32, fee_rate: i64) {
     let xdr::TransactionExt::V1(xdr::SorobanTransactionData {
-        resources: xdr::SorobanResources { instructions, .. },
+        resources,
+        resource_fee,
         ..
-    }) = txn.transaction().ext
+    }) = &mut tx.ext
+    else {
+        return;
+    };
+    let Some(extra) = instructions
+        .checked_sub(resources.instructions)
+        .filter(|extra| *extra > 0)
     else {
-        return txn;
+        return;
     };
-    // Start with 150%
-    let instructions = (instructions.checked_mul(150 / 100)).unwrap_or(instructions);
-    txn.set_max_instructions(instructions)
+    // Rounded up, the fee of the total is never more than the fees of its parts.
+    let extra_fee =
+        (i64::from(extra) * fee_rate + INSTRUCTIONS_INCREMENT - 1) / INSTRUCTIONS_INCREMENT;
+    resources.instructions = instructions;
+    *resource_fee += extra_fee;
+    tx.fee = tx
+        .fee
+        .saturating_add(u32::try_from(extra_fee).unwrap_or(u32::MAX));
 }
 
 impl Default for Args {
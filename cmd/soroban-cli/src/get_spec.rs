@@ -1,7 +1,9 @@
+use heck::ToKebabCase;
 use soroban_env_host::xdr;
 
 use soroban_env_host::xdr::{
-    ContractDataEntry, ContractExecutable, ScContractInstance, ScSpecEntry, ScVal,
+    ContractDataDurability, ContractDataEntry, ContractExecutable, Hash, LedgerEntryData,
+    LedgerKey, LedgerKeyContractData, ScAddress, ScContractInstance, ScSpecEntry, ScVal,
 };
 
 use soroban_spec::read::FromWasmError;
@@ -40,43 +42,139 @@ pub async fn get_remote_contract_spec(
     network: &network::Args,
     global_args: Option<&global::Args>,
     config: Option<&config::Args>,
+) -> Result<Vec<ScSpecEntry>, Error> {
+    get_remote_spec(contract_id, None, locator, network, global_args, config).await
+}
+
+/// Like [`get_remote_contract_spec`], but a spec read from the cache only includes `function`
+/// and the types it uses, matching its name or its kebab case alias. The whole spec is returned
+/// when the function is not in it, so that unknown functions can still be reported.
+///
+/// # Errors
+pub async fn get_remote_function_spec(
+    contract_id: &[u8; 32],
+    function: &str,
+    locator: &locator::Args,
+    network: &network::Args,
+    global_args: Option<&global::Args>,
+    config: Option<&config::Args>,
+) -> Result<Vec<ScSpecEntry>, Error> {
+    get_remote_spec(
+        contract_id,
+        Some(function),
+        locator,
+        network,
+        global_args,
+        config,
+    )
+    .await
+}
+
+async fn get_remote_spec(
+    contract_id: &[u8; 32],
+    function: Option<&str>,
+    locator: &locator::Args,
+    network: &network::Args,
+    global_args: Option<&global::Args>,
+    config: Option<&config::Args>,
 ) -> Result<Vec<ScSpecEntry>, Error> {
     let network = config.map_or_else(
         || network.get(locator).map_err(Error::from),
         |c| c.get_network().map_err(Error::from),
     )?;
     tracing::trace!(?network);
-    let client = rpc::Client::new(&network.rpc_url)?;
-    // Get contract data
-    let r = client.get_contract_data(contract_id).await?;
-    tracing::trace!("{r:?}");
+    let no_cache = global_args.is_some_and(|a| a.no_cache);
+    let client = network.rpc_client()?;
+    let contract = stellar_strkey::Contract(*contract_id).to_string();
 
-    let ContractDataEntry {
-        val: ScVal::ContractInstance(ScContractInstance { executable, .. }),
-        ..
-    } = r
-    else {
-        return Err(Error::MissingResult);
+    // The wasm hash of a contract only changes when it is upgraded, so it is cached until its
+    // instance may have expired, or until an invocation fails and invalidates it.
+    let cached = if no_cache {
+        None
+    } else {
+        data::read_contract_instance(&contract, &network.network_passphrase)?
+    };
+    let instance = if let Some(instance) = cached {
+        instance
+    } else {
+        let instance = get_contract_instance(&client, contract_id).await?;
+        if !no_cache {
+            data::write_contract_instance(&contract, &network.network_passphrase, &instance)?;
+        }
+        instance
     };
 
     // Get the contract spec entries based on the executable type
-    Ok(match executable {
-        ContractExecutable::Wasm(hash) => {
-            let hash_str = hash.to_string();
-            if let Ok(entries) = data::read_spec(&hash_str) {
+    Ok(match instance.wasm_hash {
+        Some(hash_str) => {
+            let cached = match function {
+                Some(function) => data::read_function_spec(&hash_str, |name| {
+                    name == function || name.to_kebab_case() == function
+                }),
+                None => data::read_spec(&hash_str),
+            };
+            if let Ok(entries) = cached {
                 entries
             } else {
-                let raw_wasm = client.get_remote_wasm_from_hash(hash).await?;
-                let res = contract_spec::Spec::new(&raw_wasm)?;
-                let res = res.spec;
-                if global_args.map_or(true, |a| !a.no_cache) {
+                let raw_wasm = client.get_remote_wasm_from_hash(hash_str.parse()?).await?;
+                // Only the spec section is decoded, the meta sections are not needed.
+                let res = contract_spec::Sections::new(&raw_wasm)?
+                    .spec_entries()
+                    .collect::<Result<Vec<_>, _>>()?;
+                if !no_cache {
                     data::write_spec(&hash_str, &res)?;
                 }
                 res
             }
         }
-        ContractExecutable::StellarAsset => {
-            soroban_spec::read::parse_raw(&soroban_sdk::token::StellarAssetSpec::spec_xdr())?
-        }
+        None => soroban_spec::read::parse_raw(&soroban_sdk::token::StellarAssetSpec::spec_xdr())?,
     })
 }
+
+/// Drops the cached wasm hash of a contract, so that the next lookup fetches its instance again.
+///
+/// # Errors
+pub fn invalidate_contract_instance(
+    contract_id: &[u8; 32],
+    network_passphrase: &str,
+) -> Result<(), Error> {
+    let contract = stellar_strkey::Contract(*contract_id).to_string();
+    Ok(data::remove_contract_instance(
+        &contract,
+        network_passphrase,
+    )?)
+}
+
+async fn get_contract_instance(
+    client: &rpc::Client,
+    contract_id: &[u8; 32],
+) -> Result<data::ContractInstance, Error> {
+    let key = LedgerKey::ContractData(LedgerKeyContractData {
+        contract: ScAddress::Contract(Hash(*contract_id)),
+        key: ScVal::LedgerKeyContractInstance,
+        durability: ContractDataDurability::Persistent,
+    });
+    let r = client.get_full_ledger_entries(&[key]).await?;
+    tracing::trace!("{r:?}");
+    let Some(rpc::FullLedgerEntry {
+        val:
+            LedgerEntryData::ContractData(ContractDataEntry {
+                val: ScVal::ContractInstance(ScContractInstance { executable, .. }),
+                ..
+            }),
+        live_until_ledger_seq,
+        ..
+    }) = r.entries.into_iter().next()
+    else {
+        return Err(Error::MissingResult);
+    };
+    let wasm_hash = match executable {
+        ContractExecutable::Wasm(hash) => Some(hash.to_string()),
+        ContractExecutable::StellarAsset => None,
+    };
+    Ok(data::ContractInstance::new(
+        wasm_hash,
+        live_until_ledger_seq,
+        u32::try_from(r.latest_ledger).unwrap_or_default(),
+    ))
+}
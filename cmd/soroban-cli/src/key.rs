@@ -3,7 +3,11 @@ use soroban_env_host::xdr::{
     self, LedgerKey, LedgerKeyContractCode, LedgerKeyContractData, Limits, ReadXdr, ScAddress,
     ScVal,
 };
-use std::path::PathBuf;
+use std::{
+    fs::File,
+    io::{self, BufRead, BufReader},
+    path::{Path, PathBuf},
+};
 use stellar_strkey::Contract;
 
 use crate::{commands::contract::Durability, wasm};
@@ -18,6 +22,10 @@ pub enum Error {
     CannotParseContractId(String, stellar_strkey::DecodeError),
     #[error(transparent)]
     Wasm(#[from] wasm::Error),
+    #[error("reading key file {path}: {error}")]
+    CannotReadKeyFile { path: PathBuf, error: io::Error },
+    #[error("parsing XDR key {key}: {error}")]
+    CannotParseXdrKey { key: String, error: xdr::Error },
 }
 
 #[derive(Debug, clap::Args, Clone)]
@@ -90,13 +98,52 @@ impl Args {
 
         Ok(keys
             .into_iter()
-            .map(|key| {
-                LedgerKey::ContractData(LedgerKeyContractData {
-                    contract: ScAddress::Contract(xdr::Hash(contract.0)),
-                    durability: (&self.durability).into(),
-                    key,
-                })
-            })
+            .map(|key| self.contract_data_key(&contract, key))
             .collect())
     }
+
+    /// The ledger key of the contract data entry stored under `key`, with this durability.
+    pub fn contract_data_key(&self, contract: &Contract, key: ScVal) -> LedgerKey {
+        LedgerKey::ContractData(LedgerKeyContractData {
+            contract: ScAddress::Contract(xdr::Hash(contract.0)),
+            durability: (&self.durability).into(),
+            key,
+        })
+    }
+}
+
+/// Reads storage keys (base64-encoded XDR), one per line, from `path`, or from stdin if it is
+/// `-`. Keys are parsed as they are iterated, and blank lines are skipped.
+pub fn read_key_file(path: &Path) -> Result<impl Iterator<Item = Result<ScVal, Error>>, Error> {
+    let path = path.to_path_buf();
+    let reader: Box<dyn BufRead + Send> = if path == Path::new("-") {
+        Box::new(BufReader::new(io::stdin()))
+    } else {
+        let file = File::open(&path).map_err(|error| Error::CannotReadKeyFile {
+            path: path.clone(),
+            error,
+        })?;
+        Box::new(BufReader::new(file))
+    };
+    Ok(reader.lines().filter_map(move |line| {
+        let line = match line {
+            Ok(line) => line,
+            Err(error) => {
+                return Some(Err(Error::CannotReadKeyFile {
+                    path: path.clone(),
+                    error,
+                }))
+            }
+        };
+        let key = line.trim();
+        if key.is_empty() {
+            return None;
+        }
+        Some(
+            ScVal::from_xdr_base64(key, Limits::none()).map_err(|error| Error::CannotParseXdrKey {
+                key: key.to_string(),
+                error,
+            }),
+        )
+    }))
 }
@@ -16,6 +16,7 @@ pub mod fee;
 pub mod get_spec;
 pub mod key;
 pub mod log;
+pub mod metrics;
 pub mod signer;
 pub mod toid;
 pub mod utils;
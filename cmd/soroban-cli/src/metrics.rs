@@ -0,0 +1,183 @@
+//! How long the phases of network commands took, and the resources of the transactions they
+//! sent, as simulated and as charged. Printed to stderr with `--metrics json` when the command
+//! finishes, whether or not it succeeded.
+
+use std::{
+    future::Future,
+    sync::{Mutex, MutexGuard, PoisonError},
+    time::{Duration, Instant},
+};
+
+use serde::Serialize;
+use tracing::Instrument;
+
+use crate::{
+    rpc::GetTransactionResponse,
+    xdr::{
+        SorobanTransactionData, SorobanTransactionMeta, SorobanTransactionMetaExt, Transaction,
+        TransactionExt, TransactionMeta,
+    },
+};
+
+#[derive(Clone, Copy, Debug, clap::ValueEnum)]
+pub enum Format {
+    Json,
+}
+
+static METRICS: Mutex<Metrics> = Mutex::new(Metrics {
+    phases: Vec::new(),
+    transactions: Vec::new(),
+});
+
+#[derive(Serialize, Debug)]
+#[serde(rename_all = "snake_case")]
+struct Metrics {
+    phases: Vec<Phase>,
+    transactions: Vec<Resources>,
+}
+
+#[derive(Serialize, Debug)]
+#[serde(rename_all = "snake_case")]
+struct Phase {
+    name: &'static str,
+    duration_ms: f64,
+}
+
+/// The resources of one transaction.
+#[derive(Serialize, Debug, Default)]
+#[serde(rename_all = "snake_case")]
+struct Resources {
+    simulated: Option<Simulated>,
+    /// Instructions the transaction was sent with, after any padding.
+    instructions: Option<u32>,
+    fee_charged: Option<i64>,
+    resource_fee_charged: Option<ResourceFeeCharged>,
+    #[serde(skip)]
+    sent: bool,
+}
+
+#[derive(Serialize, Debug)]
+#[serde(rename_all = "snake_case")]
+struct Simulated {
+    instructions: u32,
+    read_bytes: u32,
+    write_bytes: u32,
+    resource_fee: i64,
+}
+
+#[derive(Serialize, Debug)]
+#[serde(rename_all = "snake_case")]
+struct ResourceFeeCharged {
+    non_refundable: i64,
+    refundable: i64,
+    rent: i64,
+}
+
+fn metrics() -> MutexGuard<'static, Metrics> {
+    METRICS.lock().unwrap_or_else(PoisonError::into_inner)
+}
+
+/// Runs `fut` as the phase `name` of the command, in a span of the same name, recording how long
+/// it took.
+pub async fn phase<F: Future>(name: &'static str, fut: F) -> F::Output {
+    let start = Instant::now();
+    let out = fut.instrument(tracing::info_span!("phase", name)).await;
+    record_phase(name, start.elapsed());
+    out
+}
+
+/// Like [`phase`], for a phase that does not wait on the network.
+pub fn phase_sync<T>(name: &'static str, f: impl FnOnce() -> T) -> T {
+    let start = Instant::now();
+    let out = tracing::info_span!("phase", name).in_scope(f);
+    record_phase(name, start.elapsed());
+    out
+}
+
+fn record_phase(name: &'static str, elapsed: Duration) {
+    tracing::debug!(phase = name, ?elapsed);
+    metrics().phases.push(Phase {
+        name,
+        duration_ms: elapsed.as_secs_f64() * 1_000.0,
+    });
+}
+
+/// Records the resources of `tx` as simulated, starting the metrics of a new transaction.
+pub fn record_simulation(tx: &Transaction) {
+    let TransactionExt::V1(SorobanTransactionData {
+        resources,
+        resource_fee,
+        ..
+    }) = &tx.ext
+    else {
+        return;
+    };
+    metrics().transactions.push(Resources {
+        simulated: Some(Simulated {
+            instructions: resources.instructions,
+            read_bytes: resources.read_bytes,
+            write_bytes: resources.write_bytes,
+            resource_fee: *resource_fee,
+        }),
+        ..Default::default()
+    });
+}
+
+/// Records what was charged for `tx`, the last transaction sent, from its response `res`.
+pub fn record_result(tx: &Transaction, res: &GetTransactionResponse) {
+    let mut metrics = metrics();
+    // A transaction sent without being simulated first, as when an earlier simulation is reused,
+    // has no metrics of its own yet.
+    if metrics.transactions.last().map_or(true, |last| last.sent) {
+        metrics.transactions.push(Resources::default());
+    }
+    let resources = metrics.transactions.last_mut().unwrap();
+    resources.sent = true;
+    if let TransactionExt::V1(data) = &tx.ext {
+        resources.instructions = Some(data.resources.instructions);
+    }
+    resources.fee_charged = res.result.as_ref().map(|result| result.fee_charged);
+    if let Some(TransactionMeta::V3(meta)) = &res.result_meta {
+        if let Some(SorobanTransactionMeta {
+            ext: SorobanTransactionMetaExt::V1(ext),
+            ..
+        }) = &meta.soroban_meta
+        {
+            resources.resource_fee_charged = Some(ResourceFeeCharged {
+                non_refundable: ext.total_non_refundable_resource_fee_charged,
+                refundable: ext.total_refundable_resource_fee_charged,
+                rent: ext.rent_fee_charged,
+            });
+        }
+    }
+}
+
+/// Prints the metrics recorded so far to stderr.
+pub fn print(format: Format) {
+    let metrics = metrics();
+    match format {
+        Format::Json => match serde_json::to_string(&*metrics) {
+            Ok(json) => eprintln!("{json}"),
+            Err(e) => tracing::error!("cannot serialize metrics: {e}"),
+        },
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[tokio::test]
+    async fn records_phases_in_order() {
+        phase("first", async {}).await;
+        phase_sync("second", || ());
+        // Other tests may record phases of their own.
+        let names = metrics()
+            .phases
+            .iter()
+            .map(|p| p.name)
+            .filter(|name| ["first", "second"].contains(name))
+            .collect::<Vec<_>>();
+        assert_eq!(names, ["first", "second"]);
+    }
+}
@@ -1,11 +1,13 @@
-use ed25519_dalek::ed25519::signature::Signer;
+use std::{collections::HashMap, num::NonZeroUsize, thread};
+
+use ed25519_dalek::{ed25519::signature::Signer, SigningKey};
 use sha2::{Digest, Sha256};
 
 use soroban_env_host::xdr::{
-    self, AccountId, DecoratedSignature, Hash, HashIdPreimage, HashIdPreimageSorobanAuthorization,
-    InvokeHostFunctionOp, Limits, Operation, OperationBody, PublicKey, ScAddress, ScMap, ScSymbol,
-    ScVal, Signature, SignatureHint, SorobanAddressCredentials, SorobanAuthorizationEntry,
-    SorobanAuthorizedFunction, SorobanCredentials, Transaction, TransactionEnvelope,
+    self, AccountId, DecoratedSignature, EnvelopeType, Hash, InvokeHostFunctionOp, Limited, Limits,
+    Operation, OperationBody, PublicKey, ScAddress, ScMap, ScSymbol, ScVal, Signature,
+    SignatureHint, SorobanAddressCredentials, SorobanAuthorizationEntry, SorobanAuthorizedFunction,
+    SorobanAuthorizedInvocation, SorobanCredentials, Transaction, TransactionEnvelope,
     TransactionSignaturePayload, TransactionSignaturePayloadTaggedTransaction,
     TransactionV1Envelope, Uint256, WriteXdr,
 };
@@ -26,19 +28,94 @@ pub enum Error {
     Xdr(#[from] xdr::Error),
 }
 
-fn requires_auth(txn: &Transaction) -> Option<xdr::Operation> {
-    let [op @ Operation {
+/// Signing keys indexed by the public key they sign for.
+pub struct Signers<'a> {
+    keys: HashMap<[u8; 32], &'a SigningKey>,
+}
+
+impl<'a> Signers<'a> {
+    /// Indexes `source_key` and `signers`. When a key appears in both, the one in `signers` is
+    /// used.
+    pub fn new(source_key: &'a SigningKey, signers: &'a [SigningKey]) -> Self {
+        let keys = std::iter::once(source_key)
+            .chain(signers)
+            .map(|key| (key.verifying_key().to_bytes(), key))
+            .collect();
+        Self { keys }
+    }
+
+    fn get(&self, address: &ScAddress) -> Result<&'a SigningKey, Error> {
+        match address {
+            ScAddress::Account(AccountId(PublicKey::PublicKeyTypeEd25519(Uint256(a)))) => self
+                .keys
+                .get(a)
+                .copied()
+                .ok_or_else(|| Error::MissingSignerForAddress {
+                    address: stellar_strkey::Strkey::PublicKeyEd25519(
+                        stellar_strkey::ed25519::PublicKey(*a),
+                    )
+                    .to_string(),
+                }),
+            // This address is for a contract. This means we're using a custom smart-contract
+            // account. Currently the CLI doesn't support that yet.
+            ScAddress::Contract(Hash(c)) => Err(Error::MissingSignerForAddress {
+                address: stellar_strkey::Strkey::Contract(stellar_strkey::Contract(*c)).to_string(),
+            }),
+        }
+    }
+}
+
+/// An auth entry of a transaction, with the key it is to be signed with if it needs signing.
+type Pending<'a> = (SorobanAuthorizationEntry, Option<&'a SigningKey>);
+
+/// Takes the auth entries out of `tx`, pairing each with its signer. Returns `None` if the
+/// transaction does not invoke a contract function needing auth.
+fn take_auths<'a>(
+    tx: &mut Transaction,
+    signers: &Signers<'a>,
+) -> Result<Option<Vec<Pending<'a>>>, Error> {
+    let [Operation {
         body: OperationBody::InvokeHostFunction(InvokeHostFunctionOp { auth, .. }),
         ..
-    }] = txn.operations.as_slice()
+    }] = tx.operations.as_slice()
     else {
-        return None;
+        return Ok(None);
     };
-    matches!(
+    if !matches!(
         auth.first().map(|x| &x.root_invocation.function),
         Some(&SorobanAuthorizedFunction::ContractFn(_))
-    )
-    .then(move || op.clone())
+    ) {
+        return Ok(None);
+    }
+    let mut ops: Vec<Operation> = std::mem::take(&mut tx.operations).into();
+    let OperationBody::InvokeHostFunction(body) = &mut ops[0].body else {
+        unreachable!()
+    };
+    let pending = Vec::from(std::mem::take(&mut body.auth))
+        .into_iter()
+        .map(|auth| {
+            let signer = match &auth.credentials {
+                SorobanCredentials::Address(SorobanAddressCredentials { address, .. }) => {
+                    Some(signers.get(address)?)
+                }
+                // Doesn't need special signing
+                SorobanCredentials::SourceAccount => None,
+            };
+            Ok((auth, signer))
+        })
+        .collect::<Result<_, Error>>()?;
+    tx.operations = ops.try_into()?;
+    Ok(Some(pending))
+}
+
+/// Puts signed auth entries back into a transaction emptied by [`take_auths`].
+fn put_auths(tx: &mut Transaction, auths: Vec<SorobanAuthorizationEntry>) -> Result<(), Error> {
+    let mut ops: Vec<Operation> = std::mem::take(&mut tx.operations).into();
+    if let OperationBody::InvokeHostFunction(body) = &mut ops[0].body {
+        body.auth = auths.try_into()?;
+    }
+    tx.operations = ops.try_into()?;
+    Ok(())
 }
 
 // Use the given source_key and signers, to sign all SorobanAuthorizationEntry's in the given
@@ -50,111 +127,122 @@ pub fn sign_soroban_authorizations(
     signature_expiration_ledger: u32,
     network_passphrase: &str,
 ) -> Result<Option<Transaction>, Error> {
-    let mut tx = raw.clone();
-    let Some(mut op) = requires_auth(&tx) else {
-        return Ok(None);
-    };
-
-    let Operation {
-        body: OperationBody::InvokeHostFunction(ref mut body),
-        ..
-    } = op
-    else {
-        return Ok(None);
-    };
+    let signers = Signers::new(source_key, signers);
+    sign_soroban_authorizations_batch(
+        [(raw, &signers)],
+        signature_expiration_ledger,
+        network_passphrase,
+    )
+    .pop()
+    .unwrap_or(Ok(None))
+}
 
+/// Signs the auth entries of many transactions at once, each with its own signers, spreading
+/// the signing of all their entries across threads. Returns, in order, the signed transaction,
+/// or `None` for transactions without auth entries to sign.
+pub fn sign_soroban_authorizations_batch<'a>(
+    txs: impl IntoIterator<Item = (&'a Transaction, &'a Signers<'a>)>,
+    signature_expiration_ledger: u32,
+    network_passphrase: &str,
+) -> Vec<Result<Option<Transaction>, Error>> {
     let network_id = Hash(Sha256::digest(network_passphrase.as_bytes()).into());
 
-    let verification_key = source_key.verifying_key();
-    let source_address = verification_key.as_bytes();
-
-    let signed_auths = body
-        .auth
-        .as_slice()
-        .iter()
-        .map(|raw_auth| {
-            let mut auth = raw_auth.clone();
-            let SorobanAuthorizationEntry {
-                credentials: SorobanCredentials::Address(ref mut credentials),
-                ..
-            } = auth
-            else {
-                // Doesn't need special signing
-                return Ok(auth);
-            };
-            let SorobanAddressCredentials { ref address, .. } = credentials;
-
-            // See if we have a signer for this authorizationEntry
-            // If not, then we Error
-            let needle = match address {
-                ScAddress::Account(AccountId(PublicKey::PublicKeyTypeEd25519(Uint256(ref a)))) => a,
-                ScAddress::Contract(Hash(c)) => {
-                    // This address is for a contract. This means we're using a custom
-                    // smart-contract account. Currently the CLI doesn't support that yet.
-                    return Err(Error::MissingSignerForAddress {
-                        address: stellar_strkey::Strkey::Contract(stellar_strkey::Contract(*c))
-                            .to_string(),
-                    });
-                }
-            };
-            let signer = if let Some(s) = signers
-                .iter()
-                .find(|s| needle == s.verifying_key().as_bytes())
-            {
-                s
-            } else if needle == source_address {
-                // This is the source address, so we can sign it
-                source_key
-            } else {
-                // We don't have a signer for this address
-                return Err(Error::MissingSignerForAddress {
-                    address: stellar_strkey::Strkey::PublicKeyEd25519(
-                        stellar_strkey::ed25519::PublicKey(*needle),
-                    )
-                    .to_string(),
-                });
-            };
+    let mut results = Vec::new();
+    let mut unsigned = Vec::new();
+    let mut pending = Vec::new();
+    for (raw, signers) in txs {
+        let mut tx = raw.clone();
+        match take_auths(&mut tx, signers) {
+            Ok(Some(auths)) => {
+                unsigned.push((results.len(), tx, auths.len()));
+                pending.extend(auths);
+                results.push(Ok(None));
+            }
+            res => results.push(res.map(|_| None)),
+        }
+    }
 
-            sign_soroban_authorization_entry(
-                raw_auth,
-                signer,
-                signature_expiration_ledger,
-                &network_id,
-            )
-        })
-        .collect::<Result<Vec<_>, Error>>()?;
+    let signed = sign_all(&mut pending, signature_expiration_ledger, &network_id);
+    let mut entries = pending.into_iter().map(|(auth, _)| auth).zip(signed);
+    for (i, mut tx, count) in unsigned {
+        // Every entry of the transaction is taken, even after a failed one, so the next
+        // transaction starts at its own entries.
+        let res = entries
+            .by_ref()
+            .take(count)
+            .map(|(auth, signed)| signed.map(|()| auth))
+            .collect::<Vec<_>>()
+            .into_iter()
+            .collect::<Result<Vec<_>, Error>>()
+            .and_then(|auths| put_auths(&mut tx, auths));
+        results[i] = res.map(|()| Some(tx));
+    }
+    results
+}
 
-    body.auth = signed_auths.try_into()?;
-    tx.operations = vec![op].try_into()?;
-    Ok(Some(tx))
+/// Entries signed by each thread, below which spawning another is not worth it.
+const MIN_ENTRIES_PER_THREAD: usize = 8;
+
+/// Signs every pending entry in place, returning the outcome of each.
+fn sign_all(
+    pending: &mut [Pending<'_>],
+    signature_expiration_ledger: u32,
+    network_id: &Hash,
+) -> Vec<Result<(), Error>> {
+    let sign = |pending: &mut [Pending<'_>]| {
+        pending
+            .iter_mut()
+            .map(|(auth, signer)| match signer {
+                Some(signer) => sign_soroban_authorization_entry(
+                    auth,
+                    *signer,
+                    signature_expiration_ledger,
+                    network_id,
+                ),
+                None => Ok(()),
+            })
+            .collect::<Vec<_>>()
+    };
+    let threads = thread::available_parallelism()
+        .map_or(1, NonZeroUsize::get)
+        .min(pending.len() / MIN_ENTRIES_PER_THREAD);
+    if threads <= 1 {
+        return sign(pending);
+    }
+    let chunk_size = pending.len().div_ceil(threads);
+    thread::scope(|s| {
+        let workers = pending
+            .chunks_mut(chunk_size)
+            .map(|chunk| s.spawn(move || sign(chunk)))
+            .collect::<Vec<_>>();
+        workers
+            .into_iter()
+            .flat_map(|worker| worker.join().expect("signing thread panicked"))
+            .collect()
+    })
 }
 
 fn sign_soroban_authorization_entry(
-    raw: &SorobanAuthorizationEntry,
+    auth: &mut SorobanAuthorizationEntry,
     signer: &ed25519_dalek::SigningKey,
     signature_expiration_ledger: u32,
     network_id: &Hash,
-) -> Result<SorobanAuthorizationEntry, Error> {
-    let mut auth = raw.clone();
+) -> Result<(), Error> {
     let SorobanAuthorizationEntry {
-        credentials: SorobanCredentials::Address(ref mut credentials),
-        ..
+        credentials: SorobanCredentials::Address(credentials),
+        root_invocation,
     } = auth
     else {
         // Doesn't need special signing
-        return Ok(auth);
+        return Ok(());
     };
-    let SorobanAddressCredentials { nonce, .. } = credentials;
 
-    let preimage = HashIdPreimage::SorobanAuthorization(HashIdPreimageSorobanAuthorization {
-        network_id: network_id.clone(),
-        invocation: auth.root_invocation.clone(),
-        nonce: *nonce,
+    let payload = authorization_payload(
+        network_id,
+        credentials.nonce,
         signature_expiration_ledger,
-    })
-    .to_xdr(Limits::none())?;
-
-    let payload = Sha256::digest(preimage);
+        root_invocation,
+    )?;
     let signature = signer.sign(&payload);
 
     let map = ScMap::sorted_from(vec![
@@ -185,8 +273,25 @@ fn sign_soroban_authorization_entry(
         vec![ScVal::Map(Some(map))].try_into().map_err(Error::Xdr)?,
     ));
     credentials.signature_expiration_ledger = signature_expiration_ledger;
-    auth.credentials = SorobanCredentials::Address(credentials.clone());
-    Ok(auth)
+    Ok(())
+}
+
+/// The hash of the [`HashIdPreimage::SorobanAuthorization`] preimage, as signed by an auth
+/// entry's signer. The preimage is streamed into the hasher, so the invocation tree is neither
+/// cloned nor buffered.
+fn authorization_payload(
+    network_id: &Hash,
+    nonce: i64,
+    signature_expiration_ledger: u32,
+    invocation: &SorobanAuthorizedInvocation,
+) -> Result<[u8; 32], Error> {
+    let mut hasher = Limited::new(Sha256::new(), Limits::none());
+    EnvelopeType::SorobanAuthorization.write_xdr(&mut hasher)?;
+    network_id.write_xdr(&mut hasher)?;
+    nonce.write_xdr(&mut hasher)?;
+    signature_expiration_ledger.write_xdr(&mut hasher)?;
+    invocation.write_xdr(&mut hasher)?;
+    Ok(hasher.inner.finalize().into())
 }
 
 pub fn sign_tx(
@@ -215,3 +320,37 @@ pub fn hash(tx: &Transaction, network_passphrase: &str) -> Result<[u8; 32], xdr:
     };
     Ok(Sha256::digest(signature_payload.to_xdr(Limits::none())?).into())
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use soroban_env_host::xdr::{
+        HashIdPreimage, HashIdPreimageSorobanAuthorization, InvokeContractArgs, VecM,
+    };
+
+    #[test]
+    fn authorization_payload_matches_preimage_hash() {
+        let network_id = Hash(Sha256::digest(b"Test SDF Network ; September 2015").into());
+        let invocation = SorobanAuthorizedInvocation {
+            function: SorobanAuthorizedFunction::ContractFn(InvokeContractArgs {
+                contract_address: ScAddress::Contract(Hash([1; 32])),
+                function_name: ScSymbol("transfer".try_into().unwrap()),
+                args: vec![ScVal::U32(7)].try_into().unwrap(),
+            }),
+            sub_invocations: VecM::default(),
+        };
+        let preimage = HashIdPreimage::SorobanAuthorization(HashIdPreimageSorobanAuthorization {
+            network_id: network_id.clone(),
+            nonce: -42,
+            signature_expiration_ledger: 1000,
+            invocation: invocation.clone(),
+        })
+        .to_xdr(Limits::none())
+        .unwrap();
+        let expected: [u8; 32] = Sha256::digest(preimage).into();
+        assert_eq!(
+            authorization_payload(&network_id, -42, 1000, &invocation).unwrap(),
+            expected
+        );
+    }
+}
@@ -1,14 +1,14 @@
 use clap::arg;
+use memmap2::Mmap;
 use sha2::{Digest, Sha256};
-use soroban_env_host::xdr::{self, Hash, LedgerKey, LedgerKeyContractCode};
+use soroban_env_host::xdr::{self, Hash, LedgerKey, LedgerKeyContractCode, ScSpecEntry};
 use soroban_spec_tools::contract::{self, Spec};
 use std::{
     fs, io,
+    ops::Deref,
     path::{Path, PathBuf},
 };
 
-use crate::utils::{self};
-
 #[derive(thiserror::Error, Debug)]
 pub enum Error {
     #[error("reading file {filepath}: {error}")]
@@ -48,6 +48,28 @@ impl Args {
         })
     }
 
+    /// Maps the wasm file into memory, so that it can be hashed, parsed and uploaded without
+    /// reading or copying it more than once.
+    ///
+    /// # Errors
+    /// May fail to read wasm file
+    pub fn load(&self) -> Result<Loaded, Error> {
+        let error = |error| Error::CannotReadContractFile {
+            filepath: self.wasm.clone(),
+            error,
+        };
+        let file = fs::File::open(&self.wasm).map_err(error)?;
+        // An empty file cannot be mapped, and has nothing to share anyway.
+        let map = if file.metadata().map_err(error)?.len() == 0 {
+            None
+        } else {
+            // SAFETY: the mapping is only read, for the duration of a single command, and wasm
+            // files are not expected to be rewritten while they are being uploaded.
+            Some(unsafe { Mmap::map(&file) }.map_err(error)?)
+        };
+        Ok(Loaded { map })
+    }
+
     /// # Errors
     /// May fail to read wasm file
     pub fn len(&self) -> Result<u64, Error> {
@@ -63,12 +85,52 @@ impl Args {
     /// # Errors
     /// May fail to read wasm file or parse xdr section
     pub fn parse(&self) -> Result<Spec, Error> {
-        let contents = self.read()?;
-        Ok(Spec::new(&contents)?)
+        self.load()?.parse()
+    }
+
+    /// # Errors
+    /// May fail to read wasm file or parse xdr section
+    pub fn spec_entries(&self) -> Result<Vec<ScSpecEntry>, Error> {
+        self.load()?.spec_entries()
     }
 
     pub fn hash(&self) -> Result<Hash, Error> {
-        Ok(Hash(Sha256::digest(self.read()?).into()))
+        Ok(self.load()?.hash())
+    }
+}
+
+/// The contents of a wasm file, memory mapped by [`Args::load`].
+pub struct Loaded {
+    map: Option<Mmap>,
+}
+
+impl Loaded {
+    pub fn hash(&self) -> Hash {
+        Hash(Sha256::digest(&**self).into())
+    }
+
+    /// # Errors
+    /// May fail to parse xdr section
+    pub fn parse(&self) -> Result<Spec, Error> {
+        Ok(Spec::new(self)?)
+    }
+
+    /// Decodes only the spec entries, skipping the meta sections that [`Loaded::parse`] decodes
+    /// too.
+    ///
+    /// # Errors
+    /// May fail to parse xdr section
+    pub fn spec_entries(&self) -> Result<Vec<ScSpecEntry>, Error> {
+        Ok(contract::Sections::new(self)?
+            .spec_entries()
+            .collect::<Result<_, _>>()?)
+    }
+}
+
+impl Deref for Loaded {
+    type Target = [u8];
+    fn deref(&self) -> &[u8] {
+        self.map.as_deref().unwrap_or_default()
     }
 }
 
@@ -82,7 +144,7 @@ impl TryInto<LedgerKey> for Args {
     type Error = Error;
     fn try_into(self) -> Result<LedgerKey, Self::Error> {
         Ok(LedgerKey::ContractCode(LedgerKeyContractCode {
-            hash: utils::contract_hash(&self.read()?)?,
+            hash: self.hash()?,
         }))
     }
 }